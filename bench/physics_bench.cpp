@@ -0,0 +1,791 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fluid_manager.hpp"
+#include "particle_manager.hpp"
+#include "physics_manager.hpp"
+#include "profiler.hpp"
+#include "recorder.hpp"
+#include "restraint.hpp"
+#include "snapshot.hpp"
+#include "world_batch.hpp"
+
+using namespace epi;
+
+/*
+* headless benchmark running reproducible, seeded stress scenarios
+* usage: physics_bench [--scenario name|all] [--bodies N] [--frames N] [--warmup N] [--substeps N] [--seed N] [--format csv|json] [--trace file]
+*                      [--save-snapshot file] [--load-snapshot file] [--rollback N] [--record file] [--replay file]
+*                      [--batch N] [--threads N]
+*/
+
+//seeded generator that gives the same sequence with every standard library
+class BenchRandom {
+    std::mt19937 _engine;
+public:
+    //returns float in range from low to high
+    float Random(float low, float high) {
+        return low + (high - low) * (float)(_engine() >> 8) / 16777216.f;
+    }
+    //returns int in range from low to high - 1
+    int Random(int low, int high) {
+        return low + (int)(_engine() % (uint32_t)(high - low));
+    }
+    BenchRandom(unsigned int seed) : _engine(seed) {}
+};
+class BenchObject {
+public:
+    std::unique_ptr<Transform> transform;
+    std::unique_ptr<Collider> collider;
+    std::unique_ptr<Rigidbody> rigidbody;
+    std::unique_ptr<Material> material;
+    RigidbodyHandle handle;
+    RigidManifold getManifold() const {
+        return {transform.get(), collider.get(), rigidbody.get(), material.get()};
+    }
+    BenchObject(Polygon poly) {
+        transform = std::make_unique<Transform>();
+        transform->setPos(poly.getPos());
+        transform->setRot(poly.getRot());
+        collider = std::make_unique<Collider>(poly);
+        rigidbody = std::make_unique<Rigidbody>();
+        material = std::make_unique<Material>();
+    }
+    BenchObject(Circle circ) {
+        transform = std::make_unique<Transform>();
+        transform->setPos(circ.pos);
+        collider = std::make_unique<Collider>(circ);
+        rigidbody = std::make_unique<Rigidbody>();
+        material = std::make_unique<Material>();
+    }
+    BenchObject(Compound compound) {
+        transform = std::make_unique<Transform>();
+        transform->setPos(compound.getPos());
+        collider = std::make_unique<Collider>(std::move(compound));
+        rigidbody = std::make_unique<Rigidbody>();
+        material = std::make_unique<Material>();
+    }
+    BenchObject(Chain chain) {
+        transform = std::make_unique<Transform>();
+        collider = std::make_unique<Collider>(std::move(chain));
+        rigidbody = std::make_unique<Rigidbody>();
+        rigidbody->isStatic = true;
+        material = std::make_unique<Material>();
+    }
+};
+struct BenchWorld {
+    PhysicsManager manager;
+    std::vector<std::unique_ptr<BenchObject>> objects;
+    std::vector<std::unique_ptr<Restraint>> restraints;
+    std::vector<std::unique_ptr<Transform>> anchors;
+    std::unique_ptr<SnapshotWorld> snapshot;
+    std::unique_ptr<ParticleManager> particles;
+    std::unique_ptr<FluidManager> fluid;
+    BenchRandom rng;
+    AABB bounds;
+
+    BenchObject& add(BenchObject* obj) {
+        objects.push_back(std::unique_ptr<BenchObject>(obj));
+        obj->handle = manager.add(obj->getManifold());
+        return *obj;
+    }
+    void add(Restraint* res) {
+        restraints.push_back(std::unique_ptr<Restraint>(res));
+        manager.add(res);
+    }
+    //same walls as ADD_SIDE in the demo's onSetup
+    void addBox(AABB sim_window) {
+        auto aabb_outer = sim_window;
+        auto aabb_inner = sim_window;
+        static const float padding = 80.f;
+        aabb_inner.setSize(aabb_inner.size() - vec2f(padding * 2.f, padding * 2.f));
+        aabb_outer.setSize(aabb_outer.size() - vec2f(padding, padding));
+        auto add_side = [&](vec2f a_in, vec2f b_in, vec2f b_out, vec2f a_out) {
+            auto& obj = add(new BenchObject(Polygon::CreateFromPoints({a_in, b_in, b_out, a_out})));
+            obj.rigidbody->isStatic = true;
+            obj.collider->tag.add("ground");
+        };
+        auto& in = aabb_inner;
+        auto& out = aabb_outer;
+        add_side({in.min.x, in.min.y}, {in.min.x, in.max.y}, {out.min.x, out.max.y}, {out.min.x, out.min.y});
+        add_side({in.max.x, in.min.y}, {in.min.x, in.min.y}, {out.min.x, out.min.y}, {out.max.x, out.min.y});
+        add_side({in.max.x, in.max.y}, {in.min.x, in.max.y}, {out.min.x, out.max.y}, {out.max.x, out.max.y});
+        add_side({in.max.x, in.max.y}, {in.max.x, in.min.y}, {out.max.x, out.min.y}, {out.max.x, out.max.y});
+        bounds = aabb_inner;
+    }
+    BenchWorld(unsigned int seed) : manager(AABB::CreateMinMax({0, 0}, {1, 1})), rng(seed) {
+        manager.steps = 5;
+        manager.gravity = vec2f(0.f, 1000.f);
+        manager.bounciness_select = PhysicsManager::eSelectMode::Max;
+        manager.friction_select = PhysicsManager::eSelectMode::Max;
+    }
+};
+
+static const float DEFAULT_RADIUS = 25.f;
+
+//side of the demo like box big enough to hold count bodies of default radius
+static float boxSideFor(size_t count) {
+    return std::max(800.f, std::sqrt((float)count) * DEFAULT_RADIUS * 2.f * 1.8f + 160.f);
+}
+static void spawnCircleAtTop(BenchWorld& world) {
+    float r = DEFAULT_RADIUS * world.rng.Random(1.f, 1.1f);
+    float x = world.rng.Random(world.bounds.min.x + r, world.bounds.max.x - r);
+    float y = world.bounds.min.y + world.rng.Random(r, r * 4.f);
+    world.add(new BenchObject(Circle(vec2f(x, y), r)));
+}
+
+struct Scenario {
+    const char* name;
+    std::function<void(BenchWorld&, size_t)> setup;
+    //called before every frame, including warmup ones
+    std::function<void(BenchWorld&, size_t)> onFrame;
+};
+
+//circles poured into the box over time, like flowing.gif
+static Scenario circleRain() {
+    auto target = std::make_shared<size_t>(0);
+    return {"circle_rain",
+        [=](BenchWorld& world, size_t count) {
+            *target = count;
+            world.addBox(AABB::CreateMinSize({0, 0}, vec2f(1.f, 1.f) * boxSideFor(count)));
+        },
+        [=](BenchWorld& world, size_t frame) {
+            size_t spawned = world.objects.size() - 4;
+            size_t per_frame = std::max<size_t>(1, *target / 60);
+            for(size_t i = 0; i < per_frame && spawned < *target; i++, spawned++)
+                spawnCircleAtTop(world);
+        }};
+}
+//tall pyramid of square polygons resting on static ground
+static Scenario polygonPyramid() {
+    return {"polygon_pyramid",
+        [](BenchWorld& world, size_t count) {
+            size_t base = 1;
+            while(base * (base + 1) / 2 < count)
+                base++;
+            const float side = 40.f;
+            const float gap = 1.f;
+            float width = base * (side + gap);
+            auto ground = AABB::CreateMinSize({-100.f, 0.f}, {width + 200.f, 50.f});
+            auto& g = world.add(new BenchObject(Polygon::CreateFromAABB(ground)));
+            g.rigidbody->isStatic = true;
+            size_t placed = 0;
+            for(size_t row = 0; row < base && placed < count; row++) {
+                size_t in_row = base - row;
+                float start_x = row * (side + gap) / 2.f;
+                for(size_t i = 0; i < in_row && placed < count; i++, placed++) {
+                    vec2f min(start_x + i * (side + gap), -(float)(row + 1) * (side + gap));
+                    world.add(new BenchObject(Polygon::CreateFromAABB(AABB::CreateMinSize(min, {side, side}))));
+                }
+            }
+        }, nullptr};
+}
+//circles and regular polygons piled inside the demo's box
+static Scenario mixedPile() {
+    return {"mixed_pile",
+        [](BenchWorld& world, size_t count) {
+            world.addBox(AABB::CreateMinSize({0, 0}, vec2f(1.f, 1.f) * boxSideFor(count)));
+            float cell = DEFAULT_RADIUS * 2.f * 1.5f;
+            size_t columns = std::max<size_t>(1, (size_t)((world.bounds.size().x - cell) / cell));
+            for(size_t i = 0; i < count; i++) {
+                vec2f pos = world.bounds.min + vec2f(cell * (0.5f + (float)(i % columns)), cell * (0.5f + (float)(i / columns)));
+                pos.x += world.rng.Random(-2.f, 2.f);
+                float r = DEFAULT_RADIUS * world.rng.Random(1.f, 1.1f);
+                if(i % 2 == 0) {
+                    world.add(new BenchObject(Circle(pos, r)));
+                } else {
+                    int side_count = world.rng.Random(4, 6);
+                    world.add(new BenchObject(Polygon::CreateRegular(pos, fEPI_PI / side_count, (size_t)side_count, r * std::sqrt(2.f))));
+                }
+            }
+        }, nullptr};
+}
+//mixed pile falling through a grid of static sensor zones, one zone for every two bodies, zones are only tested for overlap
+static Scenario sensorZones() {
+    return {"sensor_zones",
+        [](BenchWorld& world, size_t count) {
+            mixedPile().setup(world, count);
+            size_t zones = std::max<size_t>(1, count / 2);
+            size_t columns = std::max<size_t>(1, (size_t)std::sqrt((float)zones));
+            size_t rows = (zones + columns - 1) / columns;
+            vec2f cell(world.bounds.size().x / (float)columns, world.bounds.size().y / (float)rows);
+            for(size_t i = 0; i < zones; i++) {
+                vec2f center = world.bounds.min + vec2f(cell.x * (0.5f + (float)(i % columns)), cell.y * (0.5f + (float)(i / columns)));
+                auto& zone = world.add(new BenchObject(Polygon::CreateFromAABB(AABB::CreateCenterSize(center, cell * 0.8f))));
+                zone.rigidbody->isStatic = true;
+                zone.collider->isTrigger = true;
+            }
+        }, nullptr};
+}
+//pile of concave L and U shaped bodies, each one split into convex children of a single compound collider
+static Scenario compoundPile() {
+    return {"compound_pile",
+        [](BenchWorld& world, size_t count) {
+            world.addBox(AABB::CreateMinSize({0, 0}, vec2f(1.f, 1.f) * boxSideFor(count * 2)));
+            const float s = DEFAULT_RADIUS;
+            const std::vector<vec2f> shapes[2] = {
+                {{-s, -s}, {0.f, -s}, {0.f, 0.f}, {s, 0.f}, {s, s}, {-s, s}},
+                {{-s, -s}, {-s * 0.4f, -s}, {-s * 0.4f, s * 0.4f}, {s * 0.4f, s * 0.4f}, {s * 0.4f, -s}, {s, -s}, {s, s}, {-s, s}},
+            };
+            float cell = s * 2.f * 1.5f;
+            size_t columns = std::max<size_t>(1, (size_t)((world.bounds.size().x - cell) / cell));
+            for(size_t i = 0; i < count; i++) {
+                vec2f pos = world.bounds.min + vec2f(cell * (0.5f + (float)(i % columns)), cell * (0.5f + (float)(i / columns)));
+                pos.x += world.rng.Random(-2.f, 2.f);
+                std::vector<vec2f> outline = shapes[i % 2];
+                for(auto& p : outline)
+                    p += pos;
+                world.add(new BenchObject(Compound::CreateFromOutline(outline)));
+            }
+        }, nullptr};
+}
+//chains of circles linked with restraints, hanging from fixed anchors
+static Scenario restraintChains() {
+    return {"restraint_chains",
+        [](BenchWorld& world, size_t count) {
+            const size_t links = 20;
+            const float r = 10.f;
+            size_t chains = std::max<size_t>(1, count / links);
+            world.addBox(AABB::CreateMinSize({0, 0}, vec2f(1.f, 1.f) * std::max(boxSideFor(count), links * r * 4.f + 400.f)));
+            float spacing = world.bounds.size().x / (float)(chains + 1);
+            for(size_t c = 0; c < chains; c++) {
+                vec2f anchor_pos = world.bounds.min + vec2f(spacing * (float)(c + 1), 20.f);
+                world.anchors.push_back(std::make_unique<Transform>());
+                world.anchors.back()->setPos(anchor_pos);
+                BenchObject* prev = nullptr;
+                for(size_t l = 0; l < links; l++) {
+                    //chains start horizontal so that they swing
+                    auto& link = world.add(new BenchObject(Circle(anchor_pos + vec2f(r * 2.f * (float)(l + 1), 0.f), r)));
+                    if(prev) {
+                        world.add(new RestraintRigidRigid(prev->getManifold(), vec2f(r, 0.f), link.getManifold(), vec2f(-r, 0.f)));
+                    } else {
+                        world.add(new RestraintPointTrans(link.getManifold(), vec2f(-r, 0.f), world.anchors.back().get(), vec2f()));
+                    }
+                    prev = &link;
+                }
+            }
+        }, nullptr};
+}
+//big field of settled bodies with an occasional body dropped next to it
+//drops fall into a lane walled off from the field, landing on the field would link its columns into one island that never sleeps
+static Scenario sleepingField() {
+    static const float LANE_WIDTH = DEFAULT_RADIUS * 2.f * 12.f;
+    static const float WALL_WIDTH = DEFAULT_RADIUS * 4.f;
+    static const size_t MAX_DROPS = 150;
+    static const size_t COLUMN_HEIGHT = 8;
+    return {"sleeping_field",
+        [](BenchWorld& world, size_t count) {
+            float cell = DEFAULT_RADIUS * 2.f + 1.f;
+            //columns stand apart, each one is its own island, and are kept low as taller stacks of circles topple
+            size_t columns = std::max<size_t>(1, (count + COLUMN_HEIGHT - 1) / COLUMN_HEIGHT);
+            float width = cell * (float)columns;
+            world.addBox(AABB::CreateMinSize({0, 0}, {width + WALL_WIDTH + LANE_WIDTH + 160.f, cell * (float)(COLUMN_HEIGHT + 1) * 3.f + 160.f}));
+            float wall_x = world.bounds.min.x + width;
+            auto& wall = world.add(new BenchObject(Polygon::CreateFromPoints({{wall_x, world.bounds.min.y}, {wall_x + WALL_WIDTH, world.bounds.min.y},
+                {wall_x + WALL_WIDTH, world.bounds.max.y}, {wall_x, world.bounds.max.y}})));
+            wall.rigidbody->isStatic = true;
+            wall.collider->tag.add("ground");
+            for(size_t i = 0; i < count; i++) {
+                vec2f pos(world.bounds.min.x + cell * (0.5f + (float)(i % columns)), world.bounds.max.y - cell * (0.5f + (float)(i / columns)));
+                world.add(new BenchObject(Circle(pos, DEFAULT_RADIUS)));
+            }
+        },
+        [](BenchWorld& world, size_t frame) {
+            if(frame % 10 != 0)
+                return;
+            float r = DEFAULT_RADIUS * world.rng.Random(1.f, 1.1f);
+            float x = world.rng.Random(world.bounds.max.x - LANE_WIDTH + r, world.bounds.max.x - r);
+            float y = world.bounds.min.y + world.rng.Random(r, r * 4.f);
+            //once the lane holds MAX_DROPS, the oldest drop is replaced, so that long runs never fill it over the wall
+            size_t dropped = frame / 10;
+            if(dropped < MAX_DROPS) {
+                world.add(new BenchObject(Circle(vec2f(x, y), r)));
+                return;
+            }
+            auto& drop = world.objects[world.objects.size() - MAX_DROPS + dropped % MAX_DROPS];
+            world.manager.remove(drop->handle);
+            drop.reset(new BenchObject(Circle(vec2f(x, y), r)));
+            drop->handle = world.manager.add(drop->getManifold());
+        }};
+}
+//galton board of count static pegs with small balls dropped through it, pegs should cost nothing per frame
+static Scenario staticLevel() {
+    static const float PEG_SPACING = 40.f;
+    static const float BALL_RADIUS = 8.f;
+    static auto drop_ball = [](BenchWorld& world) {
+        float x = world.rng.Random(world.bounds.min.x + BALL_RADIUS, world.bounds.max.x - BALL_RADIUS);
+        world.add(new BenchObject(Circle(vec2f(x, world.bounds.min.y + BALL_RADIUS), BALL_RADIUS)));
+    };
+    return {"static_level",
+        [](BenchWorld& world, size_t count) {
+            size_t columns = std::max<size_t>(1, (size_t)std::sqrt((float)count));
+            float side = PEG_SPACING * (float)(columns + 2) + 160.f;
+            world.addBox(AABB::CreateMinSize({0, 0}, {side, side}));
+            for(size_t i = 0; i < count; i++) {
+                size_t row = i / columns;
+                float offset = row % 2 == 0 ? 0.5f : 1.f;
+                vec2f pos(world.bounds.min.x + PEG_SPACING * (offset + (float)(i % columns)), world.bounds.min.y + PEG_SPACING * (1.f + (float)row));
+                auto& peg = world.add(new BenchObject(Polygon::CreateFromAABB(AABB::CreateCenterSize(pos, {6.f, 6.f}))));
+                peg.rigidbody->isStatic = true;
+            }
+            for(size_t i = 0; i < 200; i++)
+                drop_ball(world);
+        },
+        [](BenchWorld& world, size_t frame) {
+            if(frame % 10 == 0)
+                drop_ball(world);
+        }};
+}
+//count bodies rolling and sliding down hills made of one chain collider with a segment every few pixels
+static Scenario chainTerrain() {
+    static const float SEGMENT_LENGTH = 8.f;
+    return {"chain_terrain",
+        [](BenchWorld& world, size_t count) {
+            world.addBox(AABB::CreateMinSize({0, 0}, vec2f(1.f, 1.f) * boxSideFor(count * 2)));
+            auto& area = world.bounds;
+            float ground = area.max.y - area.size().y / 4.f;
+            float amplitude = area.size().y / 8.f;
+            //drawn from left to right, so the free side is on top
+            std::vector<vec2f> points;
+            for(float x = area.min.x; x <= area.max.x; x += SEGMENT_LENGTH)
+                points.push_back({x, ground + amplitude * std::sin(x / 150.f) * std::sin(x / 470.f)});
+            world.add(new BenchObject(Chain(std::move(points))));
+            float cell = DEFAULT_RADIUS * 2.f * 1.5f;
+            size_t columns = std::max<size_t>(1, (size_t)((area.size().x - cell) / cell));
+            for(size_t i = 0; i < count; i++) {
+                vec2f pos = area.min + vec2f(cell * (0.5f + (float)(i % columns)), cell * (0.5f + (float)(i / columns)));
+                if(i % 2 == 0)
+                    world.add(new BenchObject(Circle(pos, DEFAULT_RADIUS)));
+                else
+                    world.add(new BenchObject(Polygon::CreateRegular(pos, fEPI_PI / 4.f, 4, DEFAULT_RADIUS * std::sqrt(2.f))));
+            }
+        }, nullptr};
+}
+//count bouncing particles sprayed over a small pile of bodies which they push around
+static Scenario particleSpray() {
+    return {"particle_spray",
+        [](BenchWorld& world, size_t count) {
+            const size_t bodies = 200;
+            world.addBox(AABB::CreateMinSize({0, 0}, vec2f(1.f, 1.f) * boxSideFor(bodies * 4)));
+            for(size_t i = 0; i < bodies; i++)
+                spawnCircleAtTop(world);
+            world.particles = std::make_unique<ParticleManager>();
+            world.particles->isTwoWay = true;
+            world.particles->reserve(count);
+            for(size_t i = 0; i < count; i++) {
+                vec2f pos(world.rng.Random(world.bounds.min.x, world.bounds.max.x), world.rng.Random(world.bounds.min.y, world.bounds.center().y));
+                vec2f vel(world.rng.Random(-500.f, 500.f), world.rng.Random(-500.f, 0.f));
+                world.particles->spawn(pos, vel);
+            }
+            world.manager.bind(world.particles.get());
+        }, nullptr};
+}
+//dam break of count fluid particles with a few bodies floating in it and a few sinking
+static Scenario fluidTank() {
+    return {"fluid_tank",
+        [](BenchWorld& world, size_t count) {
+            world.fluid = std::make_unique<FluidManager>();
+            float spacing = world.fluid->spacing;
+            float side = std::sqrt((float)count) * spacing;
+            world.addBox(AABB::CreateMinSize({0, 0}, vec2f(side * 2.f, side * 1.5f)));
+            world.fluid->reserve(count);
+            size_t columns = std::max<size_t>(1, (size_t)(side / spacing));
+            for(size_t i = 0; i < count; i++) {
+                vec2f pos(world.bounds.min.x + spacing * (0.5f + (float)(i % columns)), world.bounds.max.y - spacing * (0.5f + (float)(i / columns)));
+                world.fluid->spawn(pos);
+            }
+            //bodies half as dense as fluid alternate with bodies 2.5 times denser
+            for(size_t i = 0; i < 8; i++) {
+                auto& obj = world.add(new BenchObject(Circle(vec2f(world.bounds.max.x - side * (1.f - (0.5f + (float)(i % 4)) / 4.f), world.bounds.min.y + DEFAULT_RADIUS * 2.5f * (float)(i / 4 + 1)), DEFAULT_RADIUS)));
+                obj.rigidbody->mass = i % 2 == 0 ? 1.f : 5.f;
+            }
+            world.manager.bind(world.fluid.get());
+        }, nullptr};
+}
+//world loaded from snapshot file, load time is reported on stderr
+static Scenario snapshotScenario(std::string filename) {
+    return {"snapshot",
+        [=](BenchWorld& world, size_t count) {
+            auto start = std::chrono::steady_clock::now();
+            std::string error;
+            world.snapshot = loadSnapshot(filename, world.manager, &error);
+            if(!world.snapshot) {
+                std::cerr << "could not load snapshot " << filename << ": " << error << "\n";
+                std::exit(1);
+            }
+            std::cerr << "loaded " << world.snapshot->size() << " bodies from " << filename << " in "
+                << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms\n";
+        }, nullptr};
+}
+
+struct BenchOptions {
+    std::string scenario = "all";
+    size_t bodies = 1000;
+    size_t frames = 300;
+    size_t warmup = 120;
+    size_t substeps = 5;
+    unsigned int seed = 1337;
+    std::string format = "csv";
+    //chrome trace of the profiled zones is written here when not empty
+    std::string trace;
+    //world of the run scenario is saved here after its last frame
+    std::string save_snapshot;
+    //when set, world is loaded from this snapshot instead of being set up by a scenario
+    std::string load_snapshot;
+    //when not 0, N frames are simulated twice from a saved state after the run to check and time rollback
+    size_t rollback = 0;
+    //every change made to the world of the run scenario is logged here
+    std::string record;
+    //when set, recorded log is replayed instead of running scenarios
+    std::string replay;
+    //when not 0, scenario is set up once and N variations of it are simulated in parallel
+    size_t batch = 0;
+    //threads used by batch, 0 uses all hardware threads
+    size_t threads = 0;
+};
+struct BenchResult {
+    std::string scenario;
+    BenchOptions opts;
+    size_t final_bodies = 0;
+    double total_seconds = 0.0;
+    double body_steps = 0.0;
+    PhysicsStats sum;
+};
+
+static std::vector<vec2f> capturePositions(const PhysicsManager& manager) {
+    std::vector<vec2f> result;
+    for(auto& man : manager.getRigidbodies())
+        result.push_back(man.transform->getPos());
+    return result;
+}
+//positions of rigidbodies followed by positions of particles and fluid, which are part of saved states too
+static std::vector<vec2f> captureRollbackPositions(const BenchWorld& world) {
+    auto result = capturePositions(world.manager);
+    if(world.particles)
+        for(size_t i = 0; i < world.particles->size(); i++)
+            result.push_back(world.particles->getPos(i));
+    if(world.fluid)
+        for(size_t i = 0; i < world.fluid->size(); i++)
+            result.push_back(world.fluid->getPos(i));
+    return result;
+}
+//simulates frames twice from the same saved state, both runs have to end in exactly the same positions
+static void checkRollback(BenchWorld& world, size_t frames, float delT) {
+    typedef std::chrono::steady_clock clock;
+    WorldState state;
+    //first save allocates the buffers, second one shows the cost of reusing them
+    world.manager.saveState(state);
+    auto start = clock::now();
+    world.manager.saveState(state);
+    double save_us = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+    for(size_t i = 0; i < frames; i++)
+        world.manager.update(delT);
+    auto first = captureRollbackPositions(world);
+
+    start = clock::now();
+    bool restored = world.manager.restoreState(state);
+    double restore_us = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+    for(size_t i = 0; i < frames; i++)
+        world.manager.update(delT);
+    auto second = captureRollbackPositions(world);
+    //compared bitwise so that NaNs count as equal
+    bool matches = restored && first.size() == second.size() && std::memcmp(first.data(), second.data(), first.size() * sizeof(vec2f)) == 0;
+    std::cerr << "rollback of " << state.handles.size() << " bodies: save " << save_us << " us, restore " << restore_us
+        << " us, resimulation " << (matches ? "matches" : "DIFFERS") << "\n";
+}
+//FNV-1a of final positions, printed after recording and replaying so that both runs can be compared
+static uint64_t positionsChecksum(const PhysicsManager& manager) {
+    auto positions = capturePositions(manager);
+    uint64_t hash = 14695981039346656037ull;
+    auto bytes = reinterpret_cast<const unsigned char*>(positions.data());
+    for(size_t i = 0; i < positions.size() * sizeof(vec2f); i++)
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    return hash;
+}
+static void accumulate(BenchResult& result, const PhysicsStats& stats) {
+    result.total_seconds += stats.time_total;
+    result.body_steps += (double)stats.rigidbodies;
+    result.sum.rigidbodies += stats.rigidbodies;
+    result.sum.sleeping += stats.sleeping;
+    result.sum.broadphase_pairs += stats.broadphase_pairs;
+    result.sum.narrowphase_tests += stats.narrowphase_tests;
+    result.sum.contacts += stats.contacts;
+    result.sum.time_broadphase += stats.time_broadphase;
+    result.sum.time_narrowphase += stats.time_narrowphase;
+    result.sum.time_restraints += stats.time_restraints;
+    result.sum.time_integration += stats.time_integration;
+    result.sum.time_sleeping += stats.time_sleeping;
+    result.sum.time_triggers += stats.time_triggers;
+    result.sum.particles += stats.particles;
+    result.sum.time_particles += stats.time_particles;
+    result.sum.fluid_particles += stats.fluid_particles;
+    result.sum.time_fluid += stats.time_fluid;
+    result.sum.time_total += stats.time_total;
+}
+static BenchResult run(const Scenario& scenario, const BenchOptions& opts) {
+    //declared before the world so that it outlives its manager
+    Recorder recorder;
+    BenchWorld world(opts.seed);
+    world.manager.steps = opts.substeps;
+    if(opts.record.size() != 0) {
+        if(!recorder.open(opts.record)) {
+            std::cerr << "could not write recording: " << opts.record << "\n";
+            std::exit(1);
+        }
+        world.manager.setRecorder(&recorder);
+        //lets the replay report the first update that diverged
+        world.manager.hash_state = true;
+    }
+    scenario.setup(world, opts.bodies);
+
+    const float delT = 1.f / 60.f;
+    BenchResult result;
+    result.scenario = scenario.name;
+    result.opts = opts;
+    for(size_t frame = 0; frame < opts.warmup + opts.frames; frame++) {
+        if(scenario.onFrame)
+            scenario.onFrame(world, frame);
+        world.manager.update(delT);
+        EPI_PROFILE_FRAME();
+        if(frame >= opts.warmup)
+            accumulate(result, world.manager.getStats());
+    }
+    result.final_bodies = world.manager.getRigidbodyCount();
+    if(recorder.isOpen()) {
+        world.manager.setRecorder(nullptr);
+        recorder.close();
+        std::cerr << "recorded " << recorder.getStepCount() << " updates, final positions checksum " << std::hex
+            << positionsChecksum(world.manager) << std::dec << "\n";
+    }
+    if(opts.rollback != 0)
+        checkRollback(world, opts.rollback, delT);
+    if(opts.save_snapshot.size() != 0 && !saveSnapshot(world.manager, opts.save_snapshot))
+        std::cerr << "could not write snapshot: " << opts.save_snapshot << "\n";
+    return result;
+}
+
+/*
+* world set up by the scenario and advanced by warmup frames becomes the scene of the batch
+* every world gets its own select modes and restitution, times are measured on the wall clock
+*/
+static BenchResult runBatch(const Scenario& scenario, const BenchOptions& opts) {
+    BenchWorld world(opts.seed);
+    world.manager.steps = opts.substeps;
+    scenario.setup(world, opts.bodies);
+    const float delT = 1.f / 60.f;
+    //at least one update is needed to flush added bodies into the manager
+    for(size_t frame = 0; frame < std::max<size_t>(1, opts.warmup); frame++) {
+        if(scenario.onFrame)
+            scenario.onFrame(world, frame);
+        world.manager.update(opts.warmup == 0 ? 0.f : delT);
+    }
+    typedef std::chrono::steady_clock clock;
+    auto start = clock::now();
+    WorldBatch batch(opts.threads);
+    batch.create(world.manager, opts.batch);
+    batch.forEach([&](size_t idx, WorldBatch::World& w) {
+        BenchRandom rng(opts.seed + (unsigned int)idx);
+        w.manager.bounciness_select = (PhysicsManager::eSelectMode)(idx % 3);
+        w.manager.friction_select = (PhysicsManager::eSelectMode)(idx / 3 % 3);
+        for(size_t i = 0; i < w.scene->size(); i++)
+            w.scene->getManifold(i).material->restitution = rng.Random(0.f, 0.5f);
+    });
+    std::cerr << "created " << batch.size() << " worlds of " << world.manager.getRigidbodyCount() << " bodies on "
+        << batch.getThreadCount() << " threads in " << std::chrono::duration<double, std::milli>(clock::now() - start).count() << " ms\n";
+
+    BenchResult result;
+    result.scenario = std::string(scenario.name) + "_batch";
+    result.opts = opts;
+    start = clock::now();
+    for(size_t frame = 0; frame < opts.frames; frame++) {
+        batch.step(delT);
+        EPI_PROFILE_FRAME();
+        auto stats = batch.collect([](size_t, WorldBatch::World& w) { return w.manager.getStats(); });
+        for(auto& s : stats)
+            accumulate(result, s);
+    }
+    result.total_seconds = std::chrono::duration<double>(clock::now() - start).count();
+    result.final_bodies = batch.size() == 0 ? 0 : batch.get(0).manager.getRigidbodyCount();
+    return result;
+}
+//replays recorded log as fast as possible, first warmup updates are not measured
+static BenchResult replay(const BenchOptions& opts) {
+    PhysicsManager manager(AABB::CreateMinMax({0, 0}, {1, 1}));
+    ReplayPlayer player;
+    std::string error;
+    if(!player.open(opts.replay, &error)) {
+        std::cerr << "could not open recording " << opts.replay << ": " << error << "\n";
+        std::exit(1);
+    }
+    BenchResult result;
+    result.scenario = "replay";
+    result.opts = opts;
+    result.opts.frames = 0;
+    float delT;
+    while(player.next(manager, delT)) {
+        manager.update(delT);
+        EPI_PROFILE_FRAME();
+        if(player.getStep() <= opts.warmup)
+            continue;
+        accumulate(result, manager.getStats());
+        result.opts.frames++;
+    }
+    if(player.getError().size() != 0)
+        std::cerr << "replay stopped at update " << player.getStep() << ": " << player.getError() << "\n";
+    if(player.getDesyncStep() != SNAPSHOT_NONE)
+        std::cerr << "replay diverged from recording after update " << player.getDesyncStep() << "\n";
+    result.final_bodies = manager.getRigidbodyCount();
+    std::cerr << "replayed " << player.getStep() << " updates, final positions checksum " << std::hex
+        << positionsChecksum(manager) << std::dec << "\n";
+    player.removeFrom(manager);
+    manager.update(0.f);
+    return result;
+}
+
+static const char* CSV_HEADER = "scenario,seed,bodies,frames,substeps,total_s,steps_per_s,ns_per_body_step,"
+    "avg_bodies,avg_sleeping,avg_broadphase_pairs,avg_narrowphase_tests,avg_contacts,"
+    "broadphase_ms,narrowphase_ms,restraints_ms,integration_ms,sleeping_ms,triggers_ms,avg_particles,particles_ms,avg_fluid_particles,fluid_ms";
+
+static void printResult(const BenchResult& r, const std::string& format, bool last) {
+    double frames = (double)std::max<size_t>(1, r.opts.frames);
+    double steps_per_s = r.total_seconds > 0.0 ? frames / r.total_seconds : 0.0;
+    double ns_per_body = r.body_steps > 0.0 ? r.total_seconds * 1e9 / r.body_steps : 0.0;
+    auto ms = [&](double seconds) { return seconds * 1000.0 / frames; };
+    if(format == "json") {
+        std::cout << "  {\"scenario\": \"" << r.scenario << "\", \"seed\": " << r.opts.seed
+            << ", \"bodies\": " << r.final_bodies << ", \"frames\": " << r.opts.frames
+            << ", \"substeps\": " << r.opts.substeps << ", \"total_s\": " << r.total_seconds
+            << ", \"steps_per_s\": " << steps_per_s << ", \"ns_per_body_step\": " << ns_per_body
+            << ", \"avg_bodies\": " << r.sum.rigidbodies / frames
+            << ", \"avg_sleeping\": " << r.sum.sleeping / frames
+            << ", \"avg_broadphase_pairs\": " << r.sum.broadphase_pairs / frames
+            << ", \"avg_narrowphase_tests\": " << r.sum.narrowphase_tests / frames
+            << ", \"avg_contacts\": " << r.sum.contacts / frames
+            << ", \"avg_particles\": " << r.sum.particles / frames
+            << ", \"avg_fluid_particles\": " << r.sum.fluid_particles / frames
+            << ", \"phases_ms\": {\"broadphase\": " << ms(r.sum.time_broadphase)
+            << ", \"narrowphase\": " << ms(r.sum.time_narrowphase)
+            << ", \"restraints\": " << ms(r.sum.time_restraints)
+            << ", \"integration\": " << ms(r.sum.time_integration)
+            << ", \"sleeping\": " << ms(r.sum.time_sleeping)
+            << ", \"triggers\": " << ms(r.sum.time_triggers)
+            << ", \"particles\": " << ms(r.sum.time_particles)
+            << ", \"fluid\": " << ms(r.sum.time_fluid) << "}}" << (last ? "\n" : ",\n");
+        return;
+    }
+    std::cout << r.scenario << "," << r.opts.seed << "," << r.final_bodies << "," << r.opts.frames << ","
+        << r.opts.substeps << "," << r.total_seconds << "," << steps_per_s << "," << ns_per_body << ","
+        << r.sum.rigidbodies / frames << "," << r.sum.sleeping / frames << ","
+        << r.sum.broadphase_pairs / frames << "," << r.sum.narrowphase_tests / frames << ","
+        << r.sum.contacts / frames << ","
+        << ms(r.sum.time_broadphase) << "," << ms(r.sum.time_narrowphase) << ","
+        << ms(r.sum.time_restraints) << "," << ms(r.sum.time_integration) << ","
+        << ms(r.sum.time_sleeping) << "," << ms(r.sum.time_triggers) << "," << r.sum.particles / frames << ","
+        << ms(r.sum.time_particles) << "," << r.sum.fluid_particles / frames << ","
+        << ms(r.sum.time_fluid) << "\n";
+}
+static void printUsage() {
+    std::cerr << "usage: physics_bench [--scenario name|all] [--bodies N] [--frames N] [--warmup N] "
+        "[--substeps N] [--seed N] [--format csv|json] [--trace file] [--save-snapshot file] [--load-snapshot file] [--rollback N]\n"
+        "                     [--record file] [--replay file] [--batch N] [--threads N]\n"
+        "scenarios: circle_rain, polygon_pyramid, mixed_pile, restraint_chains, sleeping_field, particle_spray, fluid_tank, static_level,\n"
+        "           chain_terrain, compound_pile, sensor_zones\n";
+}
+
+int main(int argc, char** argv) {
+    BenchOptions opts;
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if(arg == "--help" || arg == "-h") {
+            printUsage();
+            return 0;
+        }
+        if(i + 1 >= argc) {
+            printUsage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        if(arg == "--scenario") {
+            opts.scenario = value;
+        } else if(arg == "--bodies") {
+            opts.bodies = std::strtoul(value.c_str(), nullptr, 10);
+        } else if(arg == "--frames") {
+            opts.frames = std::strtoul(value.c_str(), nullptr, 10);
+        } else if(arg == "--warmup") {
+            opts.warmup = std::strtoul(value.c_str(), nullptr, 10);
+        } else if(arg == "--substeps") {
+            opts.substeps = std::max<size_t>(1, std::strtoul(value.c_str(), nullptr, 10));
+        } else if(arg == "--seed") {
+            opts.seed = std::max<unsigned int>(1, std::strtoul(value.c_str(), nullptr, 10));
+        } else if(arg == "--format") {
+            opts.format = value;
+        } else if(arg == "--trace") {
+            opts.trace = value;
+        } else if(arg == "--save-snapshot") {
+            opts.save_snapshot = value;
+        } else if(arg == "--load-snapshot") {
+            opts.load_snapshot = value;
+        } else if(arg == "--rollback") {
+            opts.rollback = std::strtoul(value.c_str(), nullptr, 10);
+        } else if(arg == "--record") {
+            opts.record = value;
+        } else if(arg == "--replay") {
+            opts.replay = value;
+        } else if(arg == "--batch") {
+            opts.batch = std::strtoul(value.c_str(), nullptr, 10);
+        } else if(arg == "--threads") {
+            opts.threads = std::strtoul(value.c_str(), nullptr, 10);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+    std::vector<Scenario> scenarios = {circleRain(), polygonPyramid(), mixedPile(), restraintChains(), sleepingField(), particleSpray(), fluidTank(), staticLevel(), chainTerrain(), compoundPile(), sensorZones()};
+    if(opts.load_snapshot.size() != 0) {
+        scenarios = {snapshotScenario(opts.load_snapshot)};
+        opts.scenario = "snapshot";
+    }
+    std::vector<const Scenario*> selected;
+    for(auto& s : scenarios)
+        if(opts.scenario == "all" || opts.scenario == s.name)
+            selected.push_back(&s);
+    if(selected.size() == 0) {
+        std::cerr << "unknown scenario: " << opts.scenario << "\n";
+        printUsage();
+        return 1;
+    }
+    if(opts.save_snapshot.size() != 0 && selected.size() != 1) {
+        std::cerr << "--save-snapshot needs a single scenario\n";
+        return 1;
+    }
+    if(opts.record.size() != 0 && selected.size() != 1) {
+        std::cerr << "--record needs a single scenario\n";
+        return 1;
+    }
+    if(opts.replay.size() != 0)
+        selected = {nullptr};
+
+    if(opts.format == "json")
+        std::cout << "[\n";
+    else
+        std::cout << CSV_HEADER << "\n";
+    for(size_t i = 0; i < selected.size(); i++) {
+        auto result = !selected[i] ? replay(opts) : opts.batch != 0 ? runBatch(*selected[i], opts) : run(*selected[i], opts);
+        printResult(result, opts.format, i + 1 == selected.size());
+    }
+    if(opts.format == "json")
+        std::cout << "]\n";
+    if(opts.trace.size() != 0 && !Profiler::get().exportChromeTrace(opts.trace)) {
+        std::cerr << "could not write trace: " << opts.trace << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include "batch_renderer.hpp"
+#include "col_utils.hpp"
+#include "collider.hpp"
+
+namespace epi {
+
+BatchRenderer::BatchRenderer(size_t circle_points) : _fills(sf::Triangles), _lines(sf::Lines) {
+    for(size_t i = 0; i < circle_points; i++) {
+        float angle = 2.f * fEPI_PI * (float)i / (float)circle_points;
+        _unit_circle.push_back(vec2f(cosf(angle), sinf(angle)));
+    }
+}
+void BatchRenderer::clear() {
+    _fills.clear();
+    _lines.clear();
+}
+void BatchRenderer::m_line(vec2f a, vec2f b, Color color) {
+    _lines.append(sf::Vertex(toSf(a), color));
+    _lines.append(sf::Vertex(toSf(b), color));
+}
+void BatchRenderer::m_triangle(vec2f a, vec2f b, vec2f c, Color color) {
+    _fills.append(sf::Vertex(toSf(a), color));
+    _fills.append(sf::Vertex(toSf(b), color));
+    _fills.append(sf::Vertex(toSf(c), color));
+}
+void BatchRenderer::m_polygon(const Polygon& poly, Color color) {
+    auto& verts = poly.getVertecies();
+    for(size_t i = 0; i < verts.size(); i++) {
+        vec2f next = verts[(i + 1) % verts.size()];
+        m_triangle(verts[i], next, poly.getPos(), color);
+        m_line(verts[i], next, Color::Red);
+    }
+}
+void BatchRenderer::addCircle(vec2f pos, float radius, Color color) {
+    size_t n = _unit_circle.size();
+    for(size_t i = 0; i < n; i++)
+        m_triangle(pos, pos + _unit_circle[i] * radius, pos + _unit_circle[(i + 1) % n] * radius, color);
+}
+void BatchRenderer::addRect(const AABB& aabb, Color color) {
+    m_triangle(aabb.min, aabb.tl(), aabb.max, color);
+    m_triangle(aabb.min, aabb.max, aabb.br(), color);
+}
+void BatchRenderer::addRigid(RigidManifold man, Color color) {
+    addCollider(*man.collider, *man.transform, color);
+}
+void BatchRenderer::addCollider(const Collider& col, Transform& pose, Color color) {
+    switch(col.type) {
+        case eCollisionShape::Circle: {
+            auto c = col.getCircleShape(pose);
+            addCircle(c.pos, c.radius, color);
+            size_t n = _unit_circle.size();
+            for(size_t i = 0; i < n; i++)
+                m_line(c.pos + _unit_circle[i] * c.radius, c.pos + _unit_circle[(i + 1) % n] * c.radius, Color::Red);
+            m_line(c.pos, c.pos + pose.getRotation().rotate(vec2f(c.radius, 0.f)), Color::Blue);
+        }break;
+        case eCollisionShape::Polygon: {
+            col.getPolygonShape(pose, _polygon);
+            m_polygon(_polygon, color);
+            m_line(_polygon.getPos(), _polygon.getVertecies()[0], Color::Blue);
+        } break;
+        case eCollisionShape::Ray: {
+            Ray t = col.getRayShape(pose);
+            m_line(t.pos, t.pos + t.dir, Color::White);
+        } break;
+        case eCollisionShape::Chain: {
+            auto& chain = col.getChainModel();
+            for(size_t i = 0; i < chain.getSegmentCount(); i++) {
+                auto seg = chain.getSegment(i, pose);
+                m_line(seg.a, seg.b, color);
+                //short tick on the solid side
+                vec2f mid = (seg.a + seg.b) / 2.f;
+                m_line(mid, mid - seg.getNormal() * 4.f, Color::Red);
+            }
+        } break;
+        case eCollisionShape::Compound: {
+            auto& compound = col.getCompoundModel();
+            for(size_t i = 0; i < compound.getPolygonCount(); i++) {
+                compound.getPolygon(i, pose, _polygon);
+                m_polygon(_polygon, color);
+            }
+            for(size_t i = 0; i < compound.getCircleCount(); i++) {
+                auto c = compound.getCircle(i, pose);
+                addCircle(c.pos, c.radius, color);
+            }
+            m_line(pose.getPos(), pose.getPos() + pose.getRotation().rotate(vec2f(compound.getAABB().max.x, 0.f)), Color::Blue);
+        } break;
+    }
+}
+void BatchRenderer::draw(sf::RenderTarget& target) const {
+    target.draw(_fills);
+    target.draw(_lines);
+}
+
+}
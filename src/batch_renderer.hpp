@@ -0,0 +1,48 @@
+#pragma once
+#include "SFML/Graphics/RenderTarget.hpp"
+#include "SFML/Graphics/VertexArray.hpp"
+
+#include "draw.hpp"
+#include "rigidbody.hpp"
+
+#include <vector>
+
+namespace epi {
+
+/*
+* \brief gathers shapes of a whole frame into two vertex arrays, drawn with one call each
+* circles are filled with a fan made from a precomputed unit circle, polygons with a fan around their center
+* arrays keep their memory between frames, so after the first frames nothing is allocated
+*/
+class BatchRenderer {
+    sf::VertexArray _fills;
+    sf::VertexArray _lines;
+    //offsets of points on unit circle, used for every circle
+    std::vector<vec2f> _unit_circle;
+    //world space polygon of the shape being added, reused so that its vertices are not allocated for every shape
+    Polygon _polygon;
+
+    void m_line(vec2f a, vec2f b, Color color);
+    void m_triangle(vec2f a, vec2f b, vec2f c, Color color);
+    //filled with color and outlined in red
+    void m_polygon(const Polygon& poly, Color color);
+public:
+    //drops everything gathered during last frame
+    void clear();
+    //filled shape with outline and line showing its rotation, same as the demo always drew it
+    void addRigid(RigidManifold man, Color color);
+    //same as above, but shape is placed at pose instead of the transform it is simulated with
+    void addCollider(const Collider& col, Transform& pose, Color color);
+    void addCircle(vec2f pos, float radius, Color color);
+    //filled box without outline, used as coarse level of detail for shapes only few pixels big
+    void addRect(const AABB& aabb, Color color);
+    //draws everything gathered since last clear, in two draw calls
+    void draw(sf::RenderTarget& target) const;
+
+    size_t getVertexCount() const {
+        return _fills.getVertexCount() + _lines.getVertexCount();
+    }
+    BatchRenderer(size_t circle_points = 24);
+};
+
+}
@@ -1,8 +1,11 @@
 #ifndef H_EPI_CAMERA
 #define H_EPI_CAMERA
 #include "SFML/Graphics/RenderTarget.hpp"
+#include "draw.hpp"
 #include "transform.hpp"
 #include <SFML/Graphics/View.hpp>
+
+#include <cmath>
 namespace epi {
 
 class Camera : Signal::Observer<TransformEvent> {
@@ -13,19 +16,28 @@ public:
     Transform transform;
     virtual void onNotify(TransformEvent event) {
         if(event.isPosChanged)
-            _view.setCenter(transform.getPos());
+            _view.setCenter(toSf(transform.getPos()));
         if(event.isRotChanged)
             _view.setRotation(transform.getRot() / EPI_PI * 180.f);
         if(event.isScaleChanged)
-            _view.setSize(_size * transform.getScale());
+            _view.setSize(toSf(_size * transform.getScale()));
         _window.setView(_view);
     }
+    //area of the world seen through the camera, when rotated it is the bounding box of the view
+    AABB getViewAABB() const {
+        float angle = _view.getRotation() / 180.f * EPI_PI;
+        vec2f half = vec2f(_view.getSize().x, _view.getSize().y) / 2.f;
+        vec2f extent(std::abs(std::cos(angle)) * half.x + std::abs(std::sin(angle)) * half.y,
+                     std::abs(std::sin(angle)) * half.x + std::abs(std::cos(angle)) * half.y);
+        vec2f center(_view.getCenter().x, _view.getCenter().y);
+        return AABB::CreateMinMax(center - extent, center + extent);
+    }
     void Shake() {}
     //smoothing
 
     Camera(sf::RenderTarget& window, vec2f size) : _size(size), _window(window) {
         _view = window.getDefaultView();
-        _view.setSize(_size * transform.getScale());
+        _view.setSize(toSf(_size * transform.getScale()));
         window.setView(_view);
 
         transform.addObserver(this);
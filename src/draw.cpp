@@ -0,0 +1,76 @@
+#include "draw.hpp"
+#include "SFML/Graphics/PrimitiveType.hpp"
+#include "SFML/Graphics/RenderTarget.hpp"
+
+namespace epi {
+void draw(sf::RenderWindow& rw, const Polygon& poly, Color clr) {
+    struct VertPair {
+        sf::Vertex a;
+        sf::Vertex b;
+    };
+    for(size_t i = 0; i < poly.getVertecies().size(); i++) {
+        sf::Vertex t[2];
+        t[0].color = clr;
+        t[1].color = clr;
+        t[0].position = toSf(poly.getVertecies()[i]);
+        if(i != poly.getVertecies().size() - 1) {
+            t[1].position = toSf(poly.getVertecies()[i + 1]);
+        } else {
+            t[1].position = toSf(poly.getVertecies()[0]);
+        }
+        rw.draw(t, 2, sf::Lines);
+    }
+}
+void drawOutline(sf::RenderTarget& rw, const AABB& aabb, Color clr) {
+    sf::Vertex t[5];
+    vec2f vert[] = {aabb.bl(), aabb.br(), aabb.tr(), aabb.tl(), aabb.bl()};
+    for(int i = 0; i < 5; i++) {
+        t[i].color = clr;
+        t[i].position = toSf(vert[i]);
+    }
+    rw.draw(&t[0], 2, sf::Lines);
+    rw.draw(&t[1], 2, sf::Lines);
+    rw.draw(&t[2], 2, sf::Lines);
+    rw.draw(&t[3], 2, sf::Lines);
+}
+void drawFill(sf::RenderTarget& rw, const AABB& aabb, Color clr) {
+    sf::Vertex t[4];
+    vec2f vert[] = {aabb.bl(), aabb.br(), aabb.tr(), aabb.tl()};
+    for(int i = 0; i < 4; i++) {
+        t[i].color = clr;
+        t[i].position = toSf(vert[i]);
+    }
+    rw.draw(t, 4, sf::Quads);
+}
+void drawFill(sf::RenderTarget& rw, const Polygon& poly, Color clr) {
+    for(size_t i = 0; i < poly.getVertecies().size(); i++) {
+        sf::Vertex t[3];
+        t[0].color = clr;
+        t[1].color = clr;
+        t[2].color = clr;
+        t[0].position = toSf(poly.getVertecies()[i]);
+        t[2].position = toSf(poly.getPos());
+        if(i != poly.getVertecies().size() - 1) {
+            t[1].position = toSf(poly.getVertecies()[i + 1]);
+        } else {
+            t[1].position = toSf(poly.getVertecies()[0]);
+        }
+        rw.draw(t, 3, sf::Triangles);
+    }
+}
+void drawOutline(sf::RenderTarget& rw, const Polygon& poly, Color clr) {
+    for(size_t i = 0; i < poly.getVertecies().size(); i++) {
+        sf::Vertex t[2];
+        t[0].color = clr;
+        t[1].color = clr;
+        t[0].position = toSf(poly.getVertecies()[i]);
+        if(i != poly.getVertecies().size() - 1) {
+            t[1].position = toSf(poly.getVertecies()[i + 1]);
+        } else {
+            t[1].position = toSf(poly.getVertecies()[0]);
+        }
+        rw.draw(t, 2, sf::Lines);
+    }
+}
+
+}
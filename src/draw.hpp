@@ -0,0 +1,46 @@
+#pragma once
+#include "SFML/Graphics/RenderTarget.hpp"
+#include "SFML/Graphics/RenderWindow.hpp"
+#include "imgui.h"
+#include "imgui-SFML.h"
+
+#include "SFML/Graphics.hpp"
+
+#include "types.hpp"
+
+namespace epi {
+
+typedef sf::Color Color;
+typedef sf::RenderWindow Window;
+
+namespace PastelColor {
+    const Color bg =     Color(0xa89984ff);
+    const Color bg1 =    Color(0xa89984ff);
+    const Color bg2 =    Color(0xbdae93ff);
+    const Color bg3 =    Color(0xebdbb2ff);
+    const Color bg4 =    Color(0x1e3a4cff);
+    const Color Red =    Color(0x9d0006ff);
+    const Color Green =  Color(0x79740eff);
+    const Color Yellow = Color(0xb57614ff);
+    const Color Blue =   Color(0x076678ff);
+    const Color Purple = Color(0x8f3f71ff);
+    const Color Aqua =   Color(0x427b58ff);
+    const Color Orange = Color(0xaf3a03ff);
+    const Color Gray =   Color(0x928374ff);
+};
+
+//conversions between physics and SFML vectors
+inline sf::Vector2f toSf(vec2f v) {
+    return sf::Vector2f(v.x, v.y);
+}
+inline vec2f fromSf(sf::Vector2f v) {
+    return vec2f(v.x, v.y);
+}
+
+void draw(sf::RenderWindow& rw, const Polygon& poly, Color clr);
+void drawFill(sf::RenderTarget& rw, const AABB& aabb, Color clr);
+void drawOutline(sf::RenderTarget& rw, const AABB& aabb, Color clr);
+void drawFill(sf::RenderTarget& rw, const Polygon& poly, Color clr);
+void drawOutline(sf::RenderTarget& rw, const Polygon& poly, Color clr);
+
+}
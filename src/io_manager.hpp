@@ -8,6 +8,7 @@
 #include "SFML/Window/Window.hpp"
 #include "SFML/Window.hpp"
 
+#include "draw.hpp"
 #include "types.hpp"
 
 namespace epi {
@@ -34,7 +35,7 @@ public:
         return _current_event;
     }
     vec2f getMouseWorldPos() const {
-        return _window.mapPixelToCoords(sf::Mouse::getPosition(_window));
+        return fromSf(_window.mapPixelToCoords(sf::Mouse::getPosition(_window)));
     }
     void display() {
         //ImGui::SFML::Update();
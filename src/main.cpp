@@ -1,10 +1,11 @@
+#include <atomic>
 #include <memory>
 #include <string>
 #include <sys/signal.h>
+#include <unordered_map>
 #include <vector>
 #include <numeric>
 
-#include "SFML/Graphics/CircleShape.hpp"
 #include "SFML/Graphics/Color.hpp"
 #include "SFML/Graphics/PrimitiveType.hpp"
 #include "SFML/Graphics/RenderTarget.hpp"
@@ -14,62 +15,27 @@
 #include "SFML/Window/Mouse.hpp"
 #include "imgui-SFML.h"
 
+#include "batch_renderer.hpp"
+#include "draw.hpp"
 #include "io_manager.hpp"
 #include "types.hpp"
 #include "col_utils.hpp"
 #include "collider.hpp"
 #include "imgui.h"
+#include "fluid_manager.hpp"
+#include "particle_manager.hpp"
+#include "physics_thread.hpp"
+#include "profiler.hpp"
+#include "recorder.hpp"
 #include "restraint.hpp"
 #include "rigidbody.hpp"
 #include "scene.hpp"
+#include "snapshot.hpp"
 #include "transform.hpp"
 #include "RNG.h"
 
 using namespace epi;
 
-static void DrawRigid(RigidManifold man, sf::RenderTarget& rw, Color color = PastelColor::bg1) {
-    auto& col = *man.collider;
-    switch(col.type) {
-        case eCollisionShape::Circle: {
-            auto c = col.getCircleShape(*man.transform);
-            sf::CircleShape cs(c.radius);
-            cs.setPosition(man.transform->getPos() - vec2f(c.radius, c.radius));
-            cs.setFillColor(color);
-            cs.setOutlineColor(Color::Black);
-            cs.setOutlineColor(Color::Red);
-            cs.setOutlineThickness(1.f);
-            rw.draw(cs);
-
-            sf::Vertex verts[2];
-            verts[0].position = c.pos;
-            verts[1].position = c.pos + rotateVec(vec2f(c.radius, 0.f), man.transform->getRot());
-            verts[0].color = Color::Blue;
-            verts[1].color = Color::Blue;
-            rw.draw(verts, 2, sf::Lines);
-        }break;
-        case eCollisionShape::Polygon: {
-            auto p = col.getPolygonShape(*man.transform);
-            drawFill(rw, p, color);
-            drawOutline(rw, p, sf::Color::Black);
-            drawOutline(rw, p, sf::Color::Red);
-            sf::Vertex verts[2];
-            verts[0].position = p.getPos();
-            verts[1].position = p.getVertecies()[0];
-            verts[0].color = Color::Blue;
-            verts[1].color = Color::Blue;
-            rw.draw(verts, 2, sf::Lines);
-        } break;
-        case epi::eCollisionShape::Ray: {
-            Ray t = col.getRayShape(*man.transform);
-            sf::Vertex verts[2] ;
-            verts[0].position = t.pos;
-            verts[1].position = t.pos + t.dir;
-            verts[0].color = sf::Color::White;
-            verts[1].color = sf::Color::White;
-            rw.draw(verts, 2, sf::Lines);
-        } break;
-    }
-}
 #define CONSOLAS_PATH "assets/Consolas.ttf"
 static void setupImGuiFont() {
     sf::Font consolas;
@@ -89,25 +55,57 @@ static void setupImGuiFont() {
         std::cerr << "failed to update font texture";
     }
 }
-struct CollisionLogger : public Signal::Observer<ColliderEvent>  {
-    bool isLogging = false;
-    void onNotify(ColliderEvent event) {
-        auto cn = event.info.cn;
-        if(isLogging){
-            std::cerr << &event.me << " collided with " << &event.other <<
-                ", with a collision normal of: " << cn.x << " " << cn.y;
+struct CollisionLogger {
+    //toggled from ui while events are logged on physics thread
+    std::atomic<bool> isLogging = false;
+    void log(const Collider* me, const std::vector<ContactEvent>& events) {
+        if(!isLogging)
+            return;
+        static const char* state_names[] = {"began", "persisted", "ended"};
+        for(auto& e : events) {
+            if(e.a != me && e.b != me)
+                continue;
+            auto other = e.a == me ? e.b : e.a;
+            auto cn = e.a == me ? e.cn : -e.cn;
+            std::cerr << me << " contact " << state_names[(int)e.state] << " with " << other <<
+                ", with a collision normal of: " << cn.x << " " << cn.y << "\n";
         }
     }
 };
 class DemoObject {
+    //set when components are owned by someone else, like SnapshotWorld
+    bool _isBorrowed = false;
 public:
     std::unique_ptr<Transform> transform;
     std::unique_ptr<Collider> collider;
     std::unique_ptr<Rigidbody> rigidbody;
     std::unique_ptr<Material> material;
+    //written and read only by commands running on physics thread
+    RigidbodyHandle handle;
+    //copy of properties edited from ui, physics never changes them, so they always match the components
+    struct Props {
+        float mass;
+        Material material;
+        bool isStatic;
+        bool lockRotation;
+        Tag tag;
+        Tag mask;
+    } props;
     RigidManifold getManifold() const {
         return {transform.get(), collider.get(), rigidbody.get(), material.get()};
     }
+    //fills props from components, only before object is handed to physics or while physics is stopped
+    void readProps() {
+        props = {rigidbody->mass, *material, rigidbody->isStatic, rigidbody->lockRotation, collider->tag, collider->mask};
+    }
+    void applyProps(const Props& p) {
+        rigidbody->mass = p.mass;
+        *material = p.material;
+        rigidbody->isStatic = p.isStatic;
+        rigidbody->lockRotation = p.lockRotation;
+        collider->tag = p.tag;
+        collider->mask = p.mask;
+    }
     DemoObject(Polygon poly) {
         transform = std::unique_ptr<Transform>(new Transform());
         transform->setPos(poly.getPos());
@@ -123,6 +121,13 @@ public:
         rigidbody = std::unique_ptr<Rigidbody>(new Rigidbody());
         material = std::unique_ptr<Material>(new Material());
     }
+    DemoObject(Compound compound) {
+        transform = std::unique_ptr<Transform>(new Transform());
+        transform->setPos(compound.getPos());
+        collider = std::unique_ptr<Collider>(new Collider(std::move(compound)));
+        rigidbody = std::unique_ptr<Rigidbody>(new Rigidbody());
+        material = std::unique_ptr<Material>(new Material());
+    }
     DemoObject(Ray ray) {
         transform = std::unique_ptr<Transform>(new Transform());
         transform->setPos(ray.pos + ray.dir / 2.f);
@@ -131,19 +136,58 @@ public:
         rigidbody->isStatic = true;
         material = std::unique_ptr<Material>(new Material());
     }
+    DemoObject(RigidManifold man, RigidbodyHandle h) : transform(man.transform), collider(man.collider), rigidbody(man.rigidbody), material(man.material), handle(h) {
+        _isBorrowed = true;
+    }
     ~DemoObject() {
+        if(_isBorrowed) {
+            transform.release();
+            collider.release();
+            rigidbody.release();
+            material.release();
+        }
     }
 };
 class Demo : public DefaultScene {
 protected:
     std::vector<std::unique_ptr<DemoObject>> demo_objects;
+    std::unique_ptr<SnapshotWorld> snapshot_world;
+    //parts of the scene taken out of it, destroyed once physics applied the command removing them
+    struct Dying {
+        uint64_t command;
+        std::unique_ptr<DemoObject> object;
+        std::unique_ptr<SnapshotWorld> world;
+    };
+    std::vector<Dying> dying;
+    //bodies of the last physics snapshot by their collider
+    std::unordered_map<const Collider*, const RenderBody*> poses;
+    //collider whose contacts are logged on physics thread
+    std::atomic<const Collider*> logged_collider = nullptr;
+    //indices of snapshot bodies returned by last grid query, kept to reuse memory
+    std::vector<uint32_t> visible;
+    //bodies smaller than this on screen are drawn as plain boxes, 0 draws every body in full
+    float lod_pixels = 3.f;
+    size_t drawn_bodies = 0;
+    static constexpr float RAY_PICK_DISTANCE = 10.f;
+    //sparks spawned with P, owned here and only touched by commands once physics runs
+    ParticleManager particles;
+    struct {
+        eParticleResponse response = eParticleResponse::Bounce;
+        bool isTwoWay = false;
+    } particle_settings;
+    //water poured with F, owned here like particles
+    FluidManager fluid;
+    Recorder recorder;
+    BatchRenderer renderer;
     float scroll_delta;
     struct {
         RNG _rng;
         float default_radius = 25.f;
         float radius_dev = 0.1f;
         float gravity = 1000.f;
-
+        int steps = 5;
+        PhysicsManager::eSelectMode friction_select = PhysicsManager::eSelectMode::Max;
+        PhysicsManager::eSelectMode bounciness_select = PhysicsManager::eSelectMode::Max;
         
         std::vector<vec2f> poly_creation;
         struct {
@@ -154,45 +198,181 @@ protected:
             DemoObject* object = nullptr;
             bool isHolding = false;
             Restraint* res;
+            RestraintHandle res_handle;
             Transform* mouse_trans = new Transform();
             vec2f pinch_point;
             CollisionLogger logger;
         } selection;
     }opts;
+    //pose of obj in the last physics snapshot, returns false if physics did not simulate it yet
+    bool getPose(const DemoObject& obj, Transform& pose) const {
+        auto itr = poses.find(obj.collider.get());
+        if(itr == poses.end())
+            return false;
+        pose.setPos(itr->second->pos);
+        pose.setRot(itr->second->rot);
+        pose.setScale(itr->second->scale);
+        return true;
+    }
+    static bool isHovered(const Collider& col, Transform& pose, vec2f mouse_pos) {
+        switch(col.type) {
+            case eCollisionShape::Circle: {
+                Circle shape = col.getCircleShape(pose);
+                return isOverlappingPointCircle(mouse_pos, shape);
+            }
+            case eCollisionShape::Polygon: {
+                Polygon polygon = col.getPolygonShape(pose);
+                return isOverlappingPointPoly(mouse_pos, polygon);
+            }
+            case eCollisionShape::Ray: {
+                Ray t = col.getRayShape(pose);
+                auto closest = findClosestPointOnRay(t.pos, t.dir, mouse_pos);
+                return len(closest - mouse_pos) < RAY_PICK_DISTANCE;
+            }
+            case eCollisionShape::Compound: {
+                auto& compound = col.getCompoundModel();
+                for(size_t i = 0; i < compound.getPolygonCount(); i++)
+                    if(isOverlappingPointPoly(mouse_pos, compound.getPolygon(i, pose)))
+                        return true;
+                for(size_t i = 0; i < compound.getCircleCount(); i++)
+                    if(isOverlappingPointCircle(mouse_pos, compound.getCircle(i, pose)))
+                        return true;
+                return false;
+            }
+            case eCollisionShape::Chain: {
+                auto& chain = col.getChainModel();
+                static std::vector<uint32_t> near;
+                near.clear();
+                vec2f pad(RAY_PICK_DISTANCE, RAY_PICK_DISTANCE);
+                chain.querySegments(AABB::CreateMinMax(mouse_pos - pad, mouse_pos + pad), pose, near);
+                for(auto i : near) {
+                    auto seg = chain.getSegment(i, pose);
+                    auto closest = findClosestPointOnRay(seg.a, seg.b - seg.a, mouse_pos);
+                    if(len(closest - mouse_pos) < RAY_PICK_DISTANCE)
+                        return true;
+                }
+                return false;
+            }
+        }
+        return false;
+    }
+    bool isHovered(const DemoObject& obj, vec2f mouse_pos) const {
+        Transform pose;
+        return getPose(obj, pose) && isHovered(*obj.collider, pose, mouse_pos);
+    }
+    //only bodies whose boxes are near the mouse are tested, using the grid of the snapshot
     DemoObject* findHovered() {
-        DemoObject* result;
         auto mouse_pos = io_manager.getMouseWorldPos();
-
-        for(auto& r : demo_objects) {
-            switch(r->collider->type) {
-                case eCollisionShape::Circle: {
-                    Circle shape = r->collider->getCircleShape(*r->transform);
-                    if(isOverlappingPointCircle(mouse_pos, shape)) {
-                        return r.get();
-                    }
-                } break;
-                case eCollisionShape::Polygon: {
-                    Polygon polygon = r->collider->getPolygonShape(*r->transform);
-                    if(isOverlappingPointPoly(mouse_pos, polygon)) {
-                        return r.get();
-                    }
-                }break;
-                case eCollisionShape::Ray: {
-                    Ray t = r->collider->getRayShape(*r->transform);
-                    auto closest = findClosestPointOnRay(t.pos, t.dir, mouse_pos);
-                    if(len(closest - mouse_pos) < 10.f)
-                        return r.get();
-                }break;
-            }
+        auto& snapshot = physics_thread.getSnapshot();
+        vec2f pad(RAY_PICK_DISTANCE, RAY_PICK_DISTANCE);
+        visible.clear();
+        snapshot.grid.query(AABB::CreateMinMax(mouse_pos - pad, mouse_pos + pad), visible);
+        Transform pose;
+        for(auto i : visible) {
+            auto& body = snapshot.bodies[i];
+            pose.setPos(body.pos);
+            pose.setRot(body.rot);
+            pose.setScale(body.scale);
+            if(!isHovered(*body.collider, pose, mouse_pos))
+                continue;
+            auto itr = std::find_if(demo_objects.begin(), demo_objects.end(),
+                [&](const std::unique_ptr<DemoObject>& obj) { return obj->collider.get() == body.collider; });
+            if(itr != demo_objects.end())
+                return itr->get();
         }
         return nullptr;
     }
+    //frame time graph and zone breakdown of the last or the worst remembered frame
+    void drawProfilerTab() {
+        auto& profiler = Profiler::get();
+        auto frame_times = profiler.getFrameTimesMs();
+        float max_time = 0.f;
+        for(auto t : frame_times)
+            max_time = std::max(max_time, t);
+        ImGui::PlotLines("frame ms", frame_times.data(), (int)frame_times.size(), 0, nullptr, 0.f, std::max(max_time, 1000.f / 60.f), ImVec2(0, 80));
+
+        static bool show_worst = false;
+        ImGui::Checkbox("show worst frame", &show_worst);
+        static bool paused = false;
+        ImGui::Checkbox("pause", &paused);
+        static std::vector<Profiler::ZoneRecord> zones;
+        static Profiler::FrameRecord frame = {0, 0};
+        if(!paused) {
+            frame = profiler.getFrame(show_worst ? profiler.getWorstFrameAge() : 0);
+            zones = profiler.getZones(frame.start, frame.end);
+        }
+        ImGui::Text("frame: %.3f ms", (float)(frame.end - frame.start) / 1e6f);
+        ImGui::Text("rendered vertices: %zu", renderer.getVertexCount());
+        ImGui::Text("drawn bodies: %zu of %zu", drawn_bodies, physics_thread.getSnapshot().bodies.size());
+        ImGui::SliderFloat("lod size in pixels", &lod_pixels, 0.f, 20.f);
+        for(auto& z : zones) {
+            //zones are clipped to the frame, so the ones straddling its borders are not overcounted
+            auto start = std::max(z.start, frame.start);
+            auto end = std::min(z.end, frame.end);
+            if(end <= start)
+                continue;
+            ImGui::Text("%*s%s: %.3f ms", (int)z.depth * 2, "", z.name, (float)(end - start) / 1e6f);
+        }
+        static std::string status;
+        if(ImGui::Button("export trace.json")) {
+            status = profiler.exportChromeTrace("trace.json") ? "saved trace.json" : "could not write trace.json";
+        }
+        ImGui::Text("%s", status.c_str());
+    }
+    //replaces whole scene with one loaded from snapshot, physics is paused meanwhile instead of being sent commands
+    bool loadScene(const std::string& filename, std::string& error) {
+        physics_thread.stop();
+        auto& restraints = physics_manager.getRestraints();
+        for(size_t i = 0; i < restraints.size(); i++)
+            physics_manager.remove(restraints.handleAt(i));
+        removeDemoObjects([](const DemoObject&) { return true; });
+        opts.selection.object = nullptr;
+        opts.selection.isHolding = false;
+        //removals take effect during next update, old world has to outlive it and the snapshots drawn until then
+        auto removed = physics_thread.enqueue([](PhysicsManager&) {});
+        dying.push_back({removed, nullptr, std::move(snapshot_world)});
+        snapshot_world = loadSnapshot(filename, physics_manager, &error);
+        for(size_t i = 0; snapshot_world && i < snapshot_world->size(); i++) {
+            demo_objects.push_back(std::make_unique<DemoObject>(snapshot_world->getManifold(i), snapshot_world->getHandle(i)));
+            demo_objects.back()->readProps();
+        }
+        physics_thread.start();
+        return snapshot_world != nullptr;
+    }
+    void addDemoObject(DemoObject* obj) {
+        obj->readProps();
+        demo_objects.push_back(std::unique_ptr<DemoObject>(obj));
+        physics_thread.enqueue([obj](PhysicsManager& pm) { obj->handle = pm.add(obj->getManifold()); });
+    }
+    //removes all objects for which pred returns true using single pass
+    template<class Pred>
+    void removeDemoObjects(Pred pred) {
+        std::erase_if(demo_objects, [&](std::unique_ptr<DemoObject>& obj) {
+            if(!pred(*obj))
+                return false;
+            auto raw = obj.get();
+            auto id = physics_thread.enqueue([raw](PhysicsManager& pm) { pm.remove(raw->handle); });
+            dying.push_back({id, std::move(obj), nullptr});
+            return true;
+        });
+    }
+    //sends world settings edited in ui to physics
+    void pushWorldSettings() {
+        physics_thread.enqueue([gravity = opts.gravity, steps = opts.steps, friction = opts.friction_select, bounce = opts.bounciness_select](PhysicsManager& pm) {
+            pm.gravity = vec2f(0, gravity);
+            pm.steps = static_cast<unsigned int>(steps);
+            pm.friction_select = friction;
+            pm.bounciness_select = bounce;
+        });
+    }
+    //sends properties edited in ui to physics
+    void pushProps(DemoObject* obj) {
+        physics_thread.enqueue([obj, props = obj->props](PhysicsManager&) { obj->applyProps(props); });
+    }
 
     void onSetup() override {
         setupImGuiFont();
-        physics_manager.steps = 5;
-        physics_manager.bounciness_select = PhysicsManager::eSelectMode::Max;
-        physics_manager.friction_select = PhysicsManager::eSelectMode::Max;
+        pushWorldSettings();
 
         auto aabb_outer = sim_window;
         auto aabb_inner = sim_window;
@@ -214,10 +394,10 @@ protected:
             model.push_back(vec2f(aabb_outer.bx, aabb_outer.by));\
             model.push_back(vec2f(aabb_outer.ax, aabb_outer.ay));\
             auto t = Polygon::CreateFromPoints(model);\
-            demo_objects.push_back(std::unique_ptr<DemoObject>(new DemoObject(t)));\
-            demo_objects.back().get()->rigidbody->isStatic = true;\
-            demo_objects.back().get()->collider->tag.add("ground");\
-            physics_manager.add(demo_objects.back().get()->getManifold());\
+            auto obj = new DemoObject(t);\
+            obj->rigidbody->isStatic = true;\
+            obj->collider->tag.add("ground");\
+            addDemoObject(obj);\
         }
 
         ADD_SIDE(min.x, min.y, min.x, max.y);
@@ -225,6 +405,13 @@ protected:
         ADD_SIDE(max.x, max.y, min.x, max.y);
         ADD_SIDE(max.x, max.y, max.x, min.y);
 
+        particles.radius = 2.f;
+        physics_manager.bind(&particles);
+        physics_manager.bind(&fluid);
+        physics_thread.on_update = [this](PhysicsManager& pm) {
+            opts.selection.logger.log(logged_collider.load(), pm.getContactEvents());
+        };
+        physics_thread.start();
     }
     void onEvent(const sf::Event& event) {
         switch(event.type) 
@@ -232,11 +419,13 @@ protected:
             case sf::Event::MouseButtonPressed: {
                 if(event.mouseButton.button == sf::Mouse::Left) {
                     auto hovered = findHovered();
-                    if(hovered) {
+                    Transform pose;
+                    if(hovered && getPose(*hovered, pose)) {
                         //opts.selection.isHolding = true;
-                        opts.selection.pinch_point = rotateVec(io_manager.getMouseWorldPos() - hovered->transform->getPos(), -hovered->transform->getRot());
-                        opts.selection.res = new RestraintPointTrans( hovered->getManifold(), opts.selection.pinch_point, opts.selection.mouse_trans, vec2f());
-                        physics_manager.add(opts.selection.res);
+                        opts.selection.pinch_point = pose.getRotation().inverseRotate(io_manager.getMouseWorldPos() - pose.getPos());
+                        auto res = new RestraintPointTrans( hovered->getManifold(), opts.selection.pinch_point, opts.selection.mouse_trans, vec2f());
+                        opts.selection.res = res;
+                        physics_thread.enqueue([this, res](PhysicsManager& pm) { opts.selection.res_handle = pm.add(res); });
                         opts.selection.object = hovered;
                         opts.selection.isHolding = true;
                     }else {
@@ -244,21 +433,24 @@ protected:
                     }
                 } else if(event.mouseButton.button == sf::Mouse::Right) {
                     auto hovered = findHovered();
-                    if(hovered && opts.selection.object) {
-                        auto dist = hovered->transform->getPos() - opts.selection.object->transform->getPos();
+                    Transform pose;
+                    if(hovered && opts.selection.object && getPose(*hovered, pose)) {
                         auto a = opts.selection.object;
                         auto ap = opts.selection.pinch_point;
                         auto b = hovered;
-                        auto bp = rotateVec(io_manager.getMouseWorldPos() - hovered->transform->getPos(), -hovered->transform->getRot());
+                        auto bp = pose.getRotation().inverseRotate(io_manager.getMouseWorldPos() - pose.getPos());
                         auto res = new RestraintRigidRigid(b->getManifold(), bp, a->getManifold(), ap);
-                        physics_manager.add(res);
+                        physics_thread.enqueue([res](PhysicsManager& pm) { pm.add(res); });
                     }
                 }
             }break;
             case sf::Event::MouseButtonReleased: {
                 if(opts.selection.isHolding && !sf::Keyboard::isKeyPressed(sf::Keyboard::X)) {
-                    physics_manager.remove(opts.selection.res);
-                    delete opts.selection.res;
+                    //restraint is deleted on physics thread, right after it stops being used
+                    physics_thread.enqueue([this, res = opts.selection.res](PhysicsManager& pm) {
+                        pm.remove(opts.selection.res_handle);
+                        delete res;
+                    });
                 }else if(sf::Keyboard::isKeyPressed(sf::Keyboard::X)){
                     opts.selection.mouse_trans = new Transform();
                     opts.selection.res = nullptr;
@@ -269,54 +461,73 @@ protected:
                 float r = opts.default_radius * opts._rng.Random(1.f, 1.f + opts.radius_dev);
                 switch(event.key.code)
                 {
+                    case sf::Keyboard::P: {
+                        static const size_t SPARK_COUNT = 500;
+                        static const float SPARK_LIFETIME = 5.f;
+                        vec2f pos = io_manager.getMouseWorldPos();
+                        std::vector<vec2f> vels(SPARK_COUNT);
+                        for(auto& v : vels)
+                            v = rotateVec(vec2f(opts._rng.Random(100.f, 1000.f), 0.f), opts._rng.Random(0.f, 2.f * fEPI_PI));
+                        physics_thread.enqueue([this, pos, vels = std::move(vels)](PhysicsManager&) {
+                            for(auto v : vels)
+                                particles.spawn(pos, v, SPARK_LIFETIME);
+                        });
+                    }break;
+                    case sf::Keyboard::F: {
+                        static const float FLUID_BLOCK_SIZE = 120.f;
+                        vec2f pos = io_manager.getMouseWorldPos();
+                        auto area = AABB::CreateCenterSize(pos, vec2f(1.f, 1.f) * FLUID_BLOCK_SIZE);
+                        physics_thread.enqueue([this, area](PhysicsManager&) {
+                            fluid.spawnBlock(area);
+                        });
+                    }break;
                     case sf::Keyboard::C: {
                         Circle t(io_manager.getMouseWorldPos(), r);
-                        demo_objects.push_back(std::unique_ptr<DemoObject>(new DemoObject(t)));
-                        physics_manager.add(demo_objects.back().get()->getManifold());
+                        addDemoObject(new DemoObject(t));
                     }break;
                     case sf::Keyboard::V: {
                         auto side_count = opts._rng.Random(opts.poly_sides_count.min, opts.poly_sides_count.max);
                         Polygon t = Polygon::CreateRegular(io_manager.getMouseWorldPos(), fEPI_PI/side_count, static_cast<size_t>(side_count), r * sqrt(2.f));
-                        auto ptr = new DemoObject(t);
-                        demo_objects.push_back(std::unique_ptr<DemoObject>(ptr));
-                        physics_manager.add(demo_objects.back().get()->getManifold());
+                        addDemoObject(new DemoObject(t));
                     }break;
                     case sf::Keyboard::Enter: {
                         if(opts.poly_creation.size() < 2) {
                             break;
                         }else if(opts.poly_creation.size() == 2) {
                             Ray t = Ray::CreatePoints(opts.poly_creation.front(), opts.poly_creation.back());
-                            demo_objects.push_back(std::unique_ptr<DemoObject>(new DemoObject(t)));
+                            addDemoObject(new DemoObject(t));
                         } else {
-                            Polygon t = Polygon::CreateFromPoints(opts.poly_creation);
-                            demo_objects.push_back(std::unique_ptr<DemoObject>(new DemoObject(t)));
+                            //concave outlines are split into convex children of one body
+                            auto t = Compound::CreateFromOutline(opts.poly_creation);
+                            if(t.getChildCount() == 1)
+                                addDemoObject(new DemoObject(Polygon::CreateFromPoints(opts.poly_creation)));
+                            else
+                                addDemoObject(new DemoObject(std::move(t)));
                         }
-                        physics_manager.add(demo_objects.back().get()->getManifold());
                         opts.selection.object = demo_objects.back().get();
                     }break;
                     case sf::Keyboard::BackSpace: {
-                        DemoObject* objptr = opts.selection.object;
-                        do {
-                            auto itr = std::find_if(demo_objects.begin(), demo_objects.end(), 
-                                [&](const std::unique_ptr<DemoObject>& obj) {
-                                    return obj.get() == objptr;
-                                });
-                            if(itr != demo_objects.end()) {
-                                physics_manager.remove(itr->get()->getManifold());
-                                demo_objects.erase(itr);
-                            }
-                            objptr = findHovered();
-                        }while(objptr != nullptr);
+                        auto mouse_pos = io_manager.getMouseWorldPos();
+                        removeDemoObjects([&](const DemoObject& obj) {
+                            return &obj == opts.selection.object || isHovered(obj, mouse_pos);
+                        });
                         opts.selection.object = nullptr;
                         opts.selection.isHolding = false;
                     }break;
                     case sf::Keyboard::Space: {
-                        if(opts.selection.object)
-                            opts.selection.object->rigidbody->isStatic = !opts.selection.object->rigidbody->isStatic;
+                        if(opts.selection.object) {
+                            opts.selection.object->props.isStatic = !opts.selection.object->props.isStatic;
+                            pushProps(opts.selection.object);
+                        }
                     }break;
                     case sf::Keyboard::R: {
-                        if(opts.selection.isHolding)
-                            delete opts.selection.res;
+                        if(opts.selection.isHolding) {
+                            physics_thread.enqueue([this, res = opts.selection.res](PhysicsManager& pm) {
+                                pm.remove(opts.selection.res_handle);
+                                delete res;
+                            });
+                        }
+                        opts.selection.isHolding = false;
                         opts.selection.object = nullptr;
                         opts.poly_creation.clear();
                     }break;
@@ -348,14 +559,28 @@ protected:
     }
 
     void onUpdate(float delT) override {
-        opts.selection.mouse_trans->setPos(io_manager.getMouseWorldPos());
-        if(opts.selection.isHolding && opts.selection.object && opts.selection.object->rigidbody->isStatic) {
-            opts.selection.object->transform->setPos(io_manager.getMouseWorldPos() - rotateVec(opts.selection.pinch_point, opts.selection.object->transform->getRot()));
+        auto& snapshot = physics_thread.getSnapshot();
+        if(physics_thread.acquireSnapshot()) {
+            poses.clear();
+            for(auto& body : snapshot.bodies)
+                poses[body.collider] = &body;
+            std::erase_if(dying, [&](const Dying& d) {
+                return d.command <= snapshot.commands_applied;
+            });
         }
-        for(auto& r : demo_objects) {
-            if(!r.get()->rigidbody->isStatic)
-                r.get()->rigidbody->force += vec2f(0, opts.gravity) * r->rigidbody->mass;
+
+        auto mouse_pos = io_manager.getMouseWorldPos();
+        physics_thread.enqueue([trans = opts.selection.mouse_trans, mouse_pos](PhysicsManager&) { trans->setPos(mouse_pos); });
+        Transform pose;
+        if(opts.selection.isHolding && opts.selection.object && opts.selection.object->props.isStatic && getPose(*opts.selection.object, pose)) {
+            auto trans = opts.selection.object->transform.get();
+            auto pos = mouse_pos - pose.getRotation().rotate(opts.selection.pinch_point);
+            physics_thread.enqueue([trans, pos](PhysicsManager& pm) {
+                trans->setPos(pos);
+                pm.markStaticChanged();
+            });
         }
+        logged_collider = opts.selection.object ? opts.selection.object->collider.get() : nullptr;
         vec2f keyboard_input = {0, 0};
         if(sf::Keyboard::isKeyPressed(sf::Keyboard::W)) {
             keyboard_input.y = -1;
@@ -371,21 +596,10 @@ protected:
         camera.transform.setScale(camera.transform.getScale() + vec2f(scroll_delta, scroll_delta) * delT);
         scroll_delta = 0.f;
 
-        for(auto it = demo_objects.begin(); it != demo_objects.end(); it++) {
-            if(len(it->get()->transform->getPos() - camera.transform.getPos()) > 10000.f) {
-                physics_manager.remove(it->get()->getManifold());
-                demo_objects.erase(it);
-                break;
-            }
-        }
-
-        if(opts.selection.object)
-            opts.selection.object->collider->addObserver(&opts.selection.logger);
-
-        physics_manager.update(delT);
-
-        if(opts.selection.object)
-            opts.selection.object->collider->removeObserver(&opts.selection.logger);
+        removeDemoObjects([&](const DemoObject& obj) {
+            Transform pose;
+            return &obj != opts.selection.object && getPose(obj, pose) && len(pose.getPos() - camera.transform.getPos()) > 10000.f;
+        });
 
         ImGui::Begin("Demo window");
         {
@@ -398,10 +612,12 @@ protected:
                     ImGui::SliderInt("change max fps" , &framerate_max, 1, 1000);
                     this->io_manager.getWindow().setFramerateLimit(static_cast<unsigned int>(framerate_max));
 
-                    static int tsteps = 5;
-                    ImGui::SliderInt("change step count" , &tsteps, 1, 50);
-                    physics_manager.steps = static_cast<unsigned int>(tsteps);
-                    ImGui::SliderFloat("change gravity" , &opts.gravity, -3000.f, 3000.f, "%.1f");
+                    bool isWorldChanged = false;
+                    isWorldChanged |= ImGui::SliderInt("change step count" , &opts.steps, 1, 50);
+                    isWorldChanged |= ImGui::SliderFloat("change gravity" , &opts.gravity, -3000.f, 3000.f, "%.1f");
+                    static int physics_rate = 60;
+                    if(ImGui::SliderInt("physics updates per second", &physics_rate, 10, 480))
+                        physics_thread.setStepTime(1.f / (float)physics_rate);
                     ImGui::SliderFloat("radius" , &opts.default_radius, 5.f, 100.f);
                     ImGui::SliderFloat("radius_deviation" , &opts.radius_dev, 0.f, 1.f);
                     ImGui::Text("poly_sides range:");
@@ -412,15 +628,64 @@ protected:
                     }
                     const char* select_modes[] = { "Min", "Max", "Avg" };
                     {
-                        static int cur_choice_friction = 2;
-                        ImGui::ListBox("choose mode friction", &cur_choice_friction, select_modes, 3);
-                        physics_manager.friction_select = (PhysicsManager::eSelectMode)cur_choice_friction;
+                        int cur_choice_friction = (int)opts.friction_select;
+                        isWorldChanged |= ImGui::ListBox("choose mode friction", &cur_choice_friction, select_modes, 3);
+                        opts.friction_select = (PhysicsManager::eSelectMode)cur_choice_friction;
+                    }
+                    {
+                        int cur_choice_bounce = (int)opts.bounciness_select;
+                        isWorldChanged |= ImGui::ListBox("choose mode bounce", &cur_choice_bounce, select_modes, 3);
+                        opts.bounciness_select = (PhysicsManager::eSelectMode)cur_choice_bounce;
                     }
+                    if(isWorldChanged)
+                        pushWorldSettings();
                     {
-                        static int cur_choice_bounce = 2;
-                        ImGui::ListBox("choose mode bounce", &cur_choice_bounce, select_modes, 3);
-                        physics_manager.bounciness_select = (PhysicsManager::eSelectMode)cur_choice_bounce;
-                    }ImGui::EndTabItem();
+                        const char* responses[] = { "Kill", "Bounce", "Stick" };
+                        int cur_response = (int)particle_settings.response;
+                        bool isChanged = ImGui::ListBox("particles hitting bodies", &cur_response, responses, 3);
+                        particle_settings.response = (eParticleResponse)cur_response;
+                        isChanged |= ImGui::Checkbox("particles push bodies", &particle_settings.isTwoWay);
+                        if(isChanged) {
+                            physics_thread.enqueue([this, settings = particle_settings](PhysicsManager&) {
+                                particles.response = settings.response;
+                                particles.isTwoWay = settings.isTwoWay;
+                            });
+                        }
+                    }
+                    {
+                        static std::string status;
+                        if(ImGui::Button("save scene.epis")) {
+                            physics_thread.stop();
+                            status = saveSnapshot(physics_manager, "scene.epis") ? "saved scene.epis" : "could not write scene.epis";
+                            physics_thread.start();
+                        }
+                        ImGui::SameLine();
+                        if(ImGui::Button("load scene.epis")) {
+                            std::string error;
+                            status = loadScene("scene.epis", error) ? "loaded scene.epis" : error;
+                            opts.gravity = physics_manager.gravity.y;
+                            opts.steps = (int)physics_manager.steps;
+                        }
+                        ImGui::Text("%s", status.c_str());
+                    }
+                    //recorder is attached and detached between updates, so it sees whole updates only
+                    static std::string record_status;
+                    if(!recorder.isOpen()) {
+                        if(ImGui::Button("record session.epir") && recorder.open("session.epir"))
+                            physics_thread.enqueue([this](PhysicsManager& pm) { pm.setRecorder(&recorder); });
+                    } else {
+                        if(ImGui::Button("stop recording")) {
+                            physics_thread.stop();
+                            physics_manager.setRecorder(nullptr);
+                            record_status = "recorded " + std::to_string(recorder.getStepCount()) + " updates";
+                            recorder.close();
+                            physics_thread.start();
+                        }
+                        ImGui::SameLine();
+                        ImGui::Text("recording");
+                    }
+                    ImGui::Text("%s", record_status.c_str());
+                    ImGui::EndTabItem();
                 } 
             }
             {
@@ -434,54 +699,78 @@ protected:
                         }
                         ImGui::Text("NO SELECTION");
                     }else {
-                        ImGui::SliderFloat("mass: ", &obj->rigidbody->mass, 1.f, 20.f);
-                        ImGui::SliderFloat("static_fric: ", &obj->material->sfriction, 0.f, 1.f);
-                        ImGui::SliderFloat("dynamic_fric: ", &obj->material->dfriction, 0.f, 1.f);
-                        ImGui::SliderFloat("bounciness: ", &obj->material->restitution, 0.f, 1.f);
-                        ImGui::SliderFloat("drag: ", &obj->material->air_drag, 0.f, 1.f);
-                        if(ImGui::Button("lockRotation"))
-                            obj->rigidbody->lockRotation = !obj->rigidbody->lockRotation;
-                        if(ImGui::Button("isStatic"))
-                            obj->rigidbody->isStatic = !obj->rigidbody->isStatic;
+                        //ui edits the copy in props, which is sent to physics whenever it changes
+                        auto& props = obj->props;
+                        bool isChanged = false;
+                        isChanged |= ImGui::SliderFloat("mass: ", &props.mass, 1.f, 20.f);
+                        isChanged |= ImGui::SliderFloat("static_fric: ", &props.material.sfriction, 0.f, 1.f);
+                        isChanged |= ImGui::SliderFloat("dynamic_fric: ", &props.material.dfriction, 0.f, 1.f);
+                        isChanged |= ImGui::SliderFloat("bounciness: ", &props.material.restitution, 0.f, 1.f);
+                        isChanged |= ImGui::SliderFloat("drag: ", &props.material.air_drag, 0.f, 1.f);
+                        if(ImGui::Button("lockRotation")) {
+                            props.lockRotation = !props.lockRotation;
+                            isChanged = true;
+                        }
+                        if(ImGui::Button("isStatic")) {
+                            props.isStatic = !props.isStatic;
+                            isChanged = true;
+                        }
 
                         ImGui::Text("===TAGS===");
-                        auto tags = obj->collider->tag.getList();
+                        auto tags = props.tag.getList();
                         for(auto t : tags) {
                             ImGui::Text("->%s", t.c_str());
                             ImGui::SameLine();
                             std::string st = t;
                             st = "remove " + st;
                             if(ImGui::Button(st.c_str())) {
-                                obj->collider->tag.remove(t);
+                                props.tag.remove(t);
+                                isChanged = true;
                             }
                         }
                         static std::string input_tag;
                         if(ImGui::InputText("add_field_tag", (char*)input_tag.c_str(), input_tag.capacity() + 1, ImGuiInputTextFlags_EnterReturnsTrue)) {
-                            obj->collider->tag.add(input_tag.c_str());
+                            props.tag.add(input_tag.c_str());
                             input_tag = "";
+                            isChanged = true;
                         }
 
                         ImGui::Text("===MASKS===");
-                        auto masks = obj->collider->mask.getList();
+                        auto masks = props.mask.getList();
                         for(auto m : masks) {
                             ImGui::Text("->%s", m.c_str());
                             ImGui::SameLine();
                             std::string sm = m;
                             sm = "remove " + sm;
                             if(ImGui::Button(sm.c_str())) {
-                                obj->collider->mask.remove(m);
+                                props.mask.remove(m);
+                                isChanged = true;
                             }
                         }
                         static std::string input_mask;
                         if(ImGui::InputText("add_field_mask", (char*)input_mask.c_str(), input_tag.capacity() + 1, ImGuiInputTextFlags_EnterReturnsTrue)) {
-                            obj->collider->mask.add(input_mask.c_str());
+                            props.mask.add(input_mask.c_str());
                             input_mask = "";
+                            isChanged = true;
                         }
+                        if(isChanged)
+                            pushProps(obj);
                     }
                     ImGui::EndTabItem();
                 }
             }
+            {
+                static bool open_profiler = true;
+                if(ImGui::BeginTabItem("profiler", &open_profiler)) {
+                    drawProfilerTab();
+                    ImGui::EndTabItem();
+                }
+            }
             ImGui::Text("total bodies: %d", int(demo_objects.size()));
+            ImGui::Text("physics updates: %zu", snapshot.update_count);
+            ImGui::Text("particles: %zu", snapshot.particles.size());
+            ImGui::Text("fluid particles: %zu", snapshot.fluid.size());
+            ImGui::Text("physics update: %.3f ms", snapshot.stats.time_total * 1000.0);
             ImGui::Text("delta time: %f", delT);
             ImGui::Text("FPS: %f", 1.f / delT);
             if(delT > 1.0 / 60.0) {
@@ -494,32 +783,61 @@ protected:
     }
     void onRender(sf::RenderTarget& target) override {
         target.clear();
+        renderer.clear();
         //demo
-        for(auto& r : demo_objects) {
-            auto& rb = *r->rigidbody;
+        //everything is drawn from the snapshot, physics thread may be changing the bodies meanwhile
+        //only bodies inside the view are drawn, far zoom draws the tiny ones as boxes
+        auto& snapshot = physics_thread.getSnapshot();
+        auto view = camera.getViewAABB();
+        float lod_size = lod_pixels * view.size().x / (float)target.getSize().x;
+        visible.clear();
+        snapshot.grid.query(view, visible);
+        drawn_bodies = visible.size();
+        Transform pose;
+        for(auto i : visible) {
+            auto& body = snapshot.bodies[i];
             Color color = PastelColor::bg1;
-            if(!rb.isStatic) {
+            if(!body.isStatic) {
                 color = PastelColor::Aqua;
             }
-            if(r->collider->isSleeping) {
+            if(body.isSleeping) {
                 color = PastelColor::Yellow;
             }
-            if(r.get() == opts.selection.object) {
+            if(opts.selection.object && body.collider == opts.selection.object->collider.get()) {
                 color = PastelColor::Red;
             }
-            DrawRigid(r.get()->getManifold(), target, color);
+            auto& aabb = snapshot.grid.getBox(i);
+            if(std::max(aabb.size().x, aabb.size().y) < lod_size) {
+                renderer.addRect(aabb, color);
+                continue;
+            }
+            pose.setPos(body.pos);
+            pose.setRot(body.rot);
+            pose.setScale(body.scale);
+            renderer.addCollider(*body.collider, pose, color);
         }
-        for(auto& v : opts.poly_creation) {
-            const float r = 5.f;
-            sf::CircleShape c(r);
-            c.setPosition(v - vec2f(r, r));
-            c.setFillColor(PastelColor::Red);
-            target.draw(c);
+        //particles are rendered as squares at least lod size big, so that far zoom does not hide them
+        vec2f spark_half = vec2f(1.f, 1.f) * std::max(particles.radius, lod_size / 2.f);
+        for(auto p : snapshot.particles) {
+            if(isOverlappingPointAABB(p, view))
+                renderer.addRect(AABB::CreateMinMax(p - spark_half, p + spark_half), PastelColor::Orange);
         }
+        vec2f drop_half = vec2f(1.f, 1.f) * std::max(fluid.getParticleRadius(), lod_size / 2.f);
+        for(auto p : snapshot.fluid) {
+            if(isOverlappingPointAABB(p, view))
+                renderer.addRect(AABB::CreateMinMax(p - drop_half, p + drop_half), PastelColor::Blue);
+        }
+        for(auto& v : opts.poly_creation)
+            renderer.addCircle(v, 5.f, PastelColor::Red);
+        renderer.draw(target);
         //DEBUG_CALL(debugDraw(target, _physics_manager->getQuadTree(), Color::Magenta));
     }
 public:
     Demo(vec2i s = {800, 800}) : DefaultScene(s) {}
+    ~Demo() {
+        //objects are destroyed before the thread is, so it has to stop using them first
+        physics_thread.stop();
+    }
 };
 
 int main() {
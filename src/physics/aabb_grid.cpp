@@ -0,0 +1,136 @@
+#include "aabb_grid.hpp"
+#include "col_utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace epi {
+
+//boxes spanning more cells than this are not put into cells at all
+static const uint32_t MAX_CELLS_PER_BOX = 16;
+//grid has at most this many cells per box, which bounds memory taken by sparse worlds
+static const size_t MAX_CELL_COUNT_FACTOR = 4;
+
+//index of cell containing v, clamped to grid (also for NaN)
+static uint32_t cellCoord(float v, float origin, float cell_size, uint32_t count) {
+    float c = (v - origin) / cell_size;
+    if(!(c > 0.f))
+        return 0;
+    if(c >= (float)count)
+        return count - 1;
+    return (uint32_t)c;
+}
+static bool isFinite(const AABB& aabb) {
+    return std::isfinite(aabb.min.x) && std::isfinite(aabb.min.y) && std::isfinite(aabb.max.x) && std::isfinite(aabb.max.y);
+}
+AABBGrid::CellRange AABBGrid::m_cellRange(const AABB& aabb) const {
+    return {
+        cellCoord(aabb.min.x, _bounds.min.x, _cell_size.x, _columns),
+        cellCoord(aabb.min.y, _bounds.min.y, _cell_size.y, _rows),
+        cellCoord(aabb.max.x, _bounds.min.x, _cell_size.x, _columns),
+        cellCoord(aabb.max.y, _bounds.min.y, _cell_size.y, _rows)
+    };
+}
+void AABBGrid::clear() {
+    _boxes.clear();
+    _cell_start.clear();
+    _entries.clear();
+    _oversized.clear();
+    _columns = 0;
+    _rows = 0;
+}
+void AABBGrid::build() {
+    _cell_start.clear();
+    _entries.clear();
+    _oversized.clear();
+    _columns = 0;
+    _rows = 0;
+    vec2f min = {INFINITY, INFINITY};
+    vec2f max = {-INFINITY, -INFINITY};
+    vec2f size_sum = {0.f, 0.f};
+    size_t finite_count = 0;
+    for(auto& b : _boxes) {
+        if(!isFinite(b))
+            continue;
+        min.x = std::min(min.x, b.min.x);
+        min.y = std::min(min.y, b.min.y);
+        max.x = std::max(max.x, b.max.x);
+        max.y = std::max(max.y, b.max.y);
+        size_sum += b.size();
+        finite_count++;
+    }
+    if(finite_count == 0) {
+        for(uint32_t i = 0; i < _boxes.size(); i++)
+            _oversized.push_back(i);
+        return;
+    }
+    _bounds = AABB::CreateMinMax(min, max);
+    //cells about twice the size of an average box keep most boxes in at most 4 cells
+    float cell = std::max(std::max(size_sum.x, size_sum.y) / (float)finite_count * 2.f, 1e-3f);
+    auto extent = _bounds.size();
+    //sparse worlds would need many empty cells, there cells grow until their count is bounded
+    float max_cells = (float)(finite_count * MAX_CELL_COUNT_FACTOR);
+    while((std::floor(extent.x / cell) + 1.f) * (std::floor(extent.y / cell) + 1.f) > max_cells)
+        cell *= 2.f;
+    _cell_size = {cell, cell};
+    _columns = (uint32_t)(extent.x / cell) + 1;
+    _rows = (uint32_t)(extent.y / cell) + 1;
+
+    //counting sort, first counts then offsets and at last the entries themselves
+    _cell_start.assign((size_t)_columns * _rows + 1, 0);
+    for(uint32_t i = 0; i < _boxes.size(); i++) {
+        auto& b = _boxes[i];
+        auto r = m_cellRange(b);
+        if(!isFinite(b) || (r.max_x - r.min_x + 1) * (r.max_y - r.min_y + 1) > MAX_CELLS_PER_BOX) {
+            _oversized.push_back(i);
+            continue;
+        }
+        for(uint32_t y = r.min_y; y <= r.max_y; y++)
+            for(uint32_t x = r.min_x; x <= r.max_x; x++)
+                _cell_start[y * _columns + x + 1]++;
+    }
+    for(size_t i = 1; i < _cell_start.size(); i++)
+        _cell_start[i] += _cell_start[i - 1];
+    _entries.resize(_cell_start.back());
+    //every start is used as the place for next entry of its cell
+    for(uint32_t i = 0, next_oversized = 0; i < _boxes.size(); i++) {
+        if(next_oversized < _oversized.size() && _oversized[next_oversized] == i) {
+            next_oversized++;
+            continue;
+        }
+        auto r = m_cellRange(_boxes[i]);
+        for(uint32_t y = r.min_y; y <= r.max_y; y++)
+            for(uint32_t x = r.min_x; x <= r.max_x; x++)
+                _entries[_cell_start[y * _columns + x]++] = i;
+    }
+    //filling moved every start to the start of the next cell, shifting brings them back
+    for(size_t i = _cell_start.size() - 1; i > 0; i--)
+        _cell_start[i] = _cell_start[i - 1];
+    _cell_start[0] = 0;
+}
+void AABBGrid::query(const AABB& area, std::vector<uint32_t>& result) const {
+    for(auto i : _oversized) {
+        if(isOverlappingAABBAABB(_boxes[i], area))
+            result.push_back(i);
+    }
+    if(_columns == 0 || !isOverlappingAABBAABB(_bounds, area))
+        return;
+    auto range = m_cellRange(area);
+    for(uint32_t y = range.min_y; y <= range.max_y; y++) {
+        for(uint32_t x = range.min_x; x <= range.max_x; x++) {
+            auto cell = y * _columns + x;
+            for(auto e = _cell_start[cell]; e < _cell_start[cell + 1]; e++) {
+                auto i = _entries[e];
+                auto& box = _boxes[i];
+                //box spanning many cells is reported only from the first of them inside the queried range
+                auto r = m_cellRange(box);
+                if(x != std::max(r.min_x, range.min_x) || y != std::max(r.min_y, range.min_y))
+                    continue;
+                if(isOverlappingAABBAABB(box, area))
+                    result.push_back(i);
+            }
+        }
+    }
+}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace epi {
+
+/*
+* \brief uniform grid over a set of boxes, filled once and then queried for the boxes overlapping an area
+* cells are stored flat (counting sort into one array), so rebuilding every frame does not allocate once memory is reserved
+* boxes covering too many cells, like long walls, are kept aside and tested by every query
+*/
+class AABBGrid {
+    struct CellRange {
+        uint32_t min_x;
+        uint32_t min_y;
+        uint32_t max_x;
+        uint32_t max_y;
+    };
+    std::vector<AABB> _boxes;
+    AABB _bounds;
+    vec2f _cell_size;
+    uint32_t _columns = 0;
+    uint32_t _rows = 0;
+    //entries of cell i are _entries[_cell_start[i]] up to _entries[_cell_start[i + 1]]
+    std::vector<uint32_t> _cell_start;
+    std::vector<uint32_t> _entries;
+    std::vector<uint32_t> _oversized;
+
+    CellRange m_cellRange(const AABB& aabb) const;
+public:
+    //drops all boxes, keeping memory
+    void clear();
+    //adds box with index equal to number of boxes added before it, grid has to be rebuilt afterwards
+    void push(const AABB& box) {
+        _boxes.push_back(box);
+    }
+    //sorts all pushed boxes into cells, cell size is picked from the boxes themselves
+    void build();
+    //appends indices of all boxes overlapping area to result, every index is reported once
+    void query(const AABB& area, std::vector<uint32_t>& result) const;
+
+    size_t size() const {
+        return _boxes.size();
+    }
+    const AABB& getBox(size_t idx) const {
+        return _boxes[idx];
+    }
+};
+
+}
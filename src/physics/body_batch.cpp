@@ -0,0 +1,17 @@
+#include "body_batch.hpp"
+
+namespace epi {
+
+void BodyBatch::removeFrom(PhysicsManager& manager) const {
+    for(auto h : _handles)
+        manager.remove(h);
+}
+BodyBatch::~BodyBatch() {
+    for(size_t i = 0; i < _count; i++) {
+        _colliders[i].~Collider();
+        _rigidbodies[i].~Rigidbody();
+        _transforms[i].~Transform();
+    }
+}
+
+}
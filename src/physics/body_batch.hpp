@@ -0,0 +1,66 @@
+#pragma once
+#include "physics_manager.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace epi {
+
+/*
+* \brief arrays describing polygon bodies added at once by PhysicsManager::addBatch, per body arrays have count elements
+* shapes and materials are given as palettes indexed by ids, so that thousands of bodies can share a few of them
+* optional arrays can be left nullptr, bodies then start without rotation, at rest, with mass of 1 and first shape or material
+*/
+struct BodyBatchDesc {
+    size_t count = 0;
+    const std::shared_ptr<const ShapeAsset>* shapes = nullptr;
+    size_t shape_count = 0;
+    const uint32_t* shape_ids = nullptr;
+    const vec2f* positions = nullptr;
+    const float* rotations = nullptr;
+    const vec2f* velocities = nullptr;
+    const float* masses = nullptr;
+    //materials are only referenced, so they have to outlive the bodies
+    Material* const* materials = nullptr;
+    size_t material_count = 0;
+    const uint32_t* material_ids = nullptr;
+    bool isStatic = false;
+};
+/*
+* \brief owns components of bodies added together by PhysicsManager::addBatch
+* components of all bodies share a single allocation, each component type in its own array, materials are only referenced
+* has to outlive its bodies' membership in PhysicsManager, so remove them (or destroy the manager) first
+*/
+class BodyBatch {
+    size_t _count = 0;
+    std::unique_ptr<std::byte[]> _storage;
+    Transform* _transforms = nullptr;
+    Rigidbody* _rigidbodies = nullptr;
+    Collider* _colliders = nullptr;
+    Material** _materials = nullptr;
+    std::vector<RigidbodyHandle> _handles;
+
+    BodyBatch() {}
+public:
+    size_t size() const {
+        return _count;
+    }
+    RigidManifold getManifold(size_t idx) {
+        return {&_transforms[idx], &_colliders[idx], &_rigidbodies[idx], _materials[idx]};
+    }
+    RigidbodyHandle getHandle(size_t idx) const {
+        return _handles[idx];
+    }
+    //removes every body of the batch, see PhysicsManager::remove for when the batch can be destroyed
+    void removeFrom(PhysicsManager& manager) const;
+
+    ~BodyBatch();
+    BodyBatch(const BodyBatch&) = delete;
+    BodyBatch& operator=(const BodyBatch&) = delete;
+
+    friend PhysicsManager;
+};
+
+}
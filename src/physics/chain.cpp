@@ -0,0 +1,197 @@
+#include "chain.hpp"
+#include "col_utils.hpp"
+#include "transform.hpp"
+
+#include <algorithm>
+
+namespace epi {
+
+Chain::Chain(std::vector<vec2f> points, bool isLoop) : _points(std::move(points)), _isLoop(isLoop) {
+    assert(_points.size() >= 2);
+    //loop of 2 points would be the same segment twice
+    if(_points.size() < 3)
+        _isLoop = false;
+    vec2f min = _points.front();
+    vec2f max = _points.front();
+    for(auto p : _points) {
+        min = vec2f(std::min(min.x, p.x), std::min(min.y, p.y));
+        max = vec2f(std::max(max.x, p.x), std::max(max.y, p.y));
+    }
+    _aabb = AABB::CreateMinMax(min, max);
+    for(size_t i = 0; i < getSegmentCount(); i++) {
+        auto seg = getSegment(i);
+        _tree.push(AABB::CreateMinMax(vec2f(std::min(seg.a.x, seg.b.x), std::min(seg.a.y, seg.b.y)),
+                                      vec2f(std::max(seg.a.x, seg.b.x), std::max(seg.a.y, seg.b.y))));
+    }
+    _tree.build();
+}
+ChainSegment Chain::getSegment(size_t idx) const {
+    size_t n = _points.size();
+    ChainSegment seg;
+    seg.a = _points[idx];
+    seg.b = _points[(idx + 1) % n];
+    seg.hasPrev = _isLoop || idx > 0;
+    seg.hasNext = _isLoop || idx + 2 < n;
+    seg.prev = seg.hasPrev ? _points[(idx + n - 1) % n] : seg.a;
+    seg.next = seg.hasNext ? _points[(idx + 2) % n] : seg.b;
+    return seg;
+}
+ChainSegment Chain::getSegment(size_t idx, const Transform& trans) const {
+    auto seg = getSegment(idx);
+    seg.a = transformPoint(seg.a, trans);
+    seg.b = transformPoint(seg.b, trans);
+    seg.prev = transformPoint(seg.prev, trans);
+    seg.next = transformPoint(seg.next, trans);
+    return seg;
+}
+void Chain::querySegments(const AABB& area, std::vector<uint32_t>& result) const {
+    _tree.query(area, result);
+}
+void Chain::querySegments(const AABB& area, const Transform& trans, std::vector<uint32_t>& result) const {
+    _tree.query(inverseTransformAABB(area, trans), result);
+}
+
+//same as in Box2D, ghost vertices decide which segment owns the area around a shared point
+static IntersectionPolygonCircleResult intersectCircleSegment(const Circle& circle, const ChainSegment& seg) {
+    IntersectionPolygonCircleResult result = {false};
+    vec2f q = circle.pos;
+    vec2f e = seg.b - seg.a;
+    vec2f n = seg.getNormal();
+    float offset = dot(q - seg.a, n);
+    if(offset < 0.f || offset > circle.radius)
+        return result;
+    float u = dot(e, seg.b - q);
+    float v = dot(e, q - seg.a);
+    vec2f closest;
+    if(v <= 0.f) {
+        if(seg.hasPrev && dot(seg.a - seg.prev, seg.a - q) > 0.f)
+            return result;
+        closest = seg.a;
+    }else if(u <= 0.f) {
+        if(seg.hasNext && dot(seg.next - seg.b, q - seg.b) > 0.f)
+            return result;
+        closest = seg.b;
+    }else {
+        result.detected = true;
+        result.contact_normal = n;
+        result.contact_point = q - n * offset;
+        result.overlap = circle.radius - offset;
+        return result;
+    }
+    vec2f d = q - closest;
+    float dist = len(d);
+    if(dist > circle.radius)
+        return result;
+    result.detected = true;
+    result.contact_normal = dist > 0.f ? d / dist : n;
+    result.contact_point = closest;
+    result.overlap = circle.radius - dist;
+    return result;
+}
+IntersectionPolygonCircleResult intersectCircleChain(const Circle& circle, const Chain& chain, const Transform& trans) {
+    static thread_local std::vector<uint32_t> hits;
+    hits.clear();
+    vec2f r(circle.radius, circle.radius);
+    chain.querySegments(AABB::CreateMinMax(circle.pos - r, circle.pos + r), trans, hits);
+    IntersectionPolygonCircleResult best = {false};
+    for(auto h : hits) {
+        auto res = intersectCircleSegment(circle, chain.getSegment(h, trans));
+        if(res.detected && (!best.detected || res.overlap > best.overlap))
+            best = res;
+    }
+    return best;
+}
+//true if normal k lies between unit normals u and w, which are less than half a turn apart
+static bool isInCone(vec2f k, vec2f u, vec2f w) {
+    float denom = cross(u, w);
+    if(std::abs(denom) < 1e-4f)
+        return dot(k, u) > 0.999f;
+    return cross(k, w) / denom >= 0.f && cross(u, k) / denom >= 0.f;
+}
+//separating axis test where the only axis of the segment is its free side normal
+//and normals of polygon faces are only accepted where ghost vertices allow them
+static IntersectionPolygonChainResult intersectPolygonSegment(const Polygon& poly, const ChainSegment& seg, std::pmr::memory_resource* resource) {
+    IntersectionPolygonChainResult result = {false, {}, std::pmr::vector<vec2f>(resource), 0.f};
+    auto& verts = poly.getVertecies();
+    vec2f center = poly.getPos();
+    vec2f n = seg.getNormal();
+    if(dot(center - seg.a, n) < 0.f)
+        return result;
+    float seg_sep = INFINITY;
+    for(auto p : verts)
+        seg_sep = std::min(seg_sep, dot(p - seg.a, n));
+    if(seg_sep > 0.f)
+        return result;
+
+    float face_sep = -INFINITY;
+    vec2f face_normal;
+    bool isDeepestA = true;
+    for(size_t i = 0; i < verts.size(); i++) {
+        vec2f p0 = verts[i];
+        vec2f edge = verts[(i + 1) % verts.size()] - p0;
+        vec2f m = norm(vec2f(edge.y, -edge.x));
+        if(dot(m, p0 - center) < 0.f)
+            m *= -1.f;
+        float sep_a = dot(seg.a - p0, m);
+        float sep_b = dot(seg.b - p0, m);
+        float sep = std::min(sep_a, sep_b);
+        if(sep > 0.f)
+            return result;
+        if(sep > face_sep) {
+            face_sep = sep;
+            face_normal = m;
+            isDeepestA = sep_a <= sep_b;
+        }
+    }
+    //segment normal is preferred, so that polygons slide over joints between segments
+    static const float FACE_TOLERANCE = 0.1f;
+    bool useFace = face_sep > seg_sep * 0.95f + FACE_TOLERANCE;
+    if(useFace) {
+        vec2f k = -face_normal;
+        vec2f vertex = isDeepestA ? seg.a : seg.b;
+        bool hasGhost = isDeepestA ? seg.hasPrev : seg.hasNext;
+        if(hasGhost) {
+            vec2f ghost = isDeepestA ? seg.prev : seg.next;
+            vec2f other = isDeepestA ? seg.b : seg.a;
+            //neighbouring segment and its normal, oriented the same way as this segment
+            vec2f adj_normal = isDeepestA ? norm(vec2f(vertex.y - ghost.y, ghost.x - vertex.x)) : norm(vec2f(ghost.y - vertex.y, vertex.x - ghost.x));
+            bool isConvex = dot(other - vertex, adj_normal) < 0.f;
+            useFace = isConvex && isInCone(k, adj_normal, n);
+        }
+        if(useFace) {
+            result.detected = true;
+            result.contact_normal = k;
+            result.overlap = -face_sep;
+            result.contact_points.push_back(vertex);
+            return result;
+        }
+    }
+    result.detected = true;
+    result.contact_normal = n;
+    result.overlap = -seg_sep;
+    //polygon points below the segment, moved along it so that they stay within its ends
+    vec2f e = seg.b - seg.a;
+    float e_len2 = qlen(e);
+    for(auto p : verts) {
+        float depth = dot(p - seg.a, n);
+        if(depth > 0.f)
+            continue;
+        float t = std::clamp(dot(p - seg.a, e) / e_len2, 0.f, 1.f);
+        result.contact_points.push_back(seg.a + e * t + n * depth);
+    }
+    return result;
+}
+IntersectionPolygonChainResult intersectPolygonChain(const Polygon& poly, const Chain& chain, const Transform& trans, std::pmr::memory_resource* resource) {
+    static thread_local std::vector<uint32_t> hits;
+    hits.clear();
+    chain.querySegments(AABB::CreateFromPolygon(poly), trans, hits);
+    IntersectionPolygonChainResult best = {false, {}, std::pmr::vector<vec2f>(resource), 0.f};
+    for(auto h : hits) {
+        auto res = intersectPolygonSegment(poly, chain.getSegment(h, trans), resource);
+        if(res.detected && (!best.detected || res.overlap > best.overlap))
+            best = std::move(res);
+    }
+    return best;
+}
+
+}
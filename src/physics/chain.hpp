@@ -0,0 +1,89 @@
+#pragma once
+#include "col_utils.hpp"
+#include "static_bvh.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace epi {
+
+class Transform;
+
+//one segment of a chain with its neighbouring points, all in the same space
+struct ChainSegment {
+    vec2f a;
+    vec2f b;
+    //ghost vertices, points before a and after b, only valid when the chain continues past that end
+    vec2f prev;
+    vec2f next;
+    bool hasPrev;
+    bool hasNext;
+
+    //normal of the free side
+    vec2f getNormal() const {
+        return norm(vec2f(b.y - a.y, a.x - b.x));
+    }
+};
+/*
+* \brief connected line segments used as terrain, one collider instead of a body per tile or wall
+* segment i goes from point i to point i + 1, in loops the last one goes back to the first point
+* only the free side collides, it is on the left when walking along the chain with y growing downwards,
+* so ground drawn from left to right is solid below, loops wound clockwise on screen are solid inside and counter clockwise ones are rooms
+* neighbouring points act as ghost vertices, so bodies sliding along the chain do not catch on corners between segments
+* segments are kept in a bvh, so that only the ones near a body are tested
+*/
+class Chain {
+    std::vector<vec2f> _points;
+    bool _isLoop;
+    StaticBVH _tree;
+    AABB _aabb;
+public:
+    size_t getSegmentCount() const {
+        return _isLoop ? _points.size() : _points.size() - 1;
+    }
+    ChainSegment getSegment(size_t idx) const;
+    //segment placed in the world by transform
+    ChainSegment getSegment(size_t idx, const Transform& trans) const;
+    //appends indices of segments whose bounds overlap area given in model space
+    void querySegments(const AABB& area, std::vector<uint32_t>& result) const;
+    //appends indices of segments near area given in world space, when chain is placed by transform
+    void querySegments(const AABB& area, const Transform& trans, std::vector<uint32_t>& result) const;
+
+    const std::vector<vec2f>& getPoints() const {
+        return _points;
+    }
+    bool isLoop() const {
+        return _isLoop;
+    }
+    //bounds in model space
+    const AABB& getAABB() const {
+        return _aabb;
+    }
+    //points are in space of the transform, so a body at origin without rotation keeps them in world space, at least 2 are needed
+    Chain(std::vector<vec2f> points, bool isLoop = false);
+};
+
+
+struct IntersectionPolygonChainResult {
+    bool detected;
+    vec2f contact_normal;
+    std::pmr::vector<vec2f> contact_points;
+    float overlap;
+};
+/**
+ * Calculates collision of circle with the deepest touching segment of chain placed by transform
+ * @return IntersectionPolygonCircleResult, contact_normal points from the chain towards the circle
+ */
+IntersectionPolygonCircleResult intersectCircleChain(const Circle& circle, const Chain& chain, const Transform& trans);
+/**
+ * Calculates collision of polygon with the deepest touching segment of chain placed by transform
+ * @param resource is where contact points are allocated
+ * @return IntersectionPolygonChainResult, contact_normal points from the chain towards the polygon
+ */
+IntersectionPolygonChainResult intersectPolygonChain(const Polygon& poly, const Chain& chain, const Transform& trans,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+}
@@ -1,14 +1,39 @@
 #include "col_utils.hpp"
+#include "transform.hpp"
 #include "types.hpp"
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
 #include <stdexcept>
 #include <vector>
 namespace epi {
 
-vec2f rotateVec(vec2f vec, float angle) {
-    return vec2f(cos(angle) * vec.x - sin(angle) * vec.y,
-        sin(angle) * vec.x + cos(angle) * vec.y);
+vec2f transformPoint(vec2f p, const Transform& trans) {
+    return trans.getRotation().rotate(p * trans.getScale()) + trans.getPos();
+}
+AABB transformAABB(const AABB& model, const Transform& trans) {
+    vec2f corners[4] = {model.min, model.max, vec2f(model.min.x, model.max.y), vec2f(model.max.x, model.min.y)};
+    vec2f min(INFINITY, INFINITY);
+    vec2f max(-INFINITY, -INFINITY);
+    for(auto c : corners) {
+        vec2f p = transformPoint(c, trans);
+        min = vec2f(std::min(min.x, p.x), std::min(min.y, p.y));
+        max = vec2f(std::max(max.x, p.x), std::max(max.y, p.y));
+    }
+    return AABB::CreateMinMax(min, max);
+}
+AABB inverseTransformAABB(const AABB& area, const Transform& trans) {
+    vec2f corners[4] = {area.min, area.max, vec2f(area.min.x, area.max.y), vec2f(area.max.x, area.min.y)};
+    vec2f scale = trans.getScale();
+    vec2f min(INFINITY, INFINITY);
+    vec2f max(-INFINITY, -INFINITY);
+    for(auto c : corners) {
+        vec2f m = trans.getRotation().inverseRotate(c - trans.getPos());
+        m = vec2f(m.x / scale.x, m.y / scale.y);
+        min = vec2f(std::min(min.x, m.x), std::min(min.y, m.y));
+        max = vec2f(std::max(max.x, m.x), std::max(max.y, m.y));
+    }
+    return AABB::CreateMinMax(min, max);
 }
 #define SQR(x) ((x) * (x))
 bool isOverlappingPointAABB(const vec2f& p, const AABB& r) {
@@ -29,13 +54,6 @@ bool isOverlappingPointPoly(const vec2f& p, const Polygon& poly) {
         }
     return c;
 }
-bool isOverlappingAABBAABB(const AABB& r1, const AABB& r2) {
-    return (
-        r1.min.x <= r2.max.x &&
-        r1.max.x >= r2.min.x &&
-        r1.min.y <= r2.max.y &&
-        r1.max.y >= r2.min.y);
-}
 bool AABBcontainsAABB(const AABB& r1, const AABB& r2) {
     return (r2.min.x >= r1.min.x) && (r2.max.x <= r1.max.x) &&
 				(r2.min.y >= r1.min.y) && (r2.max.y <= r1.max.y);
@@ -147,8 +165,8 @@ bool nearlyEqual(vec2f a, vec2f b) {
     return nearlyEqual(a.x, b.x) && nearlyEqual(a.y, b.y);
 }
 
-std::vector<vec2f> findContactPoints(const Polygon& p0, const Polygon& p1) {
-    std::vector<vec2f> result;
+std::pmr::vector<vec2f> findContactPoints(const Polygon& p0, const Polygon& p1, std::pmr::memory_resource* resource) {
+    std::pmr::vector<vec2f> result(resource);
     const Polygon* poly[] = {&p0, &p1};
     struct Seg {
         char polyID;
@@ -158,11 +176,13 @@ std::vector<vec2f> findContactPoints(const Polygon& p0, const Polygon& p1) {
         //if isEnding then x_start_pos is the beggining of ray else ray is the struct
         Ray ray;
     };
-    std::vector<Seg> all;
-    std::vector<Seg> open[2];
+    //temporaries keep their memory between calls, only result is taken from resource
+    static thread_local std::vector<Seg> all;
+    static thread_local std::vector<Seg> open[2];
+    all.clear();
+    open[0].clear();
+    open[1].clear();
     all.reserve(p1.getVertecies().size() * 2 + p0.getVertecies().size() * 2 );
-    open[0].reserve(p0.getVertecies().size());
-    open[1].reserve(p1.getVertecies().size());
     size_t cur_id = 0;
     for(char i = 0; i < 2; i++) {
         auto prev = poly[i]->getVertecies().back();
@@ -211,7 +231,9 @@ float area(const std::vector<vec2f>& model) {
     }
     return abs(area / 2.0);
 }
-IntersectionPolygonPolygonResult intersectPolygonPolygon(const Polygon &r1, const Polygon &r2) {
+//separating axis test, axis(shape, edge) returns unit axis perpendicular to edge of r1 for shape 0 and of r2 for shape 1
+template<class AxisFunc>
+static IntersectionPolygonPolygonResult intersectPolygonPolygonAxes(const Polygon &r1, const Polygon &r2, AxisFunc axis) {
     const Polygon *poly1 = &r1;
     const Polygon *poly2 = &r2;
 
@@ -224,28 +246,12 @@ IntersectionPolygonPolygonResult intersectPolygonPolygon(const Polygon &r1, cons
             poly2 = &r1;
         }
         for (int a = 0; a < poly1->getVertecies().size(); a++) {
-            int b = (a + 1) % poly1->getVertecies().size();
-            vec2f axisProj = { -(poly1->getVertecies()[b].y - poly1->getVertecies()[a].y), poly1->getVertecies()[b].x - poly1->getVertecies()[a].x };
-            
-            // Optional normalisation of projection axis enhances stability slightly
-            float d = sqrtf(axisProj.x * axisProj.x + axisProj.y * axisProj.y);
-            axisProj = { axisProj.x / d, axisProj.y / d };
+            vec2f axisProj = axis(shape, a);
 
-            // Work out min and max 1D points for r1
-            float min_r1 = INFINITY, max_r1 = -INFINITY;
-            for (int p = 0; p < poly1->getVertecies().size(); p++) {
-                float q = (poly1->getVertecies()[p].x * axisProj.x + poly1->getVertecies()[p].y * axisProj.y);
-                min_r1 = std::min(min_r1, q);
-                max_r1 = std::max(max_r1, q);
-            }
-
-            // Work out min and max 1D points for r2
-            float min_r2 = INFINITY, max_r2 = -INFINITY;
-            for (int p = 0; p < poly2->getVertecies().size(); p++) {
-                float q = (poly2->getVertecies()[p].x * axisProj.x + poly2->getVertecies()[p].y * axisProj.y);
-                min_r2 = std::min(min_r2, q);
-                max_r2 = std::max(max_r2, q);
-            }
+            // Work out min and max 1D points for r1 and r2
+            float min_r1, max_r1, min_r2, max_r2;
+            projectPoints(poly1->getVertecies().data(), poly1->getVertecies().size(), axisProj, min_r1, max_r1);
+            projectPoints(poly2->getVertecies().data(), poly2->getVertecies().size(), axisProj, min_r2, max_r2);
 
             // Calculate actual overlap along projected axis, and store the minimum
             if(std::min(max_r1, max_r2) - std::max(min_r1, min_r2) < overlap) {
@@ -264,6 +270,25 @@ IntersectionPolygonPolygonResult intersectPolygonPolygon(const Polygon &r1, cons
 
     return {true, cn, overlap};
 }
+IntersectionPolygonPolygonResult intersectPolygonPolygon(const Polygon &r1, const Polygon &r2) {
+    const Polygon* poly[] = {&r1, &r2};
+    return intersectPolygonPolygonAxes(r1, r2, [&](int shape, int a) {
+        auto& verts = poly[shape]->getVertecies();
+        int b = (a + 1) % verts.size();
+        vec2f axisProj = { -(verts[b].y - verts[a].y), verts[b].x - verts[a].x };
+        
+        // Optional normalisation of projection axis enhances stability slightly
+        float d = sqrtf(axisProj.x * axisProj.x + axisProj.y * axisProj.y);
+        return vec2f(axisProj.x / d, axisProj.y / d);
+    });
+}
+IntersectionPolygonPolygonResult intersectPolygonPolygon(const Polygon &r1, const std::vector<vec2f>& normals1, const Polygon &r2, const std::vector<vec2f>& normals2) {
+    assert(normals1.size() == r1.getVertecies().size() && normals2.size() == r2.getVertecies().size());
+    const std::vector<vec2f>* normals[] = {&normals1, &normals2};
+    return intersectPolygonPolygonAxes(r1, r2, [&](int shape, int a) {
+        return (*normals[shape])[a];
+    });
+}
 IntersectionPolygonCircleResult intersectCirclePolygon(const Circle &c, const Polygon &r) {
     vec2f max_reach = c.pos + norm(r.getPos() - c.pos) * c.radius;
 
@@ -302,6 +327,11 @@ IntersectionCircleCircleResult intersectCircleCircle(const Circle &c1, const Cir
         return {false};
     }
     float overlap = c1.radius + c2.radius - dist_len;
+    //coincident centers have no defined normal, any direction is fine as long as it is not NaN
+    if(dist_len == 0.f) {
+        dist = vec2f(0.f, 1.f);
+        dist_len = 1.f;
+    }
     vec2f contact_point =  dist / dist_len * c2.radius + c2.pos;
     return {true, dist / dist_len, contact_point, overlap};
 }
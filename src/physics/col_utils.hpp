@@ -1,18 +1,29 @@
 #pragma once
 #include "types.hpp"
 #include <cmath>
+#include <memory_resource>
+#include <vector>
 namespace epi {
+class Transform;
 
-//rotates vetor with respect to the theta by angle in radians
-vec2f rotateVec(vec2f vec, float angle);
+//rotates vetor with respect to the theta by angle in radians, when angle does not change keep a Rotation instead
+inline vec2f rotateVec(vec2f vec, float angle) {
+    return Rotation(angle).rotate(vec);
+}
+//places point given in model space in the world, scaling it first and then rotating
+vec2f transformPoint(vec2f p, const Transform& trans);
+//bounds in world space of box given in model space
+AABB transformAABB(const AABB& model, const Transform& trans);
+//bounds in model space of area given in world space, bigger than area itself only when transform rotates
+AABB inverseTransformAABB(const AABB& area, const Transform& trans);
 //returns true if r1 contains the whole of r2
 bool AABBcontainsAABB(const AABB& r1, const AABB& r2);
 //finds the closest vector to point that lies on ray
 vec2f findClosestPointOnRay(vec2f ray_origin, vec2f ray_dir, vec2f point);
 //finds the closest vetor to point that lies on one of poly's edges
 vec2f findClosestPointOnEdge(vec2f point, const Polygon& poly);
-//returns all of contact points of 2 polygons
-std::vector<vec2f> findContactPoints(const Polygon& r1, const Polygon& r2);
+//returns all of contact points of 2 polygons, result is allocated from resource
+std::pmr::vector<vec2f> findContactPoints(const Polygon& r1, const Polygon& r2, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 //calculates area of polygon whose center should be at {0, 0}
 float area(const std::vector<vec2f>& model);
 //returns true if a and b are nearly equal
@@ -27,7 +38,13 @@ bool isOverlappingPointCircle(const vec2f& p, const Circle& c);
 //returns true if p is within polygon 
 bool isOverlappingPointPoly(const vec2f& p, const Polygon& poly);
 //returns true if aabb and aabb are overlapping
-bool isOverlappingAABBAABB(const AABB& r1, const AABB& r2);
+inline bool isOverlappingAABBAABB(const AABB& r1, const AABB& r2) {
+    return (
+        r1.min.x <= r2.max.x &&
+        r1.max.x >= r2.min.x &&
+        r1.min.y <= r2.max.y &&
+        r1.max.y >= r2.min.y);
+}
 
 /**
  * structure containing all info returned by Ray and AABB intersection
@@ -100,6 +117,12 @@ struct IntersectionPolygonPolygonResult {
  * @return IntersectionPolygonPolygonResult that contains: (in order) [bool]detected, [vec2f]contact_normal, [float]overlap
  */
 IntersectionPolygonPolygonResult intersectPolygonPolygon(const Polygon &r1, const Polygon &r2);
+/**
+ * Same as above, but edge normals are given instead of being calculated from vertices, e.g. ones placed by ShapeAsset::placeNormals
+ * @param normals1 unit normal of every edge of r1 placed in world space, in the same order as its vertices
+ * @return IntersectionPolygonPolygonResult that contains: (in order) [bool]detected, [vec2f]contact_normal, [float]overlap
+ */
+IntersectionPolygonPolygonResult intersectPolygonPolygon(const Polygon &r1, const std::vector<vec2f>& normals1, const Polygon &r2, const std::vector<vec2f>& normals2);
 
 struct IntersectionPolygonCircleResult {
     bool detected;
@@ -1,14 +1,19 @@
 #pragma once
+#include "chain.hpp"
 #include "col_utils.hpp"
-#include "imgui.h"
+#include "compound.hpp"
+#include "shape_asset.hpp"
 #include "transform.hpp"
 #include "types.hpp"
 
 #include <cmath>
 #include <cstddef>
 #include <iterator>
+#include <memory>
+#include <memory_resource>
 #include <vector>
 #include <set>
+#include <variant>
 
 namespace epi {
 class Rigidbody;
@@ -17,17 +22,24 @@ class Collider;
 struct CollisionInfo {
     bool detected;
     vec2f cn;
-    std::vector<vec2f> cps;
+    //allocated from the resource given to SolverInterface::detect, copies use the default resource
+    std::pmr::vector<vec2f> cps;
     float overlap;
 };
 //diffrent types of colliders
 enum class eCollisionShape {
     Polygon,
     Circle,
-    Ray
+    Ray,
+    Chain,
+    Compound
 };
 //calculating inertia of polygon shape
 float calculateInertia(vec2f pos, const std::vector<vec2f>& model, float mass);
+//inertia of chain as thin rods around origin of its model, mass is spread by length of segments
+float calculateChainInertia(const Chain& chain, float mass);
+//inertia of all children around origin of compound's model, mass is spread by area of children
+float calculateCompoundInertia(const Compound& compound, float mass);
 /*
 * \brief Interface Class for creating collider classes , an extension of GAMEOBJECT
 *(has prop list and notifies of death)
@@ -44,21 +56,9 @@ struct ColliderEvent {
     CollisionInfo info;
 };
 class Collider : public Signal::Subject<ColliderEvent> {
-    float m_inertia_dev_mass = -1.f;
-    union {
-        struct {
-            AABB aabb;
-            Circle shape;
-        }_circle;
-        struct {
-            Polygon shape;
-            vec2f scale;
-        }_polygon;
-        struct {
-            Ray shape;
-            vec2f scale;
-        }_ray;
-    };
+    //polygons, chains and compounds are immutable and can be shared by many colliders, circles and rays are small enough to be copied
+    std::variant<std::shared_ptr<const ShapeAsset>, Circle, Ray, std::shared_ptr<const Chain>, std::shared_ptr<const Compound>> _shape;
+    float _unit_inertia = 0.f;
 public:
     Tag tag;
     Tag mask;
@@ -71,39 +71,77 @@ public:
 
     Circle getCircleShape(Transform& trans) const {
         assert(type == eCollisionShape::Circle);
-        auto t = _circle.shape;
+        auto t = std::get<Circle>(_shape);
         t.pos = trans.getPos();
         return t;
     }
     Polygon getPolygonShape(Transform& trans) const {
-        assert(type == eCollisionShape::Polygon);
-        auto t = _polygon.shape;
-        t.setPos(trans.getPos());
-        t.setRot(trans.getRot());
-        t.setScale(trans.getScale());
+        Polygon t;
+        getPolygonShape(trans, t);
         return t;
     }
+    //places polygon in result, reusing its memory
+    void getPolygonShape(Transform& trans, Polygon& result) const {
+        assert(type == eCollisionShape::Polygon);
+        result.setModel(getPolygonAsset().getModel(), trans.getPos(), trans.getRot(), trans.getRotation(), trans.getScale());
+    }
     Ray getRayShape(Transform& trans) const {
-        auto t = _ray.shape;
-        t.dir = rotateVec(t.dir, trans.getRot());
+        auto t = std::get<Ray>(_shape);
+        t.dir = trans.getRotation().rotate(t.dir);
         t.pos = trans.getPos();
         t.pos -= t.dir / 2.f;
         return t;
     }
 
+    //shapes as they were given to the constructor, transform is not applied
+    const Circle& getCircleModel() const {
+        assert(type == eCollisionShape::Circle);
+        return std::get<Circle>(_shape);
+    }
+    const ShapeAsset& getPolygonAsset() const {
+        assert(type == eCollisionShape::Polygon);
+        return *std::get<std::shared_ptr<const ShapeAsset>>(_shape);
+    }
+    //can be given to other colliders, so that they share the same asset
+    const std::shared_ptr<const ShapeAsset>& getPolygonAssetPtr() const {
+        assert(type == eCollisionShape::Polygon);
+        return std::get<std::shared_ptr<const ShapeAsset>>(_shape);
+    }
+    const Ray& getRayModel() const {
+        assert(type == eCollisionShape::Ray);
+        return std::get<Ray>(_shape);
+    }
+    //chains are never moved into world space as a whole, segments are placed by transform one at a time
+    const Chain& getChainModel() const {
+        assert(type == eCollisionShape::Chain);
+        return *std::get<std::shared_ptr<const Chain>>(_shape);
+    }
+    //children are placed in the world one at a time as well
+    const Compound& getCompoundModel() const {
+        assert(type == eCollisionShape::Compound);
+        return *std::get<std::shared_ptr<const Compound>>(_shape);
+    }
+
     virtual AABB getAABB(Transform& trans) { 
         switch(type) {
             case eCollisionShape::Circle: {
-                auto t = _circle.aabb;
-                t.setCenter(trans.getPos());
-                return t;
+                auto& c = getCircleModel();
+                vec2f r(c.radius, c.radius);
+                return AABB::CreateMinMax(trans.getPos() - r, trans.getPos() + r);
             }
             case eCollisionShape::Polygon: {
-                auto t = _polygon.shape;
-                t.setPos(trans.getPos());
-                t.setRot(trans.getRot());
-                t.setScale(trans.getScale());
-                return AABB::CreateFromPolygon(t);
+                //vertices are placed the same way as in Polygon, without copying them anywhere
+                auto& model = getPolygonAsset().getModel();
+                Rotation rot = trans.getRotation();
+                vec2f scale = trans.getScale();
+                vec2f min(INFINITY, INFINITY);
+                vec2f max(-INFINITY, -INFINITY);
+                for(auto t : model) {
+                    vec2f p = rot.rotate(t) * scale;
+                    min = vec2f(std::min(min.x, p.x), std::min(min.y, p.y));
+                    max = vec2f(std::max(max.x, p.x), std::max(max.y, p.y));
+                }
+                return AABB::CreateMinMax(min + trans.getPos(), max + trans.getPos());
             }
             case eCollisionShape::Ray: {
                 auto t = getRayShape(trans);
@@ -114,39 +152,50 @@ public:
                 max.y = std::max(t.pos.y, t.pos.y + t.dir.y);
                 return AABB::CreateMinMax(min, max);
             }
-
+            case eCollisionShape::Chain:
+                return transformAABB(getChainModel().getAABB(), trans);
+            case eCollisionShape::Compound:
+                return transformAABB(getCompoundModel().getAABB(), trans);
         }
     }
-    float calcInertia(float mass) {
+    float calcInertia(float mass) const {
         switch(type) {
             case eCollisionShape::Circle:
-                return 0.25f * mass * _circle.shape.radius * _circle.shape.radius;
+                return 0.25f * mass * getCircleModel().radius * getCircleModel().radius;
             case eCollisionShape::Polygon:
-                return calculateInertia(vec2f(0, 0), _polygon.shape.getModelVertecies(), mass); 
+                return getPolygonAsset().getUnitInertia() * mass;
             case eCollisionShape::Ray:
-                return 0.08333f * mass * qlen(_ray.shape.dir); 
+                return 0.08333f * mass * qlen(getRayModel().dir); 
+            case eCollisionShape::Chain:
+                return calculateChainInertia(getChainModel(), mass);
+            case eCollisionShape::Compound:
+                return calculateCompoundInertia(getCompoundModel(), mass);
         }
     }
-    float getInertia(float mass) {
-        if(m_inertia_dev_mass == -1.f) {
-            m_inertia_dev_mass = calcInertia(mass) / mass;
-        }
-        return m_inertia_dev_mass * mass;
+    //every shape's inertia is linear in mass, so it is calculated once for mass of 1
+    float getInertia(float mass) const {
+        return _unit_inertia * mass;
     }
 
     Collider() = delete;
-    Collider(Ray ray) : type(eCollisionShape::Ray) { 
-        _ray.shape = ray;
+    Collider(Ray ray) : _shape(ray), type(eCollisionShape::Ray) { 
+        _unit_inertia = calcInertia(1.f);
+    }
+    //model of polygon is looked up in the registry, position and rotation are taken from transform instead
+    Collider(const Polygon& poly) : Collider(ShapeAsset::Get(poly.getModelVertecies())) {}
+    Collider(std::shared_ptr<const ShapeAsset> asset) : _shape(std::move(asset)), type(eCollisionShape::Polygon) {
+        _unit_inertia = calcInertia(1.f);
     }
-    Collider(Polygon poly) : type(eCollisionShape::Polygon) { 
-        _polygon.shape = poly;
+    Collider(Chain chain) : _shape(std::make_shared<const Chain>(std::move(chain))), type(eCollisionShape::Chain) {
+        _unit_inertia = calcInertia(1.f);
     }
-    Collider(Circle c) : type(eCollisionShape::Circle) {
-        _circle.shape = c;
-        _circle.aabb = AABB::CreateMinMax(_circle.shape.pos - vec2f(_circle.shape.radius, _circle.shape.radius), _circle.shape.pos+ vec2f(_circle.shape.radius, _circle.shape.radius) );
+    Collider(Compound compound) : _shape(std::make_shared<const Compound>(std::move(compound))), type(eCollisionShape::Compound) {
+        _unit_inertia = calcInertia(1.f);
     }
-    virtual ~Collider() {
+    Collider(Circle c) : _shape(c), type(eCollisionShape::Circle) {
+        _unit_inertia = calcInertia(1.f);
     }
+    virtual ~Collider() {}
 };
 
 }
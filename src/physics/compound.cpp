@@ -0,0 +1,255 @@
+#include "compound.hpp"
+#include "transform.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace epi {
+
+//merged pieces are capped, so that narrowphase between two of them stays cheap
+static const size_t MAX_PIECE_VERTICES = 8;
+
+static bool fail(std::string* error, const char* message) {
+    if(error)
+        *error = message;
+    return false;
+}
+static float signedArea(const std::vector<vec2f>& points) {
+    float result = 0.f;
+    for(size_t i = 0; i < points.size(); i++)
+        result += cross(points[i], points[(i + 1) % points.size()]);
+    return result / 2.f;
+}
+static bool isSegmentCrossingSegment(vec2f a0, vec2f a1, vec2f b0, vec2f b1) {
+    float d0 = cross(a1 - a0, b0 - a0);
+    float d1 = cross(a1 - a0, b1 - a0);
+    float d2 = cross(b1 - b0, a0 - b0);
+    float d3 = cross(b1 - b0, a1 - b0);
+    return ((d0 > 0.f) != (d1 > 0.f)) && ((d2 > 0.f) != (d3 > 0.f));
+}
+//true if p is inside of triangle abc wound counter clockwise, points on edges count as inside
+static bool isInTriangle(vec2f p, vec2f a, vec2f b, vec2f c) {
+    return cross(b - a, p - a) >= 0.f && cross(c - b, p - b) >= 0.f && cross(a - c, p - c) >= 0.f;
+}
+//outline without repeated and collinear points, wound counter clockwise, cleaned in place
+static bool cleanOutline(std::vector<vec2f>& outline, std::string* error) {
+    vec2f min(INFINITY, INFINITY);
+    vec2f max(-INFINITY, -INFINITY);
+    for(auto p : outline) {
+        min = vec2f(std::min(min.x, p.x), std::min(min.y, p.y));
+        max = vec2f(std::max(max.x, p.x), std::max(max.y, p.y));
+    }
+    //tolerance relative to the size of outline, so that it works the same at every scale
+    float eps = std::max(max.x - min.x, max.y - min.y) * 1e-5f;
+    bool isChanged = true;
+    while(isChanged && outline.size() >= 3) {
+        isChanged = false;
+        for(size_t i = 0; i < outline.size() && outline.size() >= 3; i++) {
+            vec2f prev = outline[(i + outline.size() - 1) % outline.size()];
+            vec2f next = outline[(i + 1) % outline.size()];
+            vec2f e0 = outline[i] - prev;
+            vec2f e1 = next - outline[i];
+            if(len(e0) <= eps || std::abs(cross(e0, e1)) <= eps * (len(e0) + len(e1))) {
+                outline.erase(outline.begin() + i);
+                isChanged = true;
+                i--;
+            }
+        }
+    }
+    if(outline.size() < 3)
+        return fail(error, "outline has less than 3 distinct points");
+    if(signedArea(outline) < 0.f)
+        std::reverse(outline.begin(), outline.end());
+    size_t n = outline.size();
+    for(size_t i = 0; i < n; i++) {
+        //neighbouring edges share a point, so only edges at least 2 apart can cross
+        for(size_t j = i + 2; j < n; j++) {
+            if(i == 0 && j == n - 1)
+                continue;
+            if(isSegmentCrossingSegment(outline[i], outline[(i + 1) % n], outline[j], outline[(j + 1) % n]))
+                return fail(error, "outline intersects itself");
+        }
+    }
+    return true;
+}
+static bool isConvexLoop(const std::vector<vec2f>& points, const std::vector<uint32_t>& loop) {
+    for(size_t i = 0; i < loop.size(); i++) {
+        vec2f a = points[loop[(i + loop.size() - 1) % loop.size()]];
+        vec2f b = points[loop[i]];
+        vec2f c = points[loop[(i + 1) % loop.size()]];
+        if(cross(b - a, c - b) < 0.f)
+            return false;
+    }
+    return true;
+}
+//triangulation by ear clipping, triangles are wound the same way as outline
+static bool clipEars(const std::vector<vec2f>& points, std::vector<std::vector<uint32_t>>& triangles, std::string* error) {
+    std::vector<uint32_t> left(points.size());
+    for(size_t i = 0; i < left.size(); i++)
+        left[i] = (uint32_t)i;
+    while(left.size() > 3) {
+        bool isClipped = false;
+        for(size_t i = 0; i < left.size(); i++) {
+            uint32_t ia = left[(i + left.size() - 1) % left.size()];
+            uint32_t ib = left[i];
+            uint32_t ic = left[(i + 1) % left.size()];
+            vec2f a = points[ia];
+            vec2f b = points[ib];
+            vec2f c = points[ic];
+            if(cross(b - a, c - b) <= 0.f)
+                continue;
+            bool isEar = true;
+            for(auto j : left) {
+                if(j != ia && j != ib && j != ic && isInTriangle(points[j], a, b, c)) {
+                    isEar = false;
+                    break;
+                }
+            }
+            if(!isEar)
+                continue;
+            triangles.push_back({ia, ib, ic});
+            left.erase(left.begin() + i);
+            isClipped = true;
+            break;
+        }
+        if(!isClipped)
+            return fail(error, "outline could not be triangulated");
+    }
+    triangles.push_back(left);
+    return true;
+}
+//Hertel-Mehlhorn, pieces sharing an edge are joined whenever the result is still convex
+static void mergePieces(const std::vector<vec2f>& points, std::vector<std::vector<uint32_t>>& pieces) {
+    std::vector<uint32_t> merged;
+    bool isMerged = true;
+    while(isMerged) {
+        isMerged = false;
+        for(size_t i = 0; i < pieces.size() && !isMerged; i++) {
+            for(size_t j = i + 1; j < pieces.size() && !isMerged; j++) {
+                auto& p = pieces[i];
+                auto& q = pieces[j];
+                if(p.size() + q.size() - 2 > MAX_PIECE_VERTICES)
+                    continue;
+                //edge a -> b of p is walked b -> a by q
+                for(size_t ei = 0; ei < p.size() && !isMerged; ei++) {
+                    uint32_t a = p[ei];
+                    uint32_t b = p[(ei + 1) % p.size()];
+                    auto it = std::find(q.begin(), q.end(), b);
+                    if(it == q.end() || q[(it - q.begin() + 1) % q.size()] != a)
+                        continue;
+                    size_t ej = it - q.begin();
+                    merged.clear();
+                    //p from b around to a, then q from a around to b without the shared points
+                    for(size_t k = 0; k < p.size(); k++)
+                        merged.push_back(p[(ei + 1 + k) % p.size()]);
+                    for(size_t k = 2; k < q.size(); k++)
+                        merged.push_back(q[(ej + k) % q.size()]);
+                    if(!isConvexLoop(points, merged))
+                        continue;
+                    p = merged;
+                    pieces.erase(pieces.begin() + j);
+                    isMerged = true;
+                }
+            }
+        }
+    }
+}
+std::vector<std::vector<vec2f>> decomposeConvex(std::vector<vec2f> outline, std::string* error) {
+    std::vector<std::vector<vec2f>> result;
+    if(!cleanOutline(outline, error))
+        return result;
+    std::vector<std::vector<uint32_t>> pieces;
+    if(!clipEars(outline, pieces, error))
+        return result;
+    mergePieces(outline, pieces);
+    for(auto& piece : pieces) {
+        result.emplace_back();
+        for(auto idx : piece)
+            result.back().push_back(outline[idx]);
+    }
+    return result;
+}
+
+Compound::Compound(std::vector<Polygon> polygons, std::vector<Circle> circles) : _polygons(std::move(polygons)), _circles(std::move(circles)) {
+    assert(getChildCount() != 0);
+    for(auto& p : _polygons)
+        _tree.push(AABB::CreateFromPolygon(p));
+    for(auto& c : _circles)
+        _tree.push(AABB::CreateFromCircle(c));
+    _tree.build();
+    _aabb = _tree.getBox(0);
+    for(size_t i = 1; i < _tree.size(); i++) {
+        auto& box = _tree.getBox(i);
+        _aabb.min = vec2f(std::min(_aabb.min.x, box.min.x), std::min(_aabb.min.y, box.min.y));
+        _aabb.max = vec2f(std::max(_aabb.max.x, box.max.x), std::max(_aabb.max.y, box.max.y));
+    }
+}
+Compound Compound::CreateFromOutline(const std::vector<vec2f>& outline, std::string* error) {
+    auto pieces = decomposeConvex(outline, error);
+    if(pieces.empty())
+        pieces = {outline};
+    //center of mass of all pieces, weighted by their areas
+    float total_area = 0.f;
+    vec2f center(0.f, 0.f);
+    for(auto& piece : pieces) {
+        for(size_t i = 0; i < piece.size(); i++) {
+            vec2f a = piece[i];
+            vec2f b = piece[(i + 1) % piece.size()];
+            float step = cross(a, b) / 2.f;
+            total_area += step;
+            center += (a + b) * step / 3.f;
+        }
+    }
+    if(total_area != 0.f)
+        center /= total_area;
+    else
+        center = outline.front();
+    std::vector<Polygon> polygons;
+    for(auto& piece : pieces) {
+        for(auto& p : piece)
+            p -= center;
+        polygons.push_back(Polygon::CreateFromPoints(piece));
+    }
+    Compound result(std::move(polygons));
+    result._pos = center;
+    return result;
+}
+Polygon Compound::getPolygon(size_t idx, const Transform& trans) const {
+    Polygon result;
+    getPolygon(idx, trans, result);
+    return result;
+}
+void Compound::getPolygon(size_t idx, const Transform& trans, Polygon& result) const {
+    auto& model = _polygons[idx];
+    result.setModel(model.getModelVertecies(), transformPoint(model.getPos(), trans), model.getRot() + trans.getRot(),
+                    model.getRotation() * trans.getRotation(), trans.getScale());
+}
+Circle Compound::getCircle(size_t idx, const Transform& trans) const {
+    //radius ignores scale, same as in circle colliders
+    return Circle(transformPoint(_circles[idx].pos, trans), _circles[idx].radius);
+}
+void Compound::queryChildren(const AABB& area, const Transform& trans, std::vector<uint32_t>& result) const {
+    _tree.query(inverseTransformAABB(area, trans), result);
+}
+
+IntersectionPolygonCircleResult intersectCircleCompound(const Circle& circle, const Compound& compound, const Transform& trans) {
+    static thread_local std::vector<uint32_t> hits;
+    static thread_local Polygon placed;
+    hits.clear();
+    compound.queryChildren(AABB::CreateFromCircle(circle), trans, hits);
+    IntersectionPolygonCircleResult best = {false};
+    for(auto h : hits) {
+        IntersectionPolygonCircleResult res;
+        if(compound.isPolygon(h)) {
+            compound.getPolygon(h, trans, placed);
+            res = intersectCirclePolygon(circle, placed);
+        }else {
+            res = intersectCircleCircle(circle, compound.getCircle(h - compound.getPolygonCount(), trans));
+        }
+        if(res.detected && (!best.detected || res.overlap > best.overlap))
+            best = res;
+    }
+    return best;
+}
+
+}
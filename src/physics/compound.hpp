@@ -0,0 +1,86 @@
+#pragma once
+#include "col_utils.hpp"
+#include "static_bvh.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace epi {
+
+class Transform;
+
+/*
+* splits simple polygon outline, given in any winding, into convex pieces
+* concave outline is triangulated by clipping ears and triangles are then merged back for as long as result stays convex
+* returns empty vector and sets error if outline has less than 3 distinct points or intersects itself
+*/
+std::vector<std::vector<vec2f>> decomposeConvex(std::vector<vec2f> outline, std::string* error = nullptr);
+
+/*
+* \brief several convex polygons and circles attached to one rigidbody, which is then a single broadphase entry
+* children are placed in model space around origin of the body, which should be their center of mass
+* every child keeps its own position and rotation inside of the body, children are kept in a bvh,
+* so that only the ones near the other shape are tested
+* children of the same compound never collide with each other
+*/
+class Compound {
+    std::vector<Polygon> _polygons;
+    std::vector<Circle> _circles;
+    StaticBVH _tree;
+    AABB _aabb;
+    vec2f _pos = {0.f, 0.f};
+public:
+    //children are indexed with polygons first, circle i has index getPolygonCount() + i
+    size_t getChildCount() const {
+        return _polygons.size() + _circles.size();
+    }
+    size_t getPolygonCount() const {
+        return _polygons.size();
+    }
+    size_t getCircleCount() const {
+        return _circles.size();
+    }
+    bool isPolygon(size_t child) const {
+        return child < _polygons.size();
+    }
+    //children in model space
+    const std::vector<Polygon>& getPolygons() const {
+        return _polygons;
+    }
+    const std::vector<Circle>& getCircles() const {
+        return _circles;
+    }
+    //child placed in the world by transform, indices are those of getPolygons and getCircles
+    Polygon getPolygon(size_t idx, const Transform& trans) const;
+    //places polygon in result, reusing its memory
+    void getPolygon(size_t idx, const Transform& trans, Polygon& result) const;
+    Circle getCircle(size_t idx, const Transform& trans) const;
+    //appends indices of children whose bounds overlap area given in world space
+    void queryChildren(const AABB& area, const Transform& trans, std::vector<uint32_t>& result) const;
+    //bounds in model space
+    const AABB& getAABB() const {
+        return _aabb;
+    }
+    //position at which body has to be placed for children to cover outline given to CreateFromOutline
+    vec2f getPos() const {
+        return _pos;
+    }
+
+    Compound(std::vector<Polygon> polygons, std::vector<Circle> circles = {});
+    /*
+    * splits outline into convex polygons centered around their common center of mass, which is returned by getPos
+    * if outline cannot be split sets error and falls back to a single polygon, as Polygon::CreateFromPoints would make
+    */
+    static Compound CreateFromOutline(const std::vector<vec2f>& outline, std::string* error = nullptr);
+};
+
+/**
+ * Calculates collision of circle with the deepest touching child of compound placed by transform
+ * @return IntersectionPolygonCircleResult, contact_normal points from the compound towards the circle
+ */
+IntersectionPolygonCircleResult intersectCircleCompound(const Circle& circle, const Compound& compound, const Transform& trans);
+
+}
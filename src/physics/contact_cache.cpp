@@ -0,0 +1,94 @@
+#include "contact_cache.hpp"
+
+#include <numeric>
+
+namespace epi {
+
+static vec2f avgContactPoint(const CollisionInfo& info) {
+    if(info.cps.size() == 0)
+        return vec2f(0, 0);
+    return std::reduce(info.cps.begin(), info.cps.end()) / (float)info.cps.size();
+}
+size_t ContactCache::m_hash(const Collider* a, const Collider* b) {
+    if(b < a)
+        std::swap(a, b);
+    uint64_t h = reinterpret_cast<uintptr_t>(a) * 0x9e3779b97f4a7c15ull;
+    h ^= reinterpret_cast<uintptr_t>(b) + 0x7f4a7c159e3779b9ull + (h << 6) + (h >> 2);
+    return (size_t)(h ^ (h >> 29));
+}
+uint32_t& ContactCache::m_findSlot(const Collider* a, const Collider* b) {
+    size_t mask = _index.size() - 1;
+    size_t i = m_hash(a, b) & mask;
+    while(true) {
+        auto& slot = _index[i];
+        if(slot == EMPTY_SLOT)
+            return slot;
+        auto& e = _entries[slot];
+        if((e.a == a && e.b == b) || (e.a == b && e.b == a))
+            return slot;
+        i = (i + 1) & mask;
+    }
+}
+void ContactCache::m_rebuildIndex(size_t capacity) {
+    _index.assign(capacity, EMPTY_SLOT);
+    for(size_t i = 0; i < _entries.size(); i++)
+        m_findSlot(_entries[i].a, _entries[i].b) = (uint32_t)i;
+}
+void ContactCache::touch(Collider* a, Collider* b, const CollisionInfo& info) {
+    if((_entries.size() + 1) * 2 > _index.size())
+        m_rebuildIndex(std::max<size_t>(64, _index.size() * 2));
+    auto& slot = m_findSlot(a, b);
+    if(slot == EMPTY_SLOT) {
+        slot = (uint32_t)_entries.size();
+        _entries.push_back({a, b, info.cn, avgContactPoint(info), info.overlap, true, true});
+        return;
+    }
+    auto& entry = _entries[slot];
+    entry.cn = entry.a == a ? info.cn : -info.cn;
+    entry.cp = avgContactPoint(info);
+    entry.overlap = info.overlap;
+    entry.touched = true;
+}
+void ContactCache::touch(Collider* a, Collider* b) {
+    touch(a, b, {true, vec2f(0, 0), {}, 0.f});
+}
+void ContactCache::flush(std::vector<ContactEvent>& out) {
+    size_t kept = 0;
+    for(size_t i = 0; i < _entries.size(); i++) {
+        auto entry = _entries[i];
+        if(!entry.touched) {
+            out.push_back({eContactState::End, entry.a, entry.b, entry.cn, entry.cp, entry.overlap});
+            continue;
+        }
+        out.push_back({entry.isNew ? eContactState::Begin : eContactState::Persist, entry.a, entry.b, entry.cn, entry.cp, entry.overlap});
+        entry.isNew = false;
+        entry.touched = false;
+        _entries[kept++] = entry;
+    }
+    bool changed = kept != _entries.size();
+    _entries.resize(kept);
+    if(changed)
+        m_rebuildIndex(_index.size());
+}
+void ContactCache::remove(const std::unordered_set<const Collider*>& removed, std::vector<Collider*>& partners) {
+    size_t kept = 0;
+    for(size_t i = 0; i < _entries.size(); i++) {
+        auto entry = _entries[i];
+        bool removedA = removed.contains(entry.a);
+        bool removedB = removed.contains(entry.b);
+        if(removedA || removedB) {
+            if(!removedA)
+                partners.push_back(entry.a);
+            if(!removedB)
+                partners.push_back(entry.b);
+            continue;
+        }
+        _entries[kept++] = entry;
+    }
+    bool changed = kept != _entries.size();
+    _entries.resize(kept);
+    if(changed)
+        m_rebuildIndex(_index.size());
+}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "collider.hpp"
+#include "types.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+
+namespace epi {
+
+enum class eContactState {
+    Begin,
+    Persist,
+    End
+};
+/*
+* \brief single entry of per frame contact buffer
+* a and b are in the order in which the pair was first detected, cn points from b to a
+* for End events cn, cp and overlap are the values from the last frame the pair was touching
+* trigger events have no geometry, their cn, cp and overlap are always zero
+*/
+struct ContactEvent {
+    eContactState state;
+    Collider* a;
+    Collider* b;
+    vec2f cn;
+    vec2f cp;
+    float overlap;
+};
+/*
+* \brief remembers which collider pairs were touching last frame to derive begin/persist/end transitions
+* pairs are kept in order of first detection, so events come out in the same order on every run
+*/
+class ContactCache {
+    struct Entry {
+        Collider* a;
+        Collider* b;
+        vec2f cn;
+        vec2f cp;
+        float overlap;
+        bool isNew;
+        bool touched;
+    };
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    std::vector<Entry> _entries;
+    //open addressing table of indices into _entries, kept at most half full
+    //it owns no nodes, so copying whole cache reuses already allocated memory
+    std::vector<uint32_t> _index;
+
+    static size_t m_hash(const Collider* a, const Collider* b);
+    //slot holding pair a, b or empty slot where it should be inserted
+    uint32_t& m_findSlot(const Collider* a, const Collider* b);
+    void m_rebuildIndex(size_t capacity);
+public:
+    //marks pair as touching this frame, can be called multiple times per frame (once per substep)
+    void touch(Collider* a, Collider* b, const CollisionInfo& info);
+    //marks pair as overlapping without any contact geometry, used for triggers
+    void touch(Collider* a, Collider* b);
+    /*
+    * marks pairs that were not touched this frame as touching when isResting(collider) is true for both of their colliders
+    * resting bodies are not tested against each other at all, so without it their contacts would end as soon as they fall asleep
+    */
+    template<class IsResting>
+    void touchResting(IsResting isResting) {
+        for(auto& e : _entries)
+            if(!e.touched && isResting(e.a) && isResting(e.b))
+                e.touched = true;
+    }
+    //appends begin/persist/end events to out and forgets pairs that stopped touching
+    void flush(std::vector<ContactEvent>& out);
+    //forgets every pair containing any of removed colliders without generating events, colliders that were touching them are appended to partners
+    void remove(const std::unordered_set<const Collider*>& removed, std::vector<Collider*>& partners);
+
+    size_t size() const { return _entries.size(); }
+    void clear() {
+        _entries.clear();
+        std::fill(_index.begin(), _index.end(), EMPTY_SLOT);
+    }
+};
+
+}
@@ -0,0 +1,283 @@
+#include "fluid_manager.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace epi {
+
+//particles handed to one thread at a time
+static const size_t BLOCK_SIZE = 512;
+//cells far away are clamped, which only makes far particles share buckets
+static const float MAX_CELL = 1e9f;
+//neighbours are searched this many smoothing radii away, particles moving less than the difference during a step miss nobody
+static const float NEIGHBOUR_SKIN = 1.25f;
+
+size_t FluidManager::spawn(vec2f pos, vec2f vel) {
+    _pos_x.push_back(pos.x);
+    _pos_y.push_back(pos.y);
+    _vel_x.push_back(vel.x);
+    _vel_y.push_back(vel.y);
+    _prev_x.push_back(pos.x);
+    _prev_y.push_back(pos.y);
+    _density.push_back(0.f);
+    _near_density.push_back(0.f);
+    _delta_x.push_back(0.f);
+    _delta_y.push_back(0.f);
+    return _pos_x.size() - 1;
+}
+void FluidManager::spawnBlock(const AABB& area, vec2f vel) {
+    for(float y = area.min.y + spacing / 2.f; y < area.max.y; y += spacing)
+        for(float x = area.min.x + spacing / 2.f; x < area.max.x; x += spacing)
+            spawn({x, y}, vel);
+}
+void FluidManager::reserve(size_t count) {
+    for(auto v : {&_pos_x, &_pos_y, &_vel_x, &_vel_y, &_prev_x, &_prev_y, &_density, &_near_density, &_delta_x, &_delta_y})
+        v->reserve(count);
+}
+void FluidManager::clear() {
+    for(auto v : {&_pos_x, &_pos_y, &_vel_x, &_vel_y, &_prev_x, &_prev_y, &_density, &_near_density, &_delta_x, &_delta_y})
+        v->clear();
+}
+float FluidManager::getRestDensity() const {
+    float h = getSmoothingRadius();
+    int reach = (int)std::ceil(h / spacing);
+    float density = 0.f;
+    for(int y = -reach; y <= reach; y++) {
+        for(int x = -reach; x <= reach; x++) {
+            float r = std::sqrt((float)(x * x + y * y)) * spacing;
+            if((x != 0 || y != 0) && r < h)
+                density += (1.f - r / h) * (1.f - r / h);
+        }
+    }
+    return density;
+}
+float FluidManager::m_getSearchRadius() const {
+    return getSmoothingRadius() * NEIGHBOUR_SKIN;
+}
+int32_t FluidManager::m_cell(float v) const {
+    float c = std::floor(v / m_getSearchRadius());
+    if(!(c > -MAX_CELL))
+        return (int32_t)-MAX_CELL;
+    return (int32_t)std::min(c, MAX_CELL);
+}
+uint32_t FluidManager::m_bucket(int32_t cx, int32_t cy) const {
+    return (((uint32_t)cx * 73856093u) ^ ((uint32_t)cy * 19349663u)) & _bucket_mask;
+}
+void FluidManager::m_buildGrid() {
+    EPI_PROFILE_FUNCTION();
+    //at least twice as many buckets as particles keeps collisions of the hash rare
+    size_t bucket_count = 1;
+    while(bucket_count < size() * 2)
+        bucket_count *= 2;
+    _bucket_mask = (uint32_t)bucket_count - 1;
+    _bucket_start.assign(bucket_count + 1, 0);
+    _bucket_of.resize(size());
+    _sorted.resize(size());
+    for(size_t i = 0; i < size(); i++) {
+        _bucket_of[i] = m_bucket(m_cell(_pos_x[i]), m_cell(_pos_y[i]));
+        _bucket_start[_bucket_of[i] + 1]++;
+    }
+    for(size_t b = 1; b <= bucket_count; b++)
+        _bucket_start[b] += _bucket_start[b - 1];
+    //particles are placed in order of their indices, so that every bucket is iterated in the same order on every run
+    for(size_t i = 0; i < size(); i++)
+        _sorted[_bucket_start[_bucket_of[i]]++] = (uint32_t)i;
+    for(size_t b = bucket_count; b > 0; b--)
+        _bucket_start[b] = _bucket_start[b - 1];
+    _bucket_start[0] = 0;
+}
+void FluidManager::m_findNeighbours() {
+    EPI_PROFILE_FUNCTION();
+    float search2 = m_getSearchRadius() * m_getSearchRadius();
+    size_t n = size();
+    _block_neighbours.resize((n + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    _neighbour_start.resize(n + 1);
+    m_parallel(n, [&](size_t begin, size_t end) {
+        auto& found = _block_neighbours[begin / BLOCK_SIZE];
+        found.clear();
+        for(size_t i = begin; i < end; i++) {
+            //start is relative to block until blocks are joined
+            _neighbour_start[i] = (uint32_t)found.size();
+            int32_t cx = m_cell(_pos_x[i]);
+            int32_t cy = m_cell(_pos_y[i]);
+            //neighbouring cells can share a bucket, each bucket is visited once
+            uint32_t visited[9];
+            size_t visited_count = 0;
+            for(int32_t dy = -1; dy <= 1; dy++) {
+                for(int32_t dx = -1; dx <= 1; dx++) {
+                    uint32_t b = m_bucket(cx + dx, cy + dy);
+                    if(std::find(visited, visited + visited_count, b) != visited + visited_count)
+                        continue;
+                    visited[visited_count++] = b;
+                    for(uint32_t e = _bucket_start[b]; e < _bucket_start[b + 1]; e++) {
+                        uint32_t j = _sorted[e];
+                        float rx = _pos_x[j] - _pos_x[i];
+                        float ry = _pos_y[j] - _pos_y[i];
+                        if(j != i && rx * rx + ry * ry < search2)
+                            found.push_back(j);
+                    }
+                }
+            }
+        }
+    });
+    _neighbours.clear();
+    for(size_t b = 0; b < _block_neighbours.size(); b++) {
+        uint32_t offset = (uint32_t)_neighbours.size();
+        for(size_t i = b * BLOCK_SIZE; i < std::min(n, (b + 1) * BLOCK_SIZE); i++)
+            _neighbour_start[i] += offset;
+        _neighbours.insert(_neighbours.end(), _block_neighbours[b].begin(), _block_neighbours[b].end());
+    }
+    _neighbour_start[n] = (uint32_t)_neighbours.size();
+}
+template<class Func>
+void FluidManager::m_forEachNeighbour(size_t idx, Func func) const {
+    float h2 = getSmoothingRadius() * getSmoothingRadius();
+    for(uint32_t e = _neighbour_start[idx]; e < _neighbour_start[idx + 1]; e++) {
+        uint32_t j = _neighbours[e];
+        //rx, ry point from idx towards j
+        float rx = _pos_x[j] - _pos_x[idx];
+        float ry = _pos_y[j] - _pos_y[idx];
+        float r2 = rx * rx + ry * ry;
+        if(r2 < h2 && r2 > 0.f)
+            func(j, rx, ry, std::sqrt(r2));
+    }
+}
+void FluidManager::m_parallel(size_t count, const std::function<void(size_t, size_t)>& func) {
+    size_t blocks = (count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    //worlds stepped in parallel already keep every thread busy, so own pool is only used outside of other loops
+    bool isOwnPool = !_pool || _pool == _own_pool.get();
+    if(isOwnPool && ThreadPool::isInsideLoop()) {
+        for(size_t b = 0; b < blocks; b++)
+            func(b * BLOCK_SIZE, std::min(count, (b + 1) * BLOCK_SIZE));
+        return;
+    }
+    if(!_pool) {
+        _own_pool = std::make_unique<ThreadPool>(_thread_count);
+        _pool = _own_pool.get();
+    }
+    _pool->parallelFor(blocks, [&](size_t b) {
+        func(b * BLOCK_SIZE, std::min(count, (b + 1) * BLOCK_SIZE));
+    });
+}
+void FluidManager::m_applyDelta(std::vector<float>& x, std::vector<float>& y) {
+    size_t n = size();
+    float* px = x.data();
+    float* py = y.data();
+    const float* dx = _delta_x.data();
+    const float* dy = _delta_y.data();
+    for(size_t i = 0; i < n; i++) {
+        px[i] += dx[i];
+        py[i] += dy[i];
+    }
+}
+void FluidManager::m_applyViscosity(float delT) {
+    EPI_PROFILE_FUNCTION();
+    float h = getSmoothingRadius();
+    m_parallel(size(), [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            float dvx = 0.f;
+            float dvy = 0.f;
+            m_forEachNeighbour(i, [&](uint32_t j, float rx, float ry, float r) {
+                //only particles approaching each other are slowed down, both get half of the impulse
+                float u = ((_vel_x[i] - _vel_x[j]) * rx + (_vel_y[i] - _vel_y[j]) * ry) / r;
+                if(u <= 0.f)
+                    return;
+                //capped, so that viscosity can stop particles but never push them back
+                float impulse = std::min(delT * (1.f - r / h) * (viscosity * u + viscosity_quadratic * u * u), u) / 2.f;
+                dvx -= impulse * rx / r;
+                dvy -= impulse * ry / r;
+            });
+            _delta_x[i] = dvx;
+            _delta_y[i] = dvy;
+        }
+    });
+    m_applyDelta(_vel_x, _vel_y);
+}
+void FluidManager::m_computeDensity() {
+    EPI_PROFILE_FUNCTION();
+    float h = getSmoothingRadius();
+    m_parallel(size(), [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            float density = 0.f;
+            float near_density = 0.f;
+            m_forEachNeighbour(i, [&](uint32_t, float, float, float r) {
+                float q = 1.f - r / h;
+                density += q * q;
+                near_density += q * q * q;
+            });
+            _density[i] = density;
+            _near_density[i] = near_density;
+        }
+    });
+}
+void FluidManager::m_relax(float delT) {
+    EPI_PROFILE_FUNCTION();
+    float h = getSmoothingRadius();
+    float rest_density = getRestDensity();
+    //displacements are in units of smoothing radius, so that tuning does not depend on the scale of the world
+    float scale = delT * delT * h;
+    m_parallel(size(), [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            float pressure_i = stiffness * (_density[i] - rest_density);
+            float near_pressure_i = near_stiffness * _near_density[i];
+            float dx = 0.f;
+            float dy = 0.f;
+            m_forEachNeighbour(i, [&](uint32_t j, float rx, float ry, float r) {
+                //pressures of both particles are averaged, so that every pair is pushed apart symmetrically
+                float pressure = (pressure_i + stiffness * (_density[j] - rest_density)) / 2.f;
+                float near_pressure = (near_pressure_i + near_stiffness * _near_density[j]) / 2.f;
+                float q = 1.f - r / h;
+                float d = scale * (pressure * q + near_pressure * q * q) / 2.f;
+                dx -= d * rx / r;
+                dy -= d * ry / r;
+            });
+            _delta_x[i] = dx;
+            _delta_y[i] = dy;
+        }
+    });
+    m_applyDelta(_pos_x, _pos_y);
+}
+void FluidManager::m_predict(float delT, vec2f gravity) {
+    size_t n = size();
+    if(n == 0)
+        return;
+    m_buildGrid();
+    m_findNeighbours();
+    m_applyViscosity(delT);
+    float* px = _pos_x.data();
+    float* py = _pos_y.data();
+    float* vx = _vel_x.data();
+    float* vy = _vel_y.data();
+    float* prev_x = _prev_x.data();
+    float* prev_y = _prev_y.data();
+    for(size_t i = 0; i < n; i++) {
+        vx[i] += gravity.x * delT;
+        vy[i] += gravity.y * delT;
+        prev_x[i] = px[i];
+        prev_y[i] = py[i];
+        px[i] += vx[i] * delT;
+        py[i] += vy[i] * delT;
+    }
+    m_computeDensity();
+    m_relax(delT);
+}
+void FluidManager::m_finish(float delT) {
+    size_t n = size();
+    const float* px = _pos_x.data();
+    const float* py = _pos_y.data();
+    const float* prev_x = _prev_x.data();
+    const float* prev_y = _prev_y.data();
+    float* vx = _vel_x.data();
+    float* vy = _vel_y.data();
+    for(size_t i = 0; i < n; i++) {
+        vx[i] = (px[i] - prev_x[i]) / delT;
+        vy[i] = (py[i] - prev_y[i]) / delT;
+    }
+}
+void FluidManager::step(float delT, vec2f gravity) {
+    m_predict(delT, gravity);
+    m_finish(delT);
+}
+
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include "thread_pool.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace epi {
+
+class PhysicsManager;
+
+/*
+* \brief 2D smoothed particle hydrodynamics fluid, simulated along with rigidbodies
+* uses double density relaxation (Clavet et al. 2005), which unlike force based SPH stays stable at the timesteps of a game
+* state is kept as separate float arrays, neighbours are found once per step with a hashed grid of cells
+* viscosity, density and pressure passes run in blocks on a thread pool, every particle is written by one thread only,
+* so results do not depend on the number of threads
+* has to be bound to PhysicsManager, which steps fluid after all rigid substeps and couples it both ways with rigidbodies:
+* particles are pushed out of colliders and bodies receive opposite impulses, which is what makes them float
+* particles are part of states saved by PhysicsManager::saveState, but not of snapshots, recordings or state hashes
+*/
+class FluidManager {
+    std::vector<float> _pos_x;
+    std::vector<float> _pos_y;
+    std::vector<float> _vel_x;
+    std::vector<float> _vel_y;
+    std::vector<float> _prev_x;
+    std::vector<float> _prev_y;
+    std::vector<float> _density;
+    std::vector<float> _near_density;
+    //displacement or velocity change computed by a pass before it is applied, so that passes only read old values
+    std::vector<float> _delta_x;
+    std::vector<float> _delta_y;
+
+    //hashed neighbour grid, particles of bucket b are _sorted[_bucket_start[b]] up to _sorted[_bucket_start[b + 1]]
+    std::vector<uint32_t> _bucket_start;
+    std::vector<uint32_t> _sorted;
+    std::vector<uint32_t> _bucket_of;
+    uint32_t _bucket_mask = 0;
+    //neighbours of particle i are _neighbours[_neighbour_start[i]] up to _neighbours[_neighbour_start[i + 1]]
+    //found once per step, within radius a bit bigger than smoothing radius, so that they stay valid after particles move
+    std::vector<uint32_t> _neighbour_start;
+    std::vector<uint32_t> _neighbours;
+    //neighbours found by every block of particles, before they are joined
+    std::vector<std::vector<uint32_t>> _block_neighbours;
+
+    //pool given by the caller or the own one, which is created by the first step that runs in parallel
+    ThreadPool* _pool = nullptr;
+    std::unique_ptr<ThreadPool> _own_pool;
+    size_t _thread_count = 0;
+
+    uint32_t m_bucket(int32_t cx, int32_t cy) const;
+    int32_t m_cell(float v) const;
+    float m_getSearchRadius() const;
+    void m_buildGrid();
+    void m_findNeighbours();
+    template<class Func>
+    void m_forEachNeighbour(size_t idx, Func func) const;
+    void m_parallel(size_t count, const std::function<void(size_t, size_t)>& func);
+    void m_applyViscosity(float delT);
+    void m_computeDensity();
+    void m_relax(float delT);
+    void m_applyDelta(std::vector<float>& x, std::vector<float>& y);
+    //moves particles and relaxes their density, after that collisions can be resolved by moving particles
+    void m_predict(float delT, vec2f gravity);
+    //velocities are derived from how far particles moved during whole step
+    void m_finish(float delT);
+public:
+    //distance between particles of fluid at rest, smoothing radius is twice as big
+    float spacing = 8.f;
+    //mass per unit of area, used only for coupling, demo bodies of mass 1 are about half as dense as the default
+    float mass_density = 1e-3f;
+    //pull towards rest density, higher values make fluid less compressible
+    float stiffness = 2000.f;
+    //repulsion that keeps particles from clustering, also gives fluid its surface tension
+    float near_stiffness = 5000.f;
+    //linear and quadratic viscosity, damp velocities of particles approaching each other
+    float viscosity = 0.1f;
+    float viscosity_quadratic = 0.01f;
+    //fluid steps per update, every one of them is followed by collisions with rigidbodies
+    size_t substeps = 4;
+
+    float getSmoothingRadius() const {
+        return spacing * 2.f;
+    }
+    //density of particles laid out in a square lattice of spacing, which is what fluid settles towards
+    float getRestDensity() const;
+    float getParticleMass() const {
+        return mass_density * spacing * spacing;
+    }
+    //radius used when colliding particles with rigidbodies
+    float getParticleRadius() const {
+        return spacing / 2.f;
+    }
+
+    //returns index of the new particle
+    size_t spawn(vec2f pos, vec2f vel = {0.f, 0.f});
+    //fills area with particles at rest spacing
+    void spawnBlock(const AABB& area, vec2f vel = {0.f, 0.f});
+    void reserve(size_t count);
+    void clear();
+
+    //advances fluid by delT without touching any rigidbodies, PhysicsManager steps bound fluid by itself
+    void step(float delT, vec2f gravity);
+
+    size_t size() const {
+        return _pos_x.size();
+    }
+    vec2f getPos(size_t idx) const {
+        return {_pos_x[idx], _pos_y[idx]};
+    }
+    vec2f getVel(size_t idx) const {
+        return {_vel_x[idx], _vel_y[idx]};
+    }
+    float getDensity(size_t idx) const {
+        return _density[idx];
+    }
+
+    /*
+    * thread_count includes calling thread, 0 uses one thread per hardware thread
+    * fluid stepped from inside of another pool's loop (e.g. a world of WorldBatch) runs on the calling thread only
+    */
+    explicit FluidManager(size_t thread_count = 0) : _thread_count(thread_count) {}
+    //passes run on pool, which has to outlive the fluid and must not be used by anything else while fluid steps
+    explicit FluidManager(ThreadPool& pool) : _pool(&pool) {}
+    friend PhysicsManager;
+};
+
+}
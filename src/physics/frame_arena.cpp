@@ -0,0 +1,56 @@
+#include "frame_arena.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace epi {
+
+void FrameArena::m_addBlock(size_t size) {
+    _blocks.push_back({static_cast<std::byte*>(::operator new(size, std::align_val_t(alignof(std::max_align_t)))), size});
+    _upstream_allocations++;
+}
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+    while(true) {
+        auto& block = _blocks[_current];
+        uintptr_t start = reinterpret_cast<uintptr_t>(block.data) + _offset;
+        size_t padding = (alignment - start % alignment) % alignment;
+        if(_offset + padding + bytes <= block.size) {
+            _offset += padding + bytes;
+            _used += padding + bytes;
+            return block.data + _offset - bytes;
+        }
+        //rest of current block is skipped, next kept block is tried or a new one twice as big is made
+        _current++;
+        _offset = 0;
+        if(_current == _blocks.size())
+            m_addBlock(std::max(_blocks.back().size * 2, bytes + alignment));
+    }
+}
+void FrameArena::reset() {
+    if(_blocks.size() > 1) {
+        size_t total = getCapacity();
+        for(auto& b : _blocks)
+            ::operator delete(b.data, std::align_val_t(alignof(std::max_align_t)));
+        _blocks.clear();
+        m_addBlock(total);
+    }
+    _current = 0;
+    _offset = 0;
+    _used = 0;
+}
+size_t FrameArena::getCapacity() const {
+    size_t result = 0;
+    for(auto& b : _blocks)
+        result += b.size;
+    return result;
+}
+FrameArena::FrameArena(size_t initial_size) {
+    m_addBlock(std::max<size_t>(initial_size, 64));
+}
+FrameArena::~FrameArena() {
+    for(auto& b : _blocks)
+        ::operator delete(b.data, std::align_val_t(alignof(std::max_align_t)));
+}
+
+}
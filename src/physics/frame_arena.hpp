@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace epi {
+
+/*
+* \brief linear memory resource for temporaries that live no longer than a single update
+* allocating only moves a cursor and deallocating does nothing, all memory is given back at once by reset
+* blocks are kept between resets, if a frame did not fit into one block they are merged into a single bigger one,
+* so once the arena has seen the biggest frame it never calls global allocator again
+* not thread safe, every thread should use its own arena
+*/
+class FrameArena : public std::pmr::memory_resource {
+    struct Block {
+        std::byte* data;
+        size_t size;
+    };
+    std::vector<Block> _blocks;
+    size_t _current = 0;
+    size_t _offset = 0;
+    size_t _used = 0;
+    size_t _upstream_allocations = 0;
+
+    void m_addBlock(size_t size);
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+public:
+    //frees everything allocated since last reset, pointers handed out before must not be used anymore
+    void reset();
+    //bytes handed out since last reset, including padding
+    size_t getBytesUsed() const {
+        return _used;
+    }
+    //total size of kept blocks
+    size_t getCapacity() const;
+    //number of blocks taken from global allocator since arena was created
+    size_t getUpstreamAllocations() const {
+        return _upstream_allocations;
+    }
+
+    FrameArena(size_t initial_size = 64 * 1024);
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+    ~FrameArena();
+};
+
+}
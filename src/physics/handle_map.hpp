@@ -0,0 +1,169 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace epi {
+
+/*
+* \brief reference to an element of HandleMap, stays valid until that element is removed
+* generation is used to detect handles to elements that were already removed and whose slot got reused
+*/
+template<class Tag>
+struct Handle {
+    uint32_t slot = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool isValid() const {
+        return slot != UINT32_MAX;
+    }
+    bool operator==(const Handle& other) const {
+        return slot == other.slot && generation == other.generation;
+    }
+    bool operator!=(const Handle& other) const {
+        return !(*this == other);
+    }
+};
+/*
+* \brief densely packed storage addressed by handles
+* elements are kept contiguous, removal moves the last element into the freed place (swap and pop) so it is O(1)
+* handle can be reserved before element is placed, which allows for deferring insertion
+*/
+template<class T, class Tag = T>
+class HandleMap {
+public:
+    typedef Handle<Tag> handle_type;
+private:
+    static constexpr uint32_t npos = UINT32_MAX;
+    struct Slot {
+        uint32_t dense;
+        uint32_t generation;
+    };
+    std::vector<T> _data;
+    std::vector<uint32_t> _dense_to_slot;
+    std::vector<Slot> _slots;
+    std::vector<uint32_t> _free_slots;
+
+    const Slot* m_findSlot(handle_type h) const {
+        if(h.slot >= _slots.size() || _slots[h.slot].generation != h.generation)
+            return nullptr;
+        return &_slots[h.slot];
+    }
+public:
+    //allocates handle that does not point to any element yet
+    handle_type reserve() {
+        uint32_t slot;
+        if(_free_slots.size() != 0) {
+            slot = _free_slots.back();
+            _free_slots.pop_back();
+        } else {
+            slot = static_cast<uint32_t>(_slots.size());
+            _slots.push_back({npos, 0});
+        }
+        _slots[slot].dense = npos;
+        return {slot, _slots[slot].generation};
+    }
+    //allocates count handles at once and appends them to result
+    void reserve(size_t count, std::vector<handle_type>& result) {
+        result.reserve(result.size() + count);
+        size_t reused = std::min(count, _free_slots.size());
+        for(size_t i = 0; i < reused; i++)
+            result.push_back(reserve());
+        _slots.reserve(_slots.size() + count - reused);
+        for(size_t i = reused; i < count; i++) {
+            auto slot = static_cast<uint32_t>(_slots.size());
+            _slots.push_back({npos, 0});
+            result.push_back({slot, 0});
+        }
+    }
+    //makes room for count elements in total, so that placing many of them reallocates at most once
+    void reserveCapacity(size_t count) {
+        if(count <= _data.capacity())
+            return;
+        count = std::max(count, _data.capacity() * 2);
+        _data.reserve(count);
+        _dense_to_slot.reserve(count);
+    }
+    //places element under previously reserved handle
+    void place(handle_type h, T value) {
+        assert(m_findSlot(h) && m_findSlot(h)->dense == npos);
+        _slots[h.slot].dense = static_cast<uint32_t>(_data.size());
+        _data.push_back(value);
+        _dense_to_slot.push_back(h.slot);
+    }
+    handle_type insert(T value) {
+        auto h = reserve();
+        place(h, value);
+        return h;
+    }
+    //returns true if handle was reserved and is still alive
+    bool isAlive(handle_type h) const {
+        return m_findSlot(h) != nullptr;
+    }
+    //returns true if handle points to placed element
+    bool contains(handle_type h) const {
+        auto s = m_findSlot(h);
+        return s && s->dense != npos;
+    }
+    //removes element (or releases reserved handle), returns false if handle was stale
+    bool erase(handle_type h) {
+        auto s = m_findSlot(h);
+        if(!s)
+            return false;
+        uint32_t idx = s->dense;
+        if(idx != npos) {
+            uint32_t last = static_cast<uint32_t>(_data.size() - 1);
+            if(idx != last) {
+                _data[idx] = _data[last];
+                _dense_to_slot[idx] = _dense_to_slot[last];
+                _slots[_dense_to_slot[idx]].dense = idx;
+            }
+            _data.pop_back();
+            _dense_to_slot.pop_back();
+        }
+        _slots[h.slot].dense = npos;
+        _slots[h.slot].generation++;
+        _free_slots.push_back(h.slot);
+        return true;
+    }
+    T* get(handle_type h) {
+        auto s = m_findSlot(h);
+        if(!s || s->dense == npos)
+            return nullptr;
+        return &_data[s->dense];
+    }
+    const T* get(handle_type h) const {
+        auto s = m_findSlot(h);
+        if(!s || s->dense == npos)
+            return nullptr;
+        return &_data[s->dense];
+    }
+    //returns handle of element at dense index
+    handle_type handleAt(size_t idx) const {
+        uint32_t slot = _dense_to_slot[idx];
+        return {slot, _slots[slot].generation};
+    }
+    void clear() {
+        for(auto slot : _dense_to_slot) {
+            _slots[slot].dense = npos;
+            _slots[slot].generation++;
+            _free_slots.push_back(slot);
+        }
+        _data.clear();
+        _dense_to_slot.clear();
+    }
+
+    size_t size() const { return _data.size(); }
+    //every handle ever reserved has slot smaller than this, so it can index side tables kept per slot
+    size_t slotCount() const { return _slots.size(); }
+    T& operator[](size_t idx) { return _data[idx]; }
+    const T& operator[](size_t idx) const { return _data[idx]; }
+    typename std::vector<T>::iterator begin() { return _data.begin(); }
+    typename std::vector<T>::iterator end() { return _data.end(); }
+    typename std::vector<T>::const_iterator begin() const { return _data.begin(); }
+    typename std::vector<T>::const_iterator end() const { return _data.end(); }
+};
+
+}
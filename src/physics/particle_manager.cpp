@@ -0,0 +1,99 @@
+#include "particle_manager.hpp"
+#include "profiler.hpp"
+
+namespace epi {
+
+size_t ParticleManager::spawn(vec2f pos, vec2f vel, float lifetime) {
+    _pos_x.push_back(pos.x);
+    _pos_y.push_back(pos.y);
+    _vel_x.push_back(vel.x);
+    _vel_y.push_back(vel.y);
+    _life.push_back(lifetime);
+    _mobility.push_back(1.f);
+    _stuck_to.push_back({});
+    _stuck_offset.push_back({});
+    return _pos_x.size() - 1;
+}
+void ParticleManager::reserve(size_t count) {
+    _pos_x.reserve(count);
+    _pos_y.reserve(count);
+    _vel_x.reserve(count);
+    _vel_y.reserve(count);
+    _life.reserve(count);
+    _mobility.reserve(count);
+    _stuck_to.reserve(count);
+    _stuck_offset.reserve(count);
+}
+void ParticleManager::clear() {
+    _pos_x.clear();
+    _pos_y.clear();
+    _vel_x.clear();
+    _vel_y.clear();
+    _life.clear();
+    _mobility.clear();
+    _stuck_to.clear();
+    _stuck_offset.clear();
+}
+void ParticleManager::m_erase(size_t idx) {
+    size_t last = size() - 1;
+    _pos_x[idx] = _pos_x[last];
+    _pos_y[idx] = _pos_y[last];
+    _vel_x[idx] = _vel_x[last];
+    _vel_y[idx] = _vel_y[last];
+    _life[idx] = _life[last];
+    _mobility[idx] = _mobility[last];
+    _stuck_to[idx] = _stuck_to[last];
+    _stuck_offset[idx] = _stuck_offset[last];
+    _pos_x.pop_back();
+    _pos_y.pop_back();
+    _vel_x.pop_back();
+    _vel_y.pop_back();
+    _life.pop_back();
+    _mobility.pop_back();
+    _stuck_to.pop_back();
+    _stuck_offset.pop_back();
+}
+void ParticleManager::m_stick(size_t idx, Handle<RigidManifold> body, vec2f offset) {
+    _stuck_to[idx] = body;
+    _stuck_offset[idx] = offset;
+    _mobility[idx] = 0.f;
+    _vel_x[idx] = 0.f;
+    _vel_y[idx] = 0.f;
+}
+void ParticleManager::m_unstick(size_t idx) {
+    _stuck_to[idx] = {};
+    _mobility[idx] = 1.f;
+}
+void ParticleManager::integrate(float delT, vec2f gravity) {
+    EPI_PROFILE_FUNCTION();
+    //plain pointers and no branches, so that every loop is vectorized
+    size_t n = size();
+    float* px = _pos_x.data();
+    float* py = _pos_y.data();
+    float* vx = _vel_x.data();
+    float* vy = _vel_y.data();
+    float* life = _life.data();
+    const float* mobility = _mobility.data();
+    float gx = gravity.x * gravity_scale * delT;
+    float gy = gravity.y * gravity_scale * delT;
+    for(size_t i = 0; i < n; i++) {
+        vx[i] += gx * mobility[i];
+        vy[i] += gy * mobility[i];
+    }
+    for(size_t i = 0; i < n; i++) {
+        px[i] += vx[i] * delT;
+        py[i] += vy[i] * delT;
+    }
+    for(size_t i = 0; i < n; i++)
+        life[i] -= delT;
+}
+void ParticleManager::removeDead() {
+    EPI_PROFILE_FUNCTION();
+    //going backwards, particle moved into freed place was already checked
+    for(size_t i = size(); i > 0; i--) {
+        if(!(_life[i - 1] > 0.f))
+            m_erase(i - 1);
+    }
+}
+
+}
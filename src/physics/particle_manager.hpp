@@ -0,0 +1,100 @@
+#pragma once
+#include "handle_map.hpp"
+#include "rigidbody.hpp"
+#include "types.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace epi {
+
+class PhysicsManager;
+
+//what happens to particle touching a rigidbody
+enum class eParticleResponse {
+    //particle is removed at the end of update
+    Kill,
+    //particle is pushed out and reflected off the body
+    Bounce,
+    //particle is attached to the body and moves with it from then on
+    Stick
+};
+/*
+* \brief cheap point particles (debris, sparks) simulated along with rigidbodies, without any components of their own
+* state is kept as separate float arrays (structure of arrays), so integration is a few flat loops that compiler vectorizes
+* particles collide with rigidbodies as small circles of shared radius, but never with each other
+* has to be bound to PhysicsManager, which moves and collides particles once per update (after all substeps)
+* particles are part of states saved by PhysicsManager::saveState, but not of snapshots, recordings or state hashes
+*/
+class ParticleManager {
+    std::vector<float> _pos_x;
+    std::vector<float> _pos_y;
+    std::vector<float> _vel_x;
+    std::vector<float> _vel_y;
+    //seconds left to live, infinite for particles living until they are killed
+    std::vector<float> _life;
+    //1 for free particles and 0 for stuck ones, multiplies gravity so that the loop has no branches
+    std::vector<float> _mobility;
+    //body stuck particle is attached to (invalid when free) and its position in space of that body
+    std::vector<Handle<RigidManifold>> _stuck_to;
+    std::vector<vec2f> _stuck_offset;
+
+    void m_erase(size_t idx);
+    void m_stick(size_t idx, Handle<RigidManifold> body, vec2f offset);
+    void m_unstick(size_t idx);
+public:
+    eParticleResponse response = eParticleResponse::Bounce;
+    //if true, particles push rigidbodies they hit, otherwise only particles react to collisions
+    bool isTwoWay = false;
+    //collision radius shared by every particle
+    float radius = 1.f;
+    //used only for pushing rigidbodies in two way mode
+    float mass = 0.01f;
+    float restitution = 0.3f;
+    //fraction of tangential velocity lost on every bounce
+    float friction = 0.1f;
+    //particles use gravity of the manager scaled by this
+    float gravity_scale = 1.f;
+
+    //returns index of new particle, indices change when particles die
+    size_t spawn(vec2f pos, vec2f vel, float lifetime = INFINITY);
+    void reserve(size_t count);
+    void clear();
+    //sets remaining lifetime to 0, so that particle is removed during next update
+    void kill(size_t idx) {
+        _life[idx] = 0.f;
+    }
+
+    //moves free particles by delT, called by PhysicsManager
+    void integrate(float delT, vec2f gravity);
+    //removes every particle whose lifetime ended, order of remaining particles changes
+    void removeDead();
+
+    size_t size() const {
+        return _pos_x.size();
+    }
+    vec2f getPos(size_t idx) const {
+        return {_pos_x[idx], _pos_y[idx]};
+    }
+    vec2f getVel(size_t idx) const {
+        return {_vel_x[idx], _vel_y[idx]};
+    }
+    float getLife(size_t idx) const {
+        return _life[idx];
+    }
+    bool isStuck(size_t idx) const {
+        return _stuck_to[idx].isValid();
+    }
+    //whole arrays for bulk reads, like copying positions for rendering
+    const std::vector<float>& getPositionsX() const {
+        return _pos_x;
+    }
+    const std::vector<float>& getPositionsY() const {
+        return _pos_y;
+    }
+    friend PhysicsManager;
+};
+
+}
@@ -1,42 +1,54 @@
 #include "physics_manager.hpp"
+#include "body_batch.hpp"
 #include "col_utils.hpp"
 #include "collider.hpp"
-#include "imgui.h"
+#include "fluid_manager.hpp"
+#include "particle_manager.hpp"
 
 #include "restraint.hpp"
+#include "profiler.hpp"
+#include "recorder.hpp"
 #include "solver.hpp"
 #include "rigidbody.hpp"
 #include "transform.hpp"
 
 #include <cassert>
+#include <chrono>
 #include <cmath>
 #include <cstddef>
+#include <cstring>
 #include <iterator>
 #include <map>
 #include <mutex>
 #include <memory>
+#include <new>
 #include <set>
 #include <stdexcept>
 #include <vector>
 #include <thread>
 #include <mutex>
+#include <unordered_set>
 
 
 namespace epi {
+typedef std::chrono::steady_clock StatsClock;
+static double secondsSince(StatsClock::time_point start) {
+    return std::chrono::duration<double>(StatsClock::now() - start).count();
+}
 //from 1 to n
 //veci communities(n + 1, -1);
 
 Collider* getHead(Collider* col) {
-    if(col->parent_collider == col)
-        return col;
-    std::vector<Collider*> to_speed;
-    while(col->parent_collider != col) {
-        to_speed.push_back(col);
-        col = col->parent_collider;
+    Collider* head = col;
+    while(head->parent_collider != head)
+        head = head->parent_collider;
+    //second walk points the whole path straight to the head
+    while(col != head) {
+        Collider* next = col->parent_collider;
+        col->parent_collider = head;
+        col = next;
     }
-    for(auto t : to_speed)
-        t->parent_collider = col;
-    return col;
+    return head;
 }
 
 void Merge(Collider* a, Collider* b) {
@@ -59,21 +71,44 @@ static bool areCompatible(RigidManifold r1, RigidManifold r2) {
         (r2.collider->mask.size() == 0 || r1.collider->tag == r2.collider->mask) && 
         (r1.collider->mask.size() == 0 || r2.collider->tag == r1.collider->mask);
 }
-std::vector<PhysicsManager::ColInfo> PhysicsManager::processBroadPhase() {
-    std::vector<PhysicsManager::ColInfo> result;
-    std::vector<std::pair<float, RigidManifold>> all;
-    for(auto& c : _rigidbodies) {
+std::pmr::vector<PhysicsManager::ColInfo> PhysicsManager::processBroadPhase(float delT) {
+    std::pmr::vector<PhysicsManager::ColInfo> result(&_arena);
+    //edge of body's aabb on x axis, equal edges are ordered by body's dense index and then opening before closing
+    //so that order of pairs never depends on the sorting algorithm
+    struct Edge {
+        float x;
+        uint32_t body;
+        bool isMax;
+    };
+    std::pmr::vector<Edge> all(&_arena);
+    all.reserve(_rigidbodies.size() * 2);
+    //bodies added since baking were not static then, if they are now the check below notices it
+    _static.wasStatic.resize(_rigidbodies.slotCount(), false);
+    for(size_t i = 0; i < _rigidbodies.size(); i++) {
+        auto& c = _rigidbodies[i];
+        //static bodies are only in the tree, unless flag changed since it was baked
+        if(!_static.isDirty && (bool)_static.wasStatic[_rigidbodies.handleAt(i).slot] != c.rigidbody->isStatic)
+            _static.isDirty = true;
+        if(c.rigidbody->isStatic)
+            continue;
         auto aabb = c.collider->getAABB(*c.transform);
-        all.push_back({aabb.min.x, c});
-        all.push_back({aabb.max.x, c});
+        all.push_back({aabb.min.x, (uint32_t)i, false});
+        all.push_back({aabb.max.x, (uint32_t)i, true});
     }
+    if(_static.isDirty)
+        m_bakeStatic();
+    _stats.static_bodies = _static.bodies.size();
     std::sort(all.begin(), all.end(),
-        [](const std::pair<float, RigidManifold>& p1, const std::pair<float, RigidManifold>& p2) {
-            return p1.first < p2.first;
+        [](const Edge& e1, const Edge& e2) {
+            if(e1.x != e2.x)
+                return e1.x < e2.x;
+            if(e1.body != e2.body)
+                return e1.body < e2.body;
+            return e1.isMax < e2.isMax;
         });
-    std::vector<std::pair<RigidManifold, AABB>> open;
-    for(auto i : all) {
-        auto idx = i.second;
+    std::pmr::vector<std::pair<RigidManifold, AABB>> open(&_arena);
+    for(auto e : all) {
+        auto idx = _rigidbodies[e.body];
         auto itr = std::find_if(open.begin(), open.end(), 
             [&](const std::pair<RigidManifold, AABB>& p) {
                 return p.first == idx;
@@ -83,31 +118,67 @@ std::vector<PhysicsManager::ColInfo> PhysicsManager::processBroadPhase() {
             open.pop_back();
             continue;
         }
-        auto aabb = i.second.collider->getAABB(*i.second.transform);
+        auto aabb = idx.collider->getAABB(*idx.transform);
         for(auto ii : open) {
             if(isOverlappingAABBAABB(ii.second, aabb))
                 result.push_back({idx, ii.first});
         }
         open.push_back({idx, aabb});
     }
+    //dormant bodies are not compatible with static ones, so they do not even query the tree
+    auto& hits = _static.hits;
+    for(size_t i = 0; i < _rigidbodies.size(); i++) {
+        auto& c = _rigidbodies[i];
+        if(isDormant(c))
+            continue;
+        hits.clear();
+        //box is swept over the whole update, so that bodies do not skip past thin static shapes like chains between broadphases
+        auto aabb = c.collider->getAABB(*c.transform);
+        vec2f travel = c.rigidbody->velocity * delT;
+        aabb.min += vec2f(std::min(travel.x, 0.f), std::min(travel.y, 0.f));
+        aabb.max += vec2f(std::max(travel.x, 0.f), std::max(travel.y, 0.f));
+        _static.tree.query(aabb, hits);
+        for(auto h : hits)
+            result.push_back({c, *_rigidbodies.get(_static.bodies[h])});
+    }
     return result;
 }
-void PhysicsManager::processNarrowPhase(const std::vector<PhysicsManager::ColInfo>& col_list) {
+void PhysicsManager::m_bakeStatic() {
+    EPI_PROFILE_FUNCTION();
+    _static.tree.clear();
+    _static.bodies.clear();
+    _static.colliders.clear();
+    _static.wasStatic.assign(_rigidbodies.slotCount(), false);
+    for(size_t i = 0; i < _rigidbodies.size(); i++) {
+        auto& c = _rigidbodies[i];
+        auto handle = _rigidbodies.handleAt(i);
+        _static.wasStatic[handle.slot] = c.rigidbody->isStatic;
+        if(!c.rigidbody->isStatic)
+            continue;
+        _static.tree.push(c.collider->getAABB(*c.transform));
+        _static.bodies.push_back(handle);
+        _static.colliders.insert(c.collider);
+    }
+    _static.tree.build();
+    _static.isDirty = false;
+}
+void PhysicsManager::processNarrowPhase(const std::pmr::vector<PhysicsManager::ColInfo>& col_list) {
     for(auto ci = col_list.begin(); ci != col_list.end(); ci++) {
         if(!areCompatible(ci->first, ci->second))
             continue;
-        auto col_info = _solver->detect(ci->first.transform, ci->first.collider, ci->second.transform, ci->second.collider);
+        _stats.narrowphase_tests++;
+        auto col_info = _solver->detect(ci->first.transform, ci->first.collider, ci->second.transform, ci->second.collider, &_arena);
         if(!col_info.detected) {
             continue;
         }
+        _stats.contacts++;
 
-        ci->first.collider->notify({*ci->first.collider, *ci->second.collider, col_info});
-        col_info.cn *= -1.f;
-        ci->second.collider->notify({*ci->second.collider, *ci->first.collider, col_info});
-        col_info.cn *= -1.f;
-
-        if(ci->first.collider->isTrigger || ci->second.collider->isTrigger) {
-            continue;
+        _contact_cache.touch(ci->first.collider, ci->second.collider, col_info);
+        if(synchronous_notify) {
+            ci->first.collider->notify({*ci->first.collider, *ci->second.collider, col_info});
+            col_info.cn *= -1.f;
+            ci->second.collider->notify({*ci->second.collider, *ci->first.collider, col_info});
+            col_info.cn *= -1.f;
         }
         float restitution = selectFrom(ci->first.material->restitution, ci->second.material->restitution, bounciness_select);
         float sfriction = selectFrom(ci->first.material->sfriction, ci->second.material->sfriction, friction_select);
@@ -117,6 +188,22 @@ void PhysicsManager::processNarrowPhase(const std::vector<PhysicsManager::ColInf
             Merge(ci->first.collider, ci->second.collider);
     }
 }
+void PhysicsManager::processTriggers(const std::pmr::vector<PhysicsManager::ColInfo>& trigger_list) {
+    for(auto& ci : trigger_list) {
+        if(!areCompatible(ci.first, ci.second))
+            continue;
+        _stats.trigger_tests++;
+        if(!_solver->overlaps(ci.first.transform, ci.first.collider, ci.second.transform, ci.second.collider, &_arena))
+            continue;
+        _stats.trigger_overlaps++;
+        _trigger_cache.touch(ci.first.collider, ci.second.collider);
+        if(synchronous_notify) {
+            CollisionInfo info = {true, vec2f(0, 0), {}, 0.f};
+            ci.first.collider->notify({*ci.first.collider, *ci.second.collider, info});
+            ci.second.collider->notify({*ci.second.collider, *ci.first.collider, info});
+        }
+    }
+}
 void PhysicsManager::updateRestraints(float delT) {
     for(auto& r : _restraints)
         r->update(delT);
@@ -149,7 +236,7 @@ void PhysicsManager::updateRigidObj(RigidManifold& man, float delT) {
     if(!nearlyEqual(rb.angular_velocity, 0.f))
         rb.angular_velocity -= std::copysign(1.f, rb.angular_velocity) * std::clamp(rb.angular_velocity * rb.angular_velocity * man.material->air_drag, 0.f, abs(rb.angular_velocity)) * delT;
 
-    rb.velocity += rb.force / rb.mass * delT;
+    rb.velocity += (rb.force / rb.mass + gravity) * delT;
     rb.angular_velocity += rb.angular_force / man.collider->getInertia(rb.mass) * delT;
     man.transform->setPos(man.transform->getPos() + rb.velocity * delT);
     man.transform->setRot(man.transform->getRot() + rb.angular_velocity * delT);
@@ -161,7 +248,7 @@ void PhysicsManager::updateRigidbodies(float delT) {
 }
 #define MIN_IMMOBILE_TIME_TO_SLEEP 1.f
 void PhysicsManager::processSleeping() {
-    std::set<Collider*> parent_colliders_woke;
+    std::pmr::set<Collider*> parent_colliders_woke(&_arena);
     for(auto r : _rigidbodies) {
         if(r.collider->isTrigger)
             continue;
@@ -179,6 +266,7 @@ void PhysicsManager::processSleeping() {
 
         if(!parent_colliders_woke.contains(r.collider->parent_collider)) {
             r.collider->isSleeping = true;
+            _stats.sleeping++;
         }else {
             if(r.collider->isSleeping) {
                 r.collider->isSleeping = false;
@@ -189,46 +277,735 @@ void PhysicsManager::processSleeping() {
     }
 }
 void PhysicsManager::update(float delT) {
+    EPI_PROFILE_SCOPE("physics update");
+    auto update_start = StatsClock::now();
+    if(_recorder)
+        _recorder->m_beforeUpdate(*this, delT);
+    //nothing allocated from arena outlives an update, it is reset here so that its usage can be read after update
+    _arena.reset();
+    {
+        EPI_PROFILE_SCOPE("pending");
+        applyPending();
+    }
+    _isUpdating = true;
     float deltaStep = delT / (float)steps;
+    _contact_events.clear();
+    _trigger_events.clear();
+    _stats = PhysicsStats();
+    _stats.rigidbodies = _rigidbodies.size();
 
-    auto col_list = processBroadPhase();
+    auto phase_start = StatsClock::now();
+    std::pmr::vector<ColInfo> col_list(&_arena);
+    //pairs with a trigger only have to know whether they overlap, so they skip substeps and are tested once after them
+    std::pmr::vector<ColInfo> trigger_list(&_arena);
+    {
+        EPI_PROFILE_SCOPE("broadphase");
+        col_list = processBroadPhase(delT);
+        auto isTriggerPair = [](const ColInfo& ci) {
+            return ci.first.collider->isTrigger || ci.second.collider->isTrigger;
+        };
+        for(auto& ci : col_list)
+            if(isTriggerPair(ci))
+                trigger_list.push_back(ci);
+        std::erase_if(col_list, isTriggerPair);
+    }
+    _stats.broadphase_pairs = col_list.size() + trigger_list.size();
+    _stats.time_broadphase = secondsSince(phase_start);
     for(int i = 0; i < steps; i++) {
-        updateRestraints(deltaStep);
-        updateRigidbodies(deltaStep);
-        processNarrowPhase(col_list);
+        EPI_PROFILE_SCOPE("substep");
+        phase_start = StatsClock::now();
+        {
+            EPI_PROFILE_SCOPE("restraints");
+            updateRestraints(deltaStep);
+        }
+        _stats.time_restraints += secondsSince(phase_start);
+
+        phase_start = StatsClock::now();
+        {
+            EPI_PROFILE_SCOPE("integration");
+            updateRigidbodies(deltaStep);
+        }
+        _stats.time_integration += secondsSince(phase_start);
+
+        phase_start = StatsClock::now();
+        {
+            //detection and solving are interleaved, so both are recorded under this zone
+            EPI_PROFILE_SCOPE("narrowphase + solve");
+            processNarrowPhase(col_list);
+        }
+        _stats.time_narrowphase += secondsSince(phase_start);
+    }
+    phase_start = StatsClock::now();
+    {
+        EPI_PROFILE_SCOPE("triggers");
+        processTriggers(trigger_list);
     }
+    _stats.time_triggers = secondsSince(phase_start);
 
-    processSleeping();
+    if(_particles || _fluid)
+        m_buildParticleScratch();
+    if(_fluid) {
+        EPI_PROFILE_SCOPE("fluid");
+        phase_start = StatsClock::now();
+        processFluid(*_fluid, delT);
+        _stats.fluid_particles = _fluid->size();
+        _stats.time_fluid = secondsSince(phase_start);
+    }
+    if(_particles) {
+        EPI_PROFILE_SCOPE("particles");
+        phase_start = StatsClock::now();
+        _particles->integrate(delT, gravity);
+        processParticles(*_particles);
+        _particles->removeDead();
+        _stats.particles = _particles->size();
+        _stats.time_particles = secondsSince(phase_start);
+    }
+    {
+        EPI_PROFILE_SCOPE("contact events");
+        //sleeping and static bodies are skipped by narrowphase, but stay in contact until one of them wakes up or is removed
+        auto isResting = [&](const Collider* c) {
+            return c->isSleeping || _static.colliders.contains(c);
+        };
+        _contact_cache.touchResting(isResting);
+        _contact_cache.flush(_contact_events);
+        //dormant bodies do not query the static tree, so a body falling asleep inside of a static sensor is kept in it the same way
+        _trigger_cache.touchResting(isResting);
+        _trigger_cache.flush(_trigger_events);
+    }
+    phase_start = StatsClock::now();
+    {
+        EPI_PROFILE_SCOPE("sleeping");
+        processSleeping();
+    }
+    _stats.time_sleeping = secondsSince(phase_start);
     for(auto r : _rigidbodies) {
         r.rigidbody->force = {0.f, 0.f};
         r.rigidbody->angular_force = 0.f;
     }
+    if(hash_state) {
+        EPI_PROFILE_SCOPE("state hash");
+        m_hashState();
+    }
+    _stats.frame_arena_bytes = _arena.getBytesUsed();
+    _stats.time_total = secondsSince(update_start);
+    _update_count++;
+    _isUpdating = false;
+    //bodies removed from inside of this update leave dense storage before it returns, so their components can be destroyed then
+    //contacts and islands that still point to them are cleaned up by applyPending
+    for(auto& r : _pending.rigidbodies_removed)
+        m_eraseRigidbody(r);
+    if(_recorder)
+        _recorder->m_afterUpdate(*this);
 }
-void PhysicsManager::add(RigidManifold man) {
-    _rigidbodies.push_back(man);
+void PhysicsManager::m_hashState() {
+    //words are mixed in dense order, so the hash is chained with every previous update
+    uint64_t h = _state_hash;
+    auto mix = [&](float v) {
+        uint32_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        h = (h ^ bits) * 0x100000001b3ull;
+    };
+    for(auto& r : _rigidbodies) {
+        auto pos = r.transform->getPos();
+        mix(pos.x);
+        mix(pos.y);
+        mix(r.transform->getRot());
+        mix(r.rigidbody->velocity.x);
+        mix(r.rigidbody->velocity.y);
+        mix(r.rigidbody->angular_velocity);
+    }
+    _state_hash = h ^ (h >> 32);
 }
-void PhysicsManager::add(Restraint* restraint) {
-    _restraints.push_back(restraint);
+void PhysicsManager::saveState(WorldState& state) const {
+    EPI_PROFILE_FUNCTION();
+    size_t n = _rigidbodies.size();
+    state.handles.resize(n);
+    state.pos.resize(n);
+    state.rot.resize(n);
+    state.velocity.resize(n);
+    state.angular_velocity.resize(n);
+    state.force.resize(n);
+    state.angular_force.resize(n);
+    state.time_immobile.resize(n);
+    state.parent_collider.resize(n);
+    state.isSleeping.resize(n);
+    for(size_t i = 0; i < n; i++) {
+        auto& man = _rigidbodies[i];
+        state.handles[i] = _rigidbodies.handleAt(i);
+        state.pos[i] = man.transform->getPos();
+        state.rot[i] = man.transform->getRot();
+        state.velocity[i] = man.rigidbody->velocity;
+        state.angular_velocity[i] = man.rigidbody->angular_velocity;
+        state.force[i] = man.rigidbody->force;
+        state.angular_force[i] = man.rigidbody->angular_force;
+        state.time_immobile[i] = man.collider->time_immobile;
+        state.parent_collider[i] = man.collider->parent_collider;
+        state.isSleeping[i] = man.collider->isSleeping;
+    }
+    auto& ps = state.particles;
+    if(_particles) {
+        ps.pos_x = _particles->_pos_x;
+        ps.pos_y = _particles->_pos_y;
+        ps.vel_x = _particles->_vel_x;
+        ps.vel_y = _particles->_vel_y;
+        ps.life = _particles->_life;
+        ps.mobility = _particles->_mobility;
+        ps.stuck_to = _particles->_stuck_to;
+        ps.stuck_offset = _particles->_stuck_offset;
+    } else {
+        ps = {};
+    }
+    auto& fs = state.fluid;
+    if(_fluid) {
+        fs.pos_x = _fluid->_pos_x;
+        fs.pos_y = _fluid->_pos_y;
+        fs.vel_x = _fluid->_vel_x;
+        fs.vel_y = _fluid->_vel_y;
+        fs.prev_x = _fluid->_prev_x;
+        fs.prev_y = _fluid->_prev_y;
+        fs.density = _fluid->_density;
+        fs.near_density = _fluid->_near_density;
+    } else {
+        fs = {};
+    }
+    state.contacts = _contact_cache;
+    state.contact_events = _contact_events;
+    state.triggers = _trigger_cache;
+    state.trigger_events = _trigger_events;
+    state.update_count = _update_count;
+    state.state_hash = _state_hash;
 }
-template<class T>
-static void unbind_any(const T obj, std::vector<T>& obj_vec) {
-    auto itr = obj_vec.begin();
-    for(; itr != obj_vec.end(); itr++) {
-        if(*itr == obj)
-            break;
+bool PhysicsManager::restoreState(const WorldState& state) {
+    EPI_PROFILE_FUNCTION();
+    size_t n = _rigidbodies.size();
+    if(state.handles.size() != n)
+        return false;
+    for(size_t i = 0; i < n; i++)
+        if(_rigidbodies.handleAt(i) != state.handles[i])
+            return false;
+    for(size_t i = 0; i < n; i++) {
+        auto& man = _rigidbodies[i];
+        //tree is only rebaked when some static body was moved since state was saved
+        if(man.rigidbody->isStatic && (man.transform->getPos() != state.pos[i] || man.transform->getRot() != state.rot[i]))
+            _static.isDirty = true;
+        man.transform->setPos(state.pos[i]);
+        man.transform->setRot(state.rot[i]);
+        man.rigidbody->velocity = state.velocity[i];
+        man.rigidbody->angular_velocity = state.angular_velocity[i];
+        man.rigidbody->force = state.force[i];
+        man.rigidbody->angular_force = state.angular_force[i];
+        man.collider->time_immobile = state.time_immobile[i];
+        man.collider->parent_collider = state.parent_collider[i];
+        man.collider->isSleeping = state.isSleeping[i];
+    }
+    _query.built_at = SIZE_MAX;
+    if(_particles) {
+        auto& ps = state.particles;
+        _particles->_pos_x = ps.pos_x;
+        _particles->_pos_y = ps.pos_y;
+        _particles->_vel_x = ps.vel_x;
+        _particles->_vel_y = ps.vel_y;
+        _particles->_life = ps.life;
+        _particles->_mobility = ps.mobility;
+        _particles->_stuck_to = ps.stuck_to;
+        _particles->_stuck_offset = ps.stuck_offset;
+    }
+    if(_fluid) {
+        auto& fs = state.fluid;
+        _fluid->_pos_x = fs.pos_x;
+        _fluid->_pos_y = fs.pos_y;
+        _fluid->_vel_x = fs.vel_x;
+        _fluid->_vel_y = fs.vel_y;
+        _fluid->_prev_x = fs.prev_x;
+        _fluid->_prev_y = fs.prev_y;
+        _fluid->_density = fs.density;
+        _fluid->_near_density = fs.near_density;
+        //scratch of passes only has to match the number of particles
+        _fluid->_delta_x.resize(fs.pos_x.size());
+        _fluid->_delta_y.resize(fs.pos_x.size());
+    }
+    _contact_cache = state.contacts;
+    _contact_events = state.contact_events;
+    _trigger_cache = state.triggers;
+    _trigger_events = state.trigger_events;
+    _update_count = state.update_count;
+    _state_hash = state.state_hash;
+    return true;
+}
+RigidbodyHandle PhysicsManager::add(RigidManifold man) {
+    auto handle = _rigidbodies.reserve();
+    _pending.rigidbodies_added.push_back({handle, man});
+    return handle;
+}
+static size_t alignUp(size_t offset, size_t alignment) {
+    return (offset + alignment - 1) / alignment * alignment;
+}
+std::unique_ptr<BodyBatch> PhysicsManager::addBatch(const BodyBatchDesc& desc, std::string* error) {
+    auto fail = [&](const char* msg) {
+        if(error)
+            *error = msg;
+        return std::unique_ptr<BodyBatch>();
+    };
+    size_t n = desc.count;
+    if(n != 0 && (!desc.shapes || desc.shape_count == 0 || !desc.positions))
+        return fail("batch has no shapes or positions");
+    if(n != 0 && (!desc.materials || desc.material_count == 0))
+        return fail("batch has no materials");
+    for(size_t i = 0; i < desc.shape_count; i++)
+        if(!desc.shapes[i])
+            return fail("shape of batch is nullptr");
+    for(size_t i = 0; i < desc.material_count; i++)
+        if(!desc.materials[i])
+            return fail("material of batch is nullptr");
+    for(size_t i = 0; i < n; i++) {
+        if(desc.shape_ids && desc.shape_ids[i] >= desc.shape_count)
+            return fail("shape id of batch is out of range");
+        if(desc.material_ids && desc.material_ids[i] >= desc.material_count)
+            return fail("material id of batch is out of range");
+    }
+
+    std::unique_ptr<BodyBatch> batch(new BodyBatch());
+    size_t rigidbodies_at = alignUp(sizeof(Transform) * n, alignof(Rigidbody));
+    size_t colliders_at = alignUp(rigidbodies_at + sizeof(Rigidbody) * n, alignof(Collider));
+    size_t materials_at = alignUp(colliders_at + sizeof(Collider) * n, alignof(Material*));
+    batch->_storage = std::unique_ptr<std::byte[]>(new std::byte[materials_at + sizeof(Material*) * n]);
+    auto base = batch->_storage.get();
+    batch->_transforms = reinterpret_cast<Transform*>(base);
+    batch->_rigidbodies = reinterpret_cast<Rigidbody*>(base + rigidbodies_at);
+    batch->_colliders = reinterpret_cast<Collider*>(base + colliders_at);
+    batch->_materials = reinterpret_cast<Material**>(base + materials_at);
+    for(size_t i = 0; i < n; i++) {
+        new (&batch->_colliders[i]) Collider(desc.shapes[desc.shape_ids ? desc.shape_ids[i] : 0]);
+        auto trans = new (&batch->_transforms[i]) Transform();
+        auto rb = new (&batch->_rigidbodies[i]) Rigidbody();
+        //counted right away so that destructor never runs on unconstructed components
+        batch->_count = i + 1;
+        batch->_materials[i] = desc.materials[desc.material_ids ? desc.material_ids[i] : 0];
+        trans->setPos(desc.positions[i]);
+        if(desc.rotations)
+            trans->setRot(desc.rotations[i]);
+        if(desc.velocities)
+            rb->velocity = desc.velocities[i];
+        if(desc.masses)
+            rb->mass = desc.masses[i];
+        rb->isStatic = desc.isStatic;
     }
-    if(itr != obj_vec.end()) {
-        obj_vec.erase(itr);
+    _rigidbodies.reserve(n, batch->_handles);
+    _pending.rigidbodies_added.reserve(_pending.rigidbodies_added.size() + n);
+    for(size_t i = 0; i < n; i++)
+        _pending.rigidbodies_added.push_back({batch->_handles[i], batch->getManifold(i)});
+    return batch;
+}
+RestraintHandle PhysicsManager::add(Restraint* restraint) {
+    auto handle = _restraints.reserve();
+    _pending.restraints_added.push_back({handle, restraint});
+    return handle;
+}
+void PhysicsManager::remove(RigidbodyHandle handle) {
+    auto man = _rigidbodies.get(handle);
+    if(!man) {
+        //body that was never simulated is only dropped from pending additions, nothing refers to it yet
+        auto itr = std::find_if(_pending.rigidbodies_added.begin(), _pending.rigidbodies_added.end(),
+            [&](const std::pair<RigidbodyHandle, RigidManifold>& p) { return p.first == handle; });
+        if(itr == _pending.rigidbodies_added.end())
+            return;
+        _pending.rigidbodies_added.erase(itr);
+        _rigidbodies.erase(handle);
+        return;
     }
+    PendingRemoval removal = {handle, man->collider, man->collider->parent_collider, man->rigidbody->isStatic};
+    _pending.rigidbodies_removed.push_back(removal);
+    if(!_isUpdating)
+        m_eraseRigidbody(removal);
+}
+void PhysicsManager::m_eraseRigidbody(const PendingRemoval& r) {
+    if(!_rigidbodies.erase(r.handle))
+        return;
+    //tree is keyed by handles, so only removing a body that is in it makes it stale
+    bool wasStatic = r.handle.slot < _static.wasStatic.size() && _static.wasStatic[r.handle.slot];
+    if(r.isStatic || wasStatic)
+        _static.isDirty = true;
+    if(wasStatic)
+        _static.wasStatic[r.handle.slot] = false;
+    //removal moves last body into freed place, so dense indices kept by the query tree change
+    _query.built_at = SIZE_MAX;
+}
+void PhysicsManager::remove(RestraintHandle handle) {
+    _pending.restraints_removed.push_back(handle);
 }
-void PhysicsManager::remove(RigidManifold rb) {
-    rb.collider->time_immobile = 0.f;
-    rb.collider->parent_collider->time_immobile = 0.f;
-    processSleeping();
-    unbind_any(rb, _rigidbodies);
+RigidManifold* PhysicsManager::get(RigidbodyHandle handle) {
+    if(auto man = _rigidbodies.get(handle))
+        return man;
+    for(auto& p : _pending.rigidbodies_added)
+        if(p.first == handle)
+            return &p.second;
+    return nullptr;
 }
-void PhysicsManager::remove(const Restraint* res) {
-    unbind_any<Restraint*>((Restraint*)res, _restraints);
+Restraint* PhysicsManager::get(RestraintHandle handle) {
+    if(auto res = _restraints.get(handle))
+        return *res;
+    for(auto& p : _pending.restraints_added)
+        if(p.first == handle)
+            return p.second;
+    return nullptr;
+}
+static void wakeUp(Collider* col) {
+    col->isSleeping = false;
+    col->time_immobile = 0.f;
+    col->parent_collider = col;
+}
+void PhysicsManager::applyPending() {
+    _rigidbodies.reserveCapacity(_rigidbodies.size() + _pending.rigidbodies_added.size());
+    for(auto& p : _pending.rigidbodies_added) {
+        _rigidbodies.place(p.first, p.second);
+        if(p.second.rigidbody->isStatic)
+            _static.isDirty = true;
+    }
+    _pending.rigidbodies_added.clear();
+    for(auto& p : _pending.restraints_added)
+        _restraints.place(p.first, p.second);
+    _pending.restraints_added.clear();
+
+    for(auto h : _pending.restraints_removed)
+        _restraints.erase(h);
+    _pending.restraints_removed.clear();
+
+    if(_pending.rigidbodies_removed.size() == 0)
+        return;
+    auto& removed = _removal_scratch.removed;
+    auto& woken_parents = _removal_scratch.woken_parents;
+    auto& touching = _removal_scratch.touching;
+    auto& sensed = _removal_scratch.sensed;
+    removed.clear();
+    woken_parents.clear();
+    touching.clear();
+    sensed.clear();
+    for(auto& r : _pending.rigidbodies_removed) {
+        removed.insert(r.collider);
+        woken_parents.insert(r.collider);
+        woken_parents.insert(r.parent_collider);
+    }
+    _pending.rigidbodies_removed.clear();
+
+    _contact_cache.remove(removed, touching);
+    for(auto col : touching)
+        wakeUp(col);
+    //overlapping a trigger does not keep bodies awake, so its partners are left alone
+    _trigger_cache.remove(removed, sensed);
+    //single pass for the whole batch, no other collider can be pointing to the removed ones afterwards
+    for(auto& r : _rigidbodies) {
+        if(woken_parents.contains(r.collider->parent_collider))
+            wakeUp(r.collider);
+    }
+}
+
+void PhysicsManager::m_prepareQueries() {
+    if(_query.built_at == _update_count)
+        return;
+    EPI_PROFILE_FUNCTION();
+    size_t body_count = _rigidbodies.size();
+    _query.tree.clear();
+    for(size_t i = 0; i < body_count; i++)
+        _query.tree.push(getAABBfromRigidbody(_rigidbodies[i]));
+    _query.tree.build();
+    _query.polygons.resize(body_count);
+    _query.normals.resize(body_count);
+    _query.offsets.resize(body_count);
+    _query.isPolygonReady.assign(body_count, false);
+    _query.built_at = _update_count;
+}
+template<class OnPiece>
+void PhysicsManager::m_forEachQueryPiece(size_t body_idx, const AABB& area, OnPiece on_piece) {
+    auto& man = _rigidbodies[body_idx];
+    auto& col = *man.collider;
+    auto& q = _query;
+    //segment given by its ends, with edge lines of both of its sides
+    auto on_segment = [&](vec2f a, vec2f b) {
+        q.piece_vertices.assign({a, b});
+        calcEdgeNormals(q.piece_vertices.data(), 2, q.piece_normals);
+        calcEdgeOffsets(q.piece_vertices.data(), q.piece_normals.data(), 2, q.piece_offsets);
+        on_piece(nullptr, &q.piece_vertices, &q.piece_normals, &q.piece_offsets);
+    };
+    switch(col.type) {
+        case eCollisionShape::Circle: {
+            Circle c = col.getCircleShape(*man.transform);
+            on_piece(&c, nullptr, nullptr, nullptr);
+        }break;
+        case eCollisionShape::Polygon:
+            if(!q.isPolygonReady[body_idx]) {
+                col.getPolygonShape(*man.transform, q.polygons[body_idx]);
+                col.getPolygonAsset().placeNormals(man.transform->getRotation(), man.transform->getScale(), q.normals[body_idx]);
+                auto& vertices = q.polygons[body_idx].getVertecies();
+                calcEdgeOffsets(vertices.data(), q.normals[body_idx].data(), vertices.size(), q.offsets[body_idx]);
+                q.isPolygonReady[body_idx] = true;
+            }
+            on_piece(nullptr, &q.polygons[body_idx].getVertecies(), &q.normals[body_idx], &q.offsets[body_idx]);
+        break;
+        case eCollisionShape::Ray: {
+            Ray t = col.getRayShape(*man.transform);
+            on_segment(t.pos, t.pos + t.dir);
+        }break;
+        case eCollisionShape::Chain: {
+            auto& chain = col.getChainModel();
+            q.children.clear();
+            chain.querySegments(area, *man.transform, q.children);
+            for(auto s : q.children) {
+                auto seg = chain.getSegment(s, *man.transform);
+                on_segment(seg.a, seg.b);
+            }
+        }break;
+        case eCollisionShape::Compound: {
+            auto& compound = col.getCompoundModel();
+            q.children.clear();
+            compound.queryChildren(area, *man.transform, q.children);
+            for(auto h : q.children) {
+                if(!compound.isPolygon(h)) {
+                    Circle c = compound.getCircle(h - compound.getPolygonCount(), *man.transform);
+                    on_piece(&c, nullptr, nullptr, nullptr);
+                    continue;
+                }
+                compound.getPolygon(h, *man.transform, q.piece_polygon);
+                auto& vertices = q.piece_polygon.getVertecies();
+                calcEdgeNormals(vertices.data(), vertices.size(), q.piece_normals);
+                calcEdgeOffsets(vertices.data(), q.piece_normals.data(), vertices.size(), q.piece_offsets);
+                on_piece(nullptr, &vertices, &q.piece_normals, &q.piece_offsets);
+            }
+        }break;
+    }
+}
+//keeps the earlier of two hits, ties keep the one found first so that result does not depend on anything but order of tree traversal
+static void keepFirst(CastHit& hit, const CastResult& result, RigidbodyHandle body) {
+    if(!result.detected || (hit.detected && result.time >= hit.time))
+        return;
+    hit = {true, result.time, result.point, result.normal, body};
+}
+static AABB sweptAABB(AABB box, vec2f translation) {
+    box.min += vec2f(std::min(translation.x, 0.f), std::min(translation.y, 0.f));
+    box.max += vec2f(std::max(translation.x, 0.f), std::max(translation.y, 0.f));
+    return box;
+}
+void PhysicsManager::raycast(const Ray* rays, size_t count, CastHit* hits) {
+    EPI_PROFILE_FUNCTION();
+    m_prepareQueries();
+    for(size_t i = 0; i < count; i++)
+        hits[i] = CastHit();
+    _query.candidates.clear();
+    _query.tree.queryRays(rays, count, _query.candidates);
+    for(auto [r, b] : _query.candidates) {
+        if(_rigidbodies[b].collider->isTrigger)
+            continue;
+        auto& ray = rays[r];
+        auto body = _rigidbodies.handleAt(b);
+        auto area = sweptAABB(AABB::CreateMinMax(ray.pos, ray.pos), ray.dir);
+        m_forEachQueryPiece(b, area, [&](const Circle* circle, const std::vector<vec2f>* vertices, const std::vector<vec2f>* normals, const std::vector<float>* offsets) {
+            if(circle)
+                keepFirst(hits[r], castRayCircle(ray.pos, ray.dir, circle->pos, circle->radius), body);
+            else if(vertices->size() == 2)
+                keepFirst(hits[r], castRaySegment(ray.pos, ray.dir, (*vertices)[0], (*vertices)[1]), body);
+            else
+                keepFirst(hits[r], castRayPlanes(ray.pos, ray.dir, normals->data(), offsets->data(), vertices->size()), body);
+        });
+    }
+}
+void PhysicsManager::castCircles(const Circle* circles, const vec2f* translations, size_t count, CastHit* hits) {
+    EPI_PROFILE_FUNCTION();
+    m_prepareQueries();
+    for(size_t i = 0; i < count; i++) {
+        hits[i] = CastHit();
+        auto& moving = circles[i];
+        vec2f translation = translations[i];
+        auto area = sweptAABB(AABB::CreateFromCircle(moving), translation);
+        _query.hits.clear();
+        _query.tree.query(area, _query.hits);
+        for(auto b : _query.hits) {
+            if(_rigidbodies[b].collider->isTrigger)
+                continue;
+            auto body = _rigidbodies.handleAt(b);
+            m_forEachQueryPiece(b, area, [&](const Circle* circle, const std::vector<vec2f>* vertices, const std::vector<vec2f>* normals, const std::vector<float>* offsets) {
+                if(circle) {
+                    keepFirst(hits[i], epi::castCircle(moving, translation, *circle), body);
+                    return;
+                }
+                //same as castCircle against vertices, with edge normals that are already placed
+                auto result = castRayRounded(moving.pos, translation, vertices->data(), normals->data(), vertices->size(), moving.radius);
+                if(result.detected && result.time > 0.f)
+                    result.point -= result.normal * moving.radius;
+                keepFirst(hits[i], result, body);
+            });
+        }
+    }
+}
+void PhysicsManager::castPolygons(const Polygon* polygons, const vec2f* translations, size_t count, CastHit* hits) {
+    EPI_PROFILE_FUNCTION();
+    m_prepareQueries();
+    for(size_t i = 0; i < count; i++) {
+        hits[i] = CastHit();
+        auto& moving = polygons[i].getVertecies();
+        vec2f translation = translations[i];
+        auto area = sweptAABB(AABB::CreateFromPolygon(polygons[i]), translation);
+        _query.hits.clear();
+        _query.tree.query(area, _query.hits);
+        for(auto b : _query.hits) {
+            if(_rigidbodies[b].collider->isTrigger)
+                continue;
+            auto body = _rigidbodies.handleAt(b);
+            m_forEachQueryPiece(b, area, [&](const Circle* circle, const std::vector<vec2f>* vertices, const std::vector<vec2f>*, const std::vector<float>*) {
+                if(circle)
+                    keepFirst(hits[i], epi::castPolygon(moving, translation, *circle), body);
+                else
+                    keepFirst(hits[i], epi::castPolygon(moving, translation, *vertices), body);
+            });
+        }
+    }
+}
+IntersectionPolygonCircleResult PhysicsManager::m_collideParticle(size_t body_idx, const Circle& particle) {
+    auto& man = _rigidbodies[body_idx];
+    auto& col = *man.collider;
+    switch(col.type) {
+        case eCollisionShape::Circle:
+            return intersectCircleCircle(particle, col.getCircleShape(*man.transform));
+        case eCollisionShape::Polygon: {
+            auto& scratch = _particle_scratch;
+            if(!scratch.isPolygonReady[body_idx]) {
+                col.getPolygonShape(*man.transform, scratch.polygons[body_idx]);
+                scratch.isPolygonReady[body_idx] = true;
+            }
+            return intersectCirclePolygon(particle, scratch.polygons[body_idx]);
+        }
+        case eCollisionShape::Ray: {
+            Ray t = col.getRayShape(*man.transform);
+            vec2f closest = findClosestPointOnRay(t.pos, t.dir, particle.pos);
+            vec2f dist = particle.pos - closest;
+            float l = len(dist);
+            if(l > particle.radius)
+                return {false};
+            vec2f cn = l == 0.f ? norm(vec2f(-t.dir.y, t.dir.x)) : dist / l;
+            return {true, cn, closest, particle.radius - l};
+        }
+        case eCollisionShape::Chain:
+            return intersectCircleChain(particle, col.getChainModel(), *man.transform);
+        case eCollisionShape::Compound:
+            return intersectCircleCompound(particle, col.getCompoundModel(), *man.transform);
+    }
+    return {false};
+}
+void PhysicsManager::m_buildParticleScratch() {
+    auto& scratch = _particle_scratch;
+    size_t body_count = _rigidbodies.size();
+    scratch.grid.clear();
+    for(size_t i = 0; i < body_count; i++)
+        scratch.grid.push(getAABBfromRigidbody(_rigidbodies[i]));
+    scratch.grid.build();
+    scratch.polygons.resize(body_count);
+    scratch.isPolygonReady.assign(body_count, false);
+}
+void PhysicsManager::processFluid(FluidManager& fluid, float delT) {
+    auto& scratch = _particle_scratch;
+    float step = delT / (float)std::max<size_t>(1, fluid.substeps);
+    float radius = fluid.getParticleRadius();
+    float mass = fluid.getParticleMass();
+    vec2f pad(radius, radius);
+    for(size_t s = 0; s < fluid.substeps; s++) {
+        fluid.m_predict(step, gravity);
+        //bodies are the boundary of the fluid, momentum taken from particles is given to them, which makes them float
+        for(size_t i = 0; i < fluid.size(); i++) {
+            vec2f pos = fluid.getPos(i);
+            scratch.hits.clear();
+            scratch.grid.query(AABB::CreateMinMax(pos - pad, pos + pad), scratch.hits);
+            for(auto b : scratch.hits) {
+                auto& man = _rigidbodies[b];
+                if(man.collider->isTrigger)
+                    continue;
+                auto res = m_collideParticle(b, Circle(pos, radius));
+                if(!res.detected)
+                    continue;
+                //velocity is derived from displacement, so pushing particle out gives it momentum, which body loses
+                vec2f push = res.contact_normal * res.overlap;
+                pos += push;
+                auto& rb = *man.rigidbody;
+                if(rb.isStatic)
+                    continue;
+                vec2f rad = res.contact_point - man.transform->getPos();
+                vec2f impulse = push * mass / step;
+                rb.velocity -= impulse / rb.mass;
+                if(!rb.lockRotation)
+                    rb.angular_velocity += cross(impulse, rad) / man.collider->getInertia(rb.mass);
+                wakeUp(man.collider);
+            }
+            fluid._pos_x[i] = pos.x;
+            fluid._pos_y[i] = pos.y;
+        }
+        fluid.m_finish(step);
+    }
+}
+void PhysicsManager::processParticles(ParticleManager& pm) {
+    auto& scratch = _particle_scratch;
+
+    //stuck particles follow their bodies, the ones whose body was removed fall off
+    for(size_t i = 0; i < pm.size(); i++) {
+        if(!pm.isStuck(i))
+            continue;
+        auto man = _rigidbodies.get(pm._stuck_to[i]);
+        if(!man) {
+            pm.m_unstick(i);
+            continue;
+        }
+        vec2f pos = man->transform->getPos() + man->transform->getRotation().rotate(pm._stuck_offset[i]);
+        pm._pos_x[i] = pos.x;
+        pm._pos_y[i] = pos.y;
+    }
+
+    vec2f pad(pm.radius, pm.radius);
+    for(size_t i = 0; i < pm.size(); i++) {
+        if(pm.isStuck(i) || !(pm._life[i] > 0.f))
+            continue;
+        vec2f pos = pm.getPos(i);
+        vec2f vel = pm.getVel(i);
+        scratch.hits.clear();
+        scratch.grid.query(AABB::CreateMinMax(pos - pad, pos + pad), scratch.hits);
+        for(auto b : scratch.hits) {
+            auto& man = _rigidbodies[b];
+            if(man.collider->isTrigger)
+                continue;
+            auto res = m_collideParticle(b, Circle(pos, pm.radius));
+            if(!res.detected)
+                continue;
+            _stats.particle_contacts++;
+            pos += res.contact_normal * res.overlap;
+
+            auto& rb = *man.rigidbody;
+            vec2f rad = res.contact_point - man.transform->getPos();
+            vec2f body_vel = rb.isStatic ? vec2f(0, 0) : rb.velocity + (rb.lockRotation ? vec2f(0, 0) : vec2f(-rad.y, rad.x) * rb.angular_velocity);
+            float vn = dot(vel - body_vel, res.contact_normal);
+            //only bouncing particles give energy back, the rest stop against the body
+            float bounce = pm.response == eParticleResponse::Bounce ? pm.restitution : 0.f;
+            if(pm.isTwoWay && !rb.isStatic && vn < 0.f) {
+                vec2f impulse = res.contact_normal * (-(1.f + bounce) * vn * pm.mass);
+                rb.velocity -= impulse / rb.mass;
+                if(!rb.lockRotation)
+                    rb.angular_velocity += cross(impulse, rad) / man.collider->getInertia(rb.mass);
+                wakeUp(man.collider);
+            }
+            if(pm.response == eParticleResponse::Kill) {
+                pm.kill(i);
+                break;
+            }
+            if(pm.response == eParticleResponse::Stick) {
+                pm.m_stick(i, _rigidbodies.handleAt(b), man.transform->getRotation().inverseRotate(pos - man.transform->getPos()));
+                vel = vec2f(0, 0);
+                break;
+            }
+            if(vn < 0.f) {
+                vec2f rel = vel - body_vel;
+                vec2f tangent = rel - res.contact_normal * vn;
+                vel = body_vel + tangent * (1.f - pm.friction) - res.contact_normal * (vn * pm.restitution);
+            }
+        }
+        pm._pos_x[i] = pos.x;
+        pm._pos_y[i] = pos.y;
+        pm._vel_x[i] = vel.x;
+        pm._vel_y[i] = vel.y;
+    }
 }
 
 }
@@ -1,23 +1,128 @@
 #pragma once
+#include "aabb_grid.hpp"
 #include "solver.hpp"
 #include "rigidbody.hpp"
 #include "restraint.hpp"
+#include "contact_cache.hpp"
+#include "frame_arena.hpp"
+#include "handle_map.hpp"
+#include "shape_cast.hpp"
+#include "static_bvh.hpp"
 
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <memory_resource>
 #include <stdexcept>
 #include <vector>
 #include <set>
+#include <string>
+#include <unordered_set>
 
 
 namespace epi {
 
-struct ParticleManager;
+class ParticleManager;
+class FluidManager;
+class Recorder;
+class ReplayPlayer;
+class BodyBatch;
+struct BodyBatchDesc;
+
+typedef Handle<RigidManifold> RigidbodyHandle;
+typedef Handle<Restraint> RestraintHandle;
+
+//counters and timings gathered during last update, times are in seconds and summed over all substeps
+struct PhysicsStats {
+    size_t rigidbodies = 0;
+    size_t sleeping = 0;
+    size_t broadphase_pairs = 0;
+    size_t narrowphase_tests = 0;
+    size_t contacts = 0;
+    //pairs with a trigger tested for overlap once per update and how many of them overlapped
+    size_t trigger_tests = 0;
+    size_t trigger_overlaps = 0;
+    size_t particles = 0;
+    size_t particle_contacts = 0;
+    size_t fluid_particles = 0;
+    //bodies baked into static tree, they are not part of broadphase sort
+    size_t static_bodies = 0;
+    //bytes of frame arena used by temporaries of the update
+    size_t frame_arena_bytes = 0;
+
+    double time_broadphase = 0.0;
+    double time_narrowphase = 0.0;
+    double time_restraints = 0.0;
+    double time_integration = 0.0;
+    double time_sleeping = 0.0;
+    double time_triggers = 0.0;
+    double time_particles = 0.0;
+    double time_fluid = 0.0;
+    double time_total = 0.0;
+};
+//first body hit by a ray or a cast shape, time, point and normal have the same meaning as in CastResult
+struct CastHit {
+    bool detected = false;
+    float time = 1.f;
+    vec2f point;
+    vec2f normal;
+    RigidbodyHandle body;
+};
+/*
+* \brief dynamic state of simulated world captured by PhysicsManager::saveState
+* only poses, velocities, forces, sleep/island state, contacts, bound particles and fluid are stored, colliders and materials are never copied
+* buffers are reused, so saving into the same state again does not allocate once it is big enough
+*/
+struct WorldState {
+    //used to check that restored world still has the same bodies in the same order
+    std::vector<RigidbodyHandle> handles;
+    std::vector<vec2f> pos;
+    std::vector<float> rot;
+    std::vector<vec2f> velocity;
+    std::vector<float> angular_velocity;
+    std::vector<vec2f> force;
+    std::vector<float> angular_force;
+    std::vector<float> time_immobile;
+    std::vector<Collider*> parent_collider;
+    std::vector<uint8_t> isSleeping;
+
+    //arrays of bound ParticleManager, left empty when none is bound
+    struct {
+        std::vector<float> pos_x;
+        std::vector<float> pos_y;
+        std::vector<float> vel_x;
+        std::vector<float> vel_y;
+        std::vector<float> life;
+        std::vector<float> mobility;
+        std::vector<RigidbodyHandle> stuck_to;
+        std::vector<vec2f> stuck_offset;
+    }particles;
+    //arrays of bound FluidManager, left empty when none is bound
+    struct {
+        std::vector<float> pos_x;
+        std::vector<float> pos_y;
+        std::vector<float> vel_x;
+        std::vector<float> vel_y;
+        std::vector<float> prev_x;
+        std::vector<float> prev_y;
+        std::vector<float> density;
+        std::vector<float> near_density;
+    }fluid;
+
+    ContactCache contacts;
+    std::vector<ContactEvent> contact_events;
+    ContactCache triggers;
+    std::vector<ContactEvent> trigger_events;
+    //number of updates done when state was saved
+    size_t update_count = 0;
+    uint64_t state_hash = 0;
+};
 /*
  * \brief used to process collision detection and resolution as well as restraints on rigidbodies
  * every Solver, RigidManifold and Trigger have to be bound to be processed, and unbound to stop processing
  * when destroyed all objects will be automaticly unbound
+ * adding is deferred to the beginning of next update, removed rigidbodies leave right away and their contacts are cleaned up then
  */
 class PhysicsManager {
 public:
@@ -46,14 +151,107 @@ private:
     };
 
 
-    std::vector<RigidManifold> _rigidbodies;
-    std::vector<Restraint*> _restraints;
+    HandleMap<RigidManifold> _rigidbodies;
+    HandleMap<Restraint*, Restraint> _restraints;
+
+    /*
+    * bodies are taken out of dense storage right in remove, but contacts and islands they were part of are cleaned up
+    * by the next update, removed colliders might be destroyed by then, so only their addresses are kept
+    */
+    struct PendingRemoval {
+        RigidbodyHandle handle;
+        const Collider* collider;
+        const Collider* parent_collider;
+        bool isStatic;
+    };
+    struct {
+        std::vector<std::pair<RigidbodyHandle, RigidManifold>> rigidbodies_added;
+        std::vector<PendingRemoval> rigidbodies_removed;
+        std::vector<std::pair<RestraintHandle, Restraint*>> restraints_added;
+        std::vector<RestraintHandle> restraints_removed;
+    }_pending;
 
     SolverInterface* _solver = new DefaultSolver();
+    ParticleManager* _particles = nullptr;
+    FluidManager* _fluid = nullptr;
+    //bounds and shapes of rigidbodies used by processParticles and processFluid, reused between updates
+    struct {
+        AABBGrid grid;
+        //world space polygons, computed once per update for bodies touched by particles
+        std::vector<Polygon> polygons;
+        std::vector<uint8_t> isPolygonReady;
+        std::vector<uint32_t> hits;
+    }_particle_scratch;
+    //colliders of bodies removed by applyPending and their neighbours, cleared and reused so removals do not allocate each frame
+    struct {
+        std::unordered_set<const Collider*> removed;
+        //islands that the removed colliders belonged to
+        std::unordered_set<const Collider*> woken_parents;
+        std::vector<Collider*> touching;
+        std::vector<Collider*> sensed;
+    }_removal_scratch;
+    //static bodies baked into a tree, which is rebuilt only when static geometry changes and queried by dynamic bodies
+    struct {
+        StaticBVH tree;
+        //handle of body behind every box of the tree, unlike dense indices it does not change when other bodies are removed
+        std::vector<RigidbodyHandle> bodies;
+        //isStatic of body in every handle slot when tree was baked, so that toggling the flag is noticed
+        std::vector<uint8_t> wasStatic;
+        //colliders of bodies in the tree, used to tell which cached contacts are resting
+        std::unordered_set<const Collider*> colliders;
+        //results of a single query, reused by every dynamic body
+        std::vector<uint32_t> hits;
+        bool isDirty = true;
+    }_static;
+    //tree of all bodies used by raycasts and shape casts, built by the first query after every update
+    struct {
+        StaticBVH tree;
+        //update count when tree was built
+        size_t built_at = SIZE_MAX;
+        std::vector<std::pair<uint32_t, uint32_t>> candidates;
+        std::vector<uint32_t> hits;
+        //polygon bodies in world space with their edge lines, placed once per tree for bodies touched by queries
+        std::vector<Polygon> polygons;
+        std::vector<std::vector<vec2f>> normals;
+        std::vector<std::vector<float>> offsets;
+        std::vector<uint8_t> isPolygonReady;
+        //single child of compound, segment of chain or ray collider, placed for one test at a time
+        std::vector<uint32_t> children;
+        Polygon piece_polygon;
+        std::vector<vec2f> piece_vertices;
+        std::vector<vec2f> piece_normals;
+        std::vector<float> piece_offsets;
+    }_query;
+
+    //temporaries of broadphase, narrowphase and sleeping, reset at the beginning of every update
+    FrameArena _arena;
+    ContactCache _contact_cache;
+    std::vector<ContactEvent> _contact_events;
+    ContactCache _trigger_cache;
+    std::vector<ContactEvent> _trigger_events;
+    PhysicsStats _stats;
+    size_t _update_count = 0;
+    uint64_t _state_hash = 14695981039346656037ull;
+    Recorder* _recorder = nullptr;
+    //set while update is iterating bodies, removals made then (e.g. from collision callbacks) are queued until it returns
+    bool _isUpdating = false;
 
-    std::vector<ColInfo> processBroadPhase();
-    void processNarrowPhase(const std::vector<ColInfo>& col_info);
+    std::pmr::vector<ColInfo> processBroadPhase(float delT);
+    void processNarrowPhase(const std::pmr::vector<ColInfo>& col_info);
+    void processTriggers(const std::pmr::vector<ColInfo>& trigger_list);
     void processSleeping();
+    void applyPending();
+    //takes body out of dense storage and of the trees that refer to it
+    void m_eraseRigidbody(const PendingRemoval& removal);
+    void m_bakeStatic();
+    void m_prepareQueries();
+    /*
+    * calls on_piece(circle, vertices, normals, offsets) for every convex piece of body near area,
+    * circle is nullptr for polygons and segments, which have 2 vertices, the rest are nullptr for circles
+    */
+    template<class OnPiece>
+    void m_forEachQueryPiece(size_t body_idx, const AABB& area, OnPiece on_piece);
+    void m_hashState();
 
     void updateRigidObj(RigidManifold& man, float delT);
 
@@ -61,12 +259,19 @@ private:
     void updateRestraints(float delT);
 
     void processParticles(ParticleManager& pm);
+    void processFluid(FluidManager& fluid, float delT);
+    //prepares _particle_scratch for current poses of rigidbodies
+    void m_buildParticleScratch();
+    //particle against body at dense index, normal points from the body towards the particle
+    IntersectionPolygonCircleResult m_collideParticle(size_t body_idx, const Circle& particle);
     static AABB getAABBfromRigidbody(RigidManifold man) {
         return man.collider->getAABB(*man.transform);
     }
 public:
     //number of physics/collision steps per frame
     size_t steps = 2;
+    //acceleration applied to every non static rigidbody
+    vec2f gravity = {0.f, 0.f};
 
     /*
     * updates all rigidbodies bound applying their velocities and resoving collisions
@@ -74,27 +279,162 @@ public:
     */
     void update(float delT);
 
+    //if true every collider is notified from inside narrowphase on every substep, as opposed to only filling contact events
+    //colliders overlapping a trigger are notified once per update, with info that has no normal nor contact points
+    bool synchronous_notify = false;
+    //if true poses and velocities of all rigidbodies are hashed at the end of every update, see getStateHash
+    bool hash_state = EPI_DETERMINISTIC;
+
+    const PhysicsStats& getStats() const {
+        return _stats;
+    }
+    //memory used for temporaries of last update, its capacity grows to the biggest update seen and is then reused
+    const FrameArena& getFrameArena() const {
+        return _arena;
+    }
+    //contacts recorded during last update, filled once per frame after all substeps
+    //contacts between sleeping or static bodies persist with their last geometry until one of them wakes up or is removed
+    const std::vector<ContactEvent>& getContactEvents() const {
+        return _contact_events;
+    }
+    /*
+    * enter (Begin), stay (Persist) and exit (End) of overlaps between triggers and other colliders during last update
+    * triggers are only tested for overlap once per frame after all substeps, so these events carry no geometry
+    * and pairs with a trigger never appear in getContactEvents, bodies sleeping in a static trigger stay in it until they wake up
+    */
+    const std::vector<ContactEvent>& getTriggerEvents() const {
+        return _trigger_events;
+    }
+
     //mode used to select bounce when colliding
     eSelectMode bounciness_select = eSelectMode::Min;
     //mode used to select friciton when colliding
     eSelectMode friction_select = eSelectMode::Min;
 
 
-    //used to add any rigidbody
-    void add(RigidManifold man);
+    //used to add any rigidbody, it will be simulated starting from next update
+    RigidbodyHandle add(RigidManifold man);
+    /*
+    * adds many polygon bodies at once, their components are created in a single allocation owned by returned batch
+    * handles and dense storage are reserved in bulk and static bodies of the batch are baked into the tree together
+    * returns nullptr and fills error when a required array is missing or an id is out of range
+    */
+    std::unique_ptr<BodyBatch> addBatch(const BodyBatchDesc& desc, std::string* error = nullptr);
     //used to add solver that is used to resolve collisions
     inline void bind(SolverInterface* solver) {
         _solver = solver;
     }
+    //particles are moved and collided with rigidbodies on every update, nullptr unbinds them
+    inline void bind(ParticleManager* particles) {
+        _particles = particles;
+    }
+    ParticleManager* getParticles() const {
+        return _particles;
+    }
+    //fluid is stepped and coupled with rigidbodies on every update, nullptr unbinds it
+    inline void bind(FluidManager* fluid) {
+        _fluid = fluid;
+    }
+    FluidManager* getFluid() const {
+        return _fluid;
+    }
+    /*
+    * static bodies are baked into a tree, which is rebuilt when static bodies are added or removed or isStatic flag
+    * of any body changes, call this after moving or reshaping a static body so that tree is rebuilt too
+    */
+    void markStaticChanged() {
+        _static.isDirty = true;
+    }
     //used to add restraints applied on rigidbodies bound
-    void add(Restraint* restraint);
-    //removes rigidbody from manager
-    void remove(RigidManifold rb);
-    //removes restraint from manager
-    void remove(const Restraint* restriant);
+    RestraintHandle add(Restraint* restraint);
+    /*
+    * removes rigidbody right away, objects touching it will be woken up at the beginning of next update
+    * rigidbody's components can be destroyed right after this call, unless it is made from inside of update
+    * (e.g. from a collision callback), then they have to stay alive until that update returns
+    */
+    void remove(RigidbodyHandle handle);
+    //queues restraint for removal
+    void remove(RestraintHandle handle);
+
+    //returns nullptr if handle is stale
+    RigidManifold* get(RigidbodyHandle handle);
+    //returns nullptr if handle is stale
+    Restraint* get(RestraintHandle handle);
+    size_t getRigidbodyCount() const {
+        return _rigidbodies.size();
+    }
+    //number of finished updates
+    size_t getUpdateCount() const {
+        return _update_count;
+    }
+    /*
+    * hash of poses and velocities chained over every update done with hash_state enabled
+    * two managers fed with the same changes have equal hashes until their simulations diverge
+    * exact across machines only when built with EPI_DETERMINISTIC
+    */
+    uint64_t getStateHash() const {
+        return _state_hash;
+    }
+
+    /*
+    * first body hit by every ray going from pos to pos + dir, hits[i] is written for rays[i]
+    * consecutive rays are traversed through the tree of bodies together, so rays of one sensor should be kept next to each other
+    * bodies are taken as they were after last update, triggers are never hit and chains are solid from both sides
+    */
+    void raycast(const Ray* rays, size_t count, CastHit* hits);
+    void raycast(const std::vector<Ray>& rays, std::vector<CastHit>& hits) {
+        hits.resize(rays.size());
+        raycast(rays.data(), rays.size(), hits.data());
+    }
+    CastHit raycast(const Ray& ray) {
+        CastHit hit;
+        raycast(&ray, 1, &hit);
+        return hit;
+    }
+    //first body touched by every circle moved by its translation, hits[i] is written for circles[i]
+    void castCircles(const Circle* circles, const vec2f* translations, size_t count, CastHit* hits);
+    CastHit castCircle(const Circle& circle, vec2f translation) {
+        CastHit hit;
+        castCircles(&circle, &translation, 1, &hit);
+        return hit;
+    }
+    //first body touched by every convex polygon moved by its translation, polygons are taken as they are placed in world
+    void castPolygons(const Polygon* polygons, const vec2f* translations, size_t count, CastHit* hits);
+    CastHit castPolygon(const Polygon& polygon, vec2f translation) {
+        CastHit hit;
+        castPolygons(&polygon, &translation, 1, &hit);
+        return hit;
+    }
+
+    //copies dynamic state of all simulated rigidbodies and of bound particles and fluid into state, reusing its buffers
+    void saveState(WorldState& state) const;
+    /*
+    * brings simulated rigidbodies, bound particles and fluid back to state saved by saveState, pending additions and removals are kept
+    * returns false and changes nothing if set of simulated rigidbodies changed since state was saved
+    */
+    bool restoreState(const WorldState& state);
+
+    //rigidbodies simulated during last update, pending changes are not included
+    const HandleMap<RigidManifold>& getRigidbodies() const {
+        return _rigidbodies;
+    }
+    //restraints simulated during last update, pending changes are not included
+    const HandleMap<Restraint*, Restraint>& getRestraints() const {
+        return _restraints;
+    }
+
+    /*
+    * every change made to the world from now on is logged by recorder, nullptr stops recording
+    * recorder has to stay alive until it is unbound or the manager is destroyed
+    */
+    void setRecorder(Recorder* recorder) {
+        _recorder = recorder;
+    }
 
     //size should be max simulated size
     PhysicsManager(AABB size) {}
     ~PhysicsManager() {}
+    friend Recorder;
+    friend ReplayPlayer;
 };
 }
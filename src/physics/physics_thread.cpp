@@ -0,0 +1,107 @@
+#include "physics_thread.hpp"
+#include "collider.hpp"
+#include "fluid_manager.hpp"
+#include "particle_manager.hpp"
+#include "profiler.hpp"
+#include "rigidbody.hpp"
+
+#include <chrono>
+
+namespace epi {
+
+//when physics falls behind by more updates than this it stops catching up, instead of slowing down even more
+static const int MAX_CATCH_UP_UPDATES = 5;
+
+void PhysicsThread::start() {
+    if(_isRunning.exchange(true))
+        return;
+    _thread = std::thread(&PhysicsThread::m_run, this);
+}
+void PhysicsThread::stop() {
+    if(!_isRunning.exchange(false))
+        return;
+    _thread.join();
+    m_applyCommands();
+}
+uint64_t PhysicsThread::enqueue(PhysicsCommand cmd) {
+    if(!isRunning()) {
+        //thread is joined, so nothing else touches the manager
+        cmd(_manager);
+        std::lock_guard<std::mutex> lock(_commands_mutex);
+        _commands_applied++;
+        return ++_commands_enqueued;
+    }
+    std::lock_guard<std::mutex> lock(_commands_mutex);
+    _commands.push_back(std::move(cmd));
+    return ++_commands_enqueued;
+}
+void PhysicsThread::m_applyCommands() {
+    {
+        std::lock_guard<std::mutex> lock(_commands_mutex);
+        std::swap(_commands, _executing);
+    }
+    for(auto& cmd : _executing)
+        cmd(_manager);
+    _commands_applied += _executing.size();
+    _executing.clear();
+}
+void PhysicsThread::m_publish() {
+    EPI_PROFILE_FUNCTION();
+    auto& snapshot = _snapshots.getWriteBuffer();
+    auto& rigidbodies = _manager.getRigidbodies();
+    snapshot.bodies.resize(rigidbodies.size());
+    snapshot.grid.clear();
+    for(size_t i = 0; i < rigidbodies.size(); i++) {
+        auto& man = rigidbodies[i];
+        snapshot.bodies[i] = {man.collider, man.transform->getPos(), man.transform->getRot(), man.transform->getScale(),
+            man.rigidbody->isStatic, man.collider->isSleeping};
+        snapshot.grid.push(man.collider->getAABB(*man.transform));
+    }
+    snapshot.grid.build();
+    snapshot.particles.clear();
+    if(auto particles = _manager.getParticles()) {
+        snapshot.particles.resize(particles->size());
+        for(size_t i = 0; i < particles->size(); i++)
+            snapshot.particles[i] = particles->getPos(i);
+    }
+    snapshot.fluid.clear();
+    if(auto fluid = _manager.getFluid()) {
+        snapshot.fluid.resize(fluid->size());
+        for(size_t i = 0; i < fluid->size(); i++)
+            snapshot.fluid[i] = fluid->getPos(i);
+    }
+    snapshot.stats = _manager.getStats();
+    snapshot.update_count = _manager.getUpdateCount();
+    snapshot.commands_applied = _commands_before_update;
+    _snapshots.publish();
+}
+bool PhysicsThread::acquireSnapshot() {
+    if(!isRunning())
+        m_publish();
+    return _snapshots.acquire();
+}
+void PhysicsThread::m_run() {
+    EPI_PROFILE_THREAD("physics");
+    typedef std::chrono::steady_clock clock;
+    auto next_update = clock::now();
+    while(_isRunning.load(std::memory_order_relaxed)) {
+        float step_time = getStepTime();
+        auto step = std::chrono::duration_cast<clock::duration>(std::chrono::duration<float>(step_time));
+        int updates = 0;
+        while(clock::now() >= next_update && updates < MAX_CATCH_UP_UPDATES) {
+            m_applyCommands();
+            _commands_before_update = _commands_applied;
+            _manager.update(step_time);
+            if(on_update)
+                on_update(_manager);
+            m_publish();
+            next_update += step;
+            updates++;
+        }
+        if(updates == MAX_CATCH_UP_UPDATES && clock::now() >= next_update)
+            next_update = clock::now();
+        std::this_thread::sleep_until(next_update);
+    }
+}
+
+}
@@ -0,0 +1,107 @@
+#pragma once
+#include "aabb_grid.hpp"
+#include "physics_manager.hpp"
+#include "triple_buffer.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace epi {
+
+typedef std::function<void(PhysicsManager&)> PhysicsCommand;
+
+//pose and draw state of one rigidbody at the time snapshot was taken
+struct RenderBody {
+    //identifies the body and gives its shape, physics never changes shape of collider after it was added
+    const Collider* collider;
+    vec2f pos;
+    float rot;
+    vec2f scale;
+    bool isStatic;
+    bool isSleeping;
+};
+struct RenderSnapshot {
+    //every simulated rigidbody in dense order of the manager
+    std::vector<RenderBody> bodies;
+    //bounding boxes of bodies (box i belongs to body i), built on physics thread so that views can be culled cheaply
+    AABBGrid grid;
+    //positions of particles bound to the manager
+    std::vector<vec2f> particles;
+    //positions of fluid particles bound to the manager
+    std::vector<vec2f> fluid;
+    PhysicsStats stats;
+    //number of updates done before snapshot was taken
+    size_t update_count = 0;
+    //number of commands applied before snapshot was taken, compare with ids returned by PhysicsThread::enqueue
+    uint64_t commands_applied = 0;
+};
+
+/*
+* \brief runs PhysicsManager on its own thread at fixed rate, decoupled from rendering
+* every change to the world has to be sent as command, commands are applied on physics thread right before next update
+* after every update poses are published into triple buffered RenderSnapshot, which reader takes without waiting
+* while stopped, commands are applied right away on the calling thread, so the same code works in both modes
+*/
+class PhysicsThread {
+    PhysicsManager& _manager;
+    std::thread _thread;
+    std::atomic<bool> _isRunning{false};
+    std::atomic<float> _step_time{1.f / 60.f};
+
+    std::mutex _commands_mutex;
+    std::vector<PhysicsCommand> _commands;
+    uint64_t _commands_enqueued = 0;
+    //used only by thread applying commands
+    std::vector<PhysicsCommand> _executing;
+    uint64_t _commands_applied = 0;
+    //commands applied before the last update, removals take effect only during update, so only these are reported
+    uint64_t _commands_before_update = 0;
+
+    TripleBuffer<RenderSnapshot> _snapshots;
+
+    void m_applyCommands();
+    void m_publish();
+    void m_run();
+public:
+    //called on physics thread after every update, can only be changed while stopped
+    std::function<void(PhysicsManager&)> on_update;
+
+    void start();
+    //waits for the current update to finish, commands still queued are applied
+    void stop();
+    bool isRunning() const {
+        return _isRunning.load(std::memory_order_relaxed);
+    }
+    //simulated time of one update, physics tries to do 1 / step_time updates per second
+    void setStepTime(float step_time) {
+        _step_time.store(step_time, std::memory_order_relaxed);
+    }
+    float getStepTime() const {
+        return _step_time.load(std::memory_order_relaxed);
+    }
+
+    //queues cmd and returns its id, commands are applied in order of enqueueing
+    uint64_t enqueue(PhysicsCommand cmd);
+    /*
+    * takes newest published snapshot, returns false if there was none newer than current
+    * when stopped, snapshot of current state is taken instead
+    */
+    bool acquireSnapshot();
+    const RenderSnapshot& getSnapshot() const {
+        return _snapshots.getReadBuffer();
+    }
+
+    PhysicsThread(PhysicsManager& manager) : _manager(manager) {}
+    ~PhysicsThread() {
+        stop();
+    }
+    PhysicsThread(const PhysicsThread&) = delete;
+    PhysicsThread& operator=(const PhysicsThread&) = delete;
+};
+
+}
@@ -0,0 +1,209 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <unordered_set>
+
+namespace epi {
+
+Profiler::Profiler() : _epoch(std::chrono::steady_clock::now()), _frames(FRAME_CAPACITY, {0, 0}) {
+}
+Profiler& Profiler::get() {
+    static Profiler s_profiler;
+    return s_profiler;
+}
+struct Profiler::ThreadBufferOwner {
+    ThreadBuffer* buffer = nullptr;
+    ~ThreadBufferOwner() {
+        if(buffer)
+            Profiler::get().m_releaseBuffer(*buffer);
+    }
+};
+Profiler::ThreadBuffer& Profiler::m_threadBuffer() {
+    thread_local ThreadBufferOwner t_owner;
+    if(t_owner.buffer)
+        return *t_owner.buffer;
+    std::lock_guard<std::mutex> lock(_registry_mutex);
+    ThreadBuffer* buffer = nullptr;
+    if(_free_buffers.size() != 0) {
+        buffer = _free_buffers.back();
+        _free_buffers.pop_back();
+        m_drain(*buffer);
+    } else {
+        _threads.push_back(std::make_unique<ThreadBuffer>());
+        buffer = _threads.back().get();
+        buffer->slots = std::unique_ptr<Slot[]>(new Slot[ZONE_CAPACITY]);
+    }
+    buffer->id = _next_thread_id++;
+    buffer->name = "thread " + std::to_string(buffer->id);
+    t_owner.buffer = buffer;
+    return *buffer;
+}
+void Profiler::m_releaseBuffer(ThreadBuffer& buffer) {
+    std::lock_guard<std::mutex> lock(_registry_mutex);
+    _free_buffers.push_back(&buffer);
+}
+void Profiler::m_drain(ThreadBuffer& buffer) {
+    m_collectZones(buffer, 0, UINT64_MAX, _retired_zones);
+    _retired_names.push_back({buffer.id, buffer.name});
+    buffer.written.store(0, std::memory_order_release);
+    buffer.depth = 0;
+    if(_retired_zones.size() <= ZONE_CAPACITY)
+        return;
+    //threads are drained in order they exited, so the oldest zones are at the front
+    _retired_zones.erase(_retired_zones.begin(), _retired_zones.end() - ZONE_CAPACITY);
+    std::unordered_set<uint32_t> kept_ids;
+    for(auto& z : _retired_zones)
+        kept_ids.insert(z.thread_id);
+    std::erase_if(_retired_names, [&](const std::pair<uint32_t, std::string>& n) {
+        return !kept_ids.contains(n.first);
+    });
+}
+void Profiler::m_record(ThreadBuffer& buffer, const char* name, uint64_t start, uint64_t end, uint32_t depth) {
+    uint64_t idx = buffer.written.load(std::memory_order_relaxed);
+    auto& slot = buffer.slots[idx % ZONE_CAPACITY];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.end.store(end, std::memory_order_relaxed);
+    slot.depth.store(depth, std::memory_order_relaxed);
+    buffer.written.store(idx + 1, std::memory_order_release);
+}
+Profiler::Zone::Zone(const char* name) : _buffer(Profiler::get().m_threadBuffer()), _name(name) {
+    _depth = _buffer.depth++;
+    _start = Profiler::get().now();
+}
+Profiler::Zone::~Zone() {
+    auto& profiler = Profiler::get();
+    _buffer.depth--;
+    profiler.m_record(_buffer, _name, _start, profiler.now(), _depth);
+}
+void Profiler::setThreadName(std::string name) {
+    auto& buffer = m_threadBuffer();
+    std::lock_guard<std::mutex> lock(_registry_mutex);
+    buffer.name = name;
+}
+void Profiler::markFrame() {
+    auto t = now();
+    if(_frame_start != 0) {
+        _frames[_frames_written % FRAME_CAPACITY] = {_frame_start, t};
+        _frames_written++;
+    }
+    _frame_start = t;
+}
+size_t Profiler::getFrameCount() const {
+    return std::min(_frames_written, FRAME_CAPACITY);
+}
+Profiler::FrameRecord Profiler::getFrame(size_t age) const {
+    if(age >= getFrameCount())
+        return {0, 0};
+    return _frames[(_frames_written - 1 - age) % FRAME_CAPACITY];
+}
+std::vector<float> Profiler::getFrameTimesMs() const {
+    std::vector<float> result;
+    size_t count = getFrameCount();
+    result.reserve(count);
+    for(size_t age = count; age > 0; age--) {
+        auto frame = getFrame(age - 1);
+        result.push_back(static_cast<float>(frame.end - frame.start) / 1e6f);
+    }
+    return result;
+}
+size_t Profiler::getWorstFrameAge() const {
+    size_t worst = 0;
+    uint64_t worst_time = 0;
+    for(size_t age = 0; age < getFrameCount(); age++) {
+        auto frame = getFrame(age);
+        if(frame.end - frame.start > worst_time) {
+            worst_time = frame.end - frame.start;
+            worst = age;
+        }
+    }
+    return worst;
+}
+void Profiler::m_collectZones(const ThreadBuffer& buffer, uint64_t start, uint64_t end, std::vector<ZoneRecord>& result) {
+    size_t first_of_thread = result.size();
+    uint64_t written = buffer.written.load(std::memory_order_acquire);
+    uint64_t oldest = written > ZONE_CAPACITY ? written - ZONE_CAPACITY : 0;
+    std::vector<uint64_t> indices;
+    for(uint64_t i = oldest; i < written; i++) {
+        auto& slot = buffer.slots[i % ZONE_CAPACITY];
+        ZoneRecord rec = {slot.name.load(std::memory_order_relaxed), slot.start.load(std::memory_order_relaxed),
+            slot.end.load(std::memory_order_relaxed), slot.depth.load(std::memory_order_relaxed), buffer.id};
+        if(rec.end < start || rec.start > end)
+            continue;
+        result.push_back(rec);
+        indices.push_back(i);
+    }
+    //slots that the owning thread could have overwritten while they were being copied are dropped
+    uint64_t written_after = buffer.written.load(std::memory_order_acquire);
+    if(written_after > ZONE_CAPACITY && written_after - ZONE_CAPACITY > oldest) {
+        uint64_t safe_from = written_after - ZONE_CAPACITY;
+        size_t kept = first_of_thread;
+        for(size_t i = 0; i < indices.size(); i++) {
+            if(indices[i] >= safe_from)
+                result[kept++] = result[first_of_thread + i];
+        }
+        result.resize(kept);
+    }
+    std::sort(result.begin() + first_of_thread, result.end(),
+        [](const ZoneRecord& a, const ZoneRecord& b) {
+            return a.start < b.start || (a.start == b.start && a.depth < b.depth);
+        });
+}
+std::vector<Profiler::ZoneRecord> Profiler::getZones(uint64_t start, uint64_t end) const {
+    std::vector<ZoneRecord> result;
+    std::lock_guard<std::mutex> lock(_registry_mutex);
+    for(auto& z : _retired_zones)
+        if(z.end >= start && z.start <= end)
+            result.push_back(z);
+    for(auto& buffer : _threads)
+        m_collectZones(*buffer, start, end, result);
+    return result;
+}
+bool Profiler::exportChromeTrace(const std::string& filename) const {
+    std::ofstream file(filename);
+    if(!file.is_open())
+        return false;
+    auto zones = getZones(0, UINT64_MAX);
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> lock(_registry_mutex);
+        auto write_name = [&](uint32_t id, const std::string& name) {
+            file << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": " << id
+                << ", \"args\": {\"name\": \"" << name << "\"}}";
+            first = false;
+        };
+        for(auto& n : _retired_names)
+            write_name(n.first, n.second);
+        for(auto& buffer : _threads)
+            write_name(buffer->id, buffer->name);
+    }
+    file.precision(3);
+    file << std::fixed;
+    for(auto& z : zones) {
+        file << (first ? "" : ",\n") << "{\"name\": \"" << (z.name ? z.name : "?") << "\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << z.thread_id
+            << ", \"ts\": " << (double)z.start / 1e3 << ", \"dur\": " << (double)(z.end - z.start) / 1e3 << "}";
+        first = false;
+    }
+    for(size_t age = getFrameCount(); age > 0; age--) {
+        auto frame = getFrame(age - 1);
+        file << (first ? "" : ",\n") << "{\"name\": \"frame\", \"ph\": \"i\", \"s\": \"g\", \"pid\": 0, \"tid\": 0, \"ts\": "
+            << (double)frame.end / 1e3 << "}";
+        first = false;
+    }
+    file << "\n]}\n";
+    return file.good();
+}
+//should be called only when other threads are not recording
+void Profiler::clear() {
+    _frames_written = 0;
+    _frame_start = 0;
+    std::lock_guard<std::mutex> lock(_registry_mutex);
+    for(auto& buffer : _threads)
+        buffer->written.store(0, std::memory_order_release);
+    _retired_zones.clear();
+    _retired_names.clear();
+}
+
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//set to 0 to compile out every EPI_PROFILE_* macro
+#ifndef EPI_PROFILING
+#define EPI_PROFILING 1
+#endif
+
+namespace epi {
+
+/*
+* \brief low overhead hierarchical profiler
+* every thread records finished zones into its own fixed size ring buffer, so recording never locks
+* zones are opened with EPI_PROFILE_SCOPE and closed at the end of the scope, their nesting depth is kept
+* EPI_PROFILE_FRAME marks end of frame, last FRAME_CAPACITY frames are remembered
+* recorded zones can be exported to chrome trace_event json (chrome://tracing, ui.perfetto.dev)
+*/
+class Profiler {
+public:
+    //times are in nanoseconds since profiler creation
+    struct ZoneRecord {
+        const char* name;
+        uint64_t start;
+        uint64_t end;
+        uint32_t depth;
+        uint32_t thread_id;
+    };
+    struct FrameRecord {
+        uint64_t start;
+        uint64_t end;
+    };
+    static constexpr size_t ZONE_CAPACITY = 1 << 16;
+    static constexpr size_t FRAME_CAPACITY = 256;
+private:
+    //fields are atomic so that reading buffers of running threads is not a data race, all accesses are relaxed
+    struct Slot {
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> start;
+        std::atomic<uint64_t> end;
+        std::atomic<uint32_t> depth;
+    };
+    struct ThreadBuffer {
+        uint32_t id;
+        std::string name;
+        std::unique_ptr<Slot[]> slots;
+        std::atomic<uint64_t> written = 0;
+        uint32_t depth = 0;
+    };
+    //returns buffer of its thread to the free list when that thread exits
+    struct ThreadBufferOwner;
+    std::chrono::steady_clock::time_point _epoch;
+    mutable std::mutex _registry_mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> _threads;
+    //buffers of exited threads, reused by threads created later so that short lived threads do not pile up buffers
+    std::vector<ThreadBuffer*> _free_buffers;
+    //zones of exited threads whose buffers were reused, at most ZONE_CAPACITY newest are kept
+    std::vector<ZoneRecord> _retired_zones;
+    std::vector<std::pair<uint32_t, std::string>> _retired_names;
+    uint32_t _next_thread_id = 0;
+
+    std::vector<FrameRecord> _frames;
+    size_t _frames_written = 0;
+    uint64_t _frame_start = 0;
+
+    ThreadBuffer& m_threadBuffer();
+    void m_releaseBuffer(ThreadBuffer& buffer);
+    //moves zones of free buffer into _retired_zones, _registry_mutex has to be held
+    void m_drain(ThreadBuffer& buffer);
+    //appends zones of buffer that overlap [start, end] sorted by start time
+    static void m_collectZones(const ThreadBuffer& buffer, uint64_t start, uint64_t end, std::vector<ZoneRecord>& result);
+    void m_record(ThreadBuffer& buffer, const char* name, uint64_t start, uint64_t end, uint32_t depth);
+    Profiler();
+public:
+    static Profiler& get();
+
+    uint64_t now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _epoch).count();
+    }
+    //name shown for calling thread in exported traces
+    void setThreadName(std::string name);
+    //ends current frame and begins next one, should be called from one thread only
+    void markFrame();
+
+    //durations of remembered frames in milliseconds, oldest first
+    std::vector<float> getFrameTimesMs() const;
+    //frame that ended age frames ago, 0 being the last one
+    FrameRecord getFrame(size_t age) const;
+    size_t getFrameCount() const;
+    //age of the longest remembered frame
+    size_t getWorstFrameAge() const;
+    //zones of all threads that overlap [start, end], sorted by thread and then by start time
+    std::vector<ZoneRecord> getZones(uint64_t start, uint64_t end) const;
+
+    //writes every zone still held in ring buffers as chrome trace_event json, returns false if file could not be opened
+    bool exportChromeTrace(const std::string& filename) const;
+    //forgets all recorded zones and frames
+    void clear();
+
+    class Zone {
+        ThreadBuffer& _buffer;
+        const char* _name;
+        uint64_t _start;
+        uint32_t _depth;
+    public:
+        Zone(const char* name);
+        ~Zone();
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+    };
+};
+
+}
+
+#if EPI_PROFILING
+#define EPI_PROFILE_CONCAT_IMPL(a, b) a##b
+#define EPI_PROFILE_CONCAT(a, b) EPI_PROFILE_CONCAT_IMPL(a, b)
+#define EPI_PROFILE_SCOPE(name) ::epi::Profiler::Zone EPI_PROFILE_CONCAT(epi_profile_zone_, __LINE__)(name)
+#define EPI_PROFILE_FUNCTION() EPI_PROFILE_SCOPE(__func__)
+#define EPI_PROFILE_FRAME() ::epi::Profiler::get().markFrame()
+#define EPI_PROFILE_THREAD(name) ::epi::Profiler::get().setThreadName(name)
+#else
+#define EPI_PROFILE_SCOPE(name) ((void)0)
+#define EPI_PROFILE_FUNCTION() ((void)0)
+#define EPI_PROFILE_FRAME() ((void)0)
+#define EPI_PROFILE_THREAD(name) ((void)0)
+#endif
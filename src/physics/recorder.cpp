@@ -0,0 +1,576 @@
+#include "recorder.hpp"
+#include "collider.hpp"
+#include "restraint.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace epi {
+
+static uint32_t bodyFlags(const RigidManifold& man) {
+    return (man.rigidbody->isStatic ? SnapshotBody::Static : 0) | (man.rigidbody->lockRotation ? SnapshotBody::LockRotation : 0) |
+        (man.collider->isTrigger ? SnapshotBody::Trigger : 0) | (man.collider->isSleeping ? SnapshotBody::Sleeping : 0);
+}
+static bool isSameMaterial(const Material& a, const Material& b) {
+    return a.restitution == b.restitution && a.sfriction == b.sfriction && a.dfriction == b.dfriction && a.air_drag == b.air_drag;
+}
+
+bool Recorder::open(const std::string& filename) {
+    close();
+    _file.open(filename, std::ios::binary | std::ios::trunc);
+    if(!_file.is_open())
+        return false;
+    _isStarted = false;
+    _step = 0;
+    _next_body_id = 0;
+    _next_restraint_id = 0;
+    _next_anchor_id = 0;
+    _bodies.clear();
+    _restraints.clear();
+    _anchors.clear();
+    _body_ids.clear();
+    _transform_ids.clear();
+    _buffer.clear();
+    _buffer.resize(sizeof(RECORDING_MAGIC));
+    std::memcpy(_buffer.data(), RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+    m_write(RECORDING_VERSION);
+    m_write(SNAPSHOT_BYTE_ORDER);
+    return true;
+}
+void Recorder::close() {
+    if(!_file.is_open())
+        return;
+    _file.write(_buffer.data(), _buffer.size());
+    _buffer.clear();
+    _file.close();
+}
+void Recorder::m_writeTag(const Tag& tag) {
+    auto list = tag.getList();
+    m_write((uint16_t)list.size());
+    for(auto& t : list) {
+        m_write((uint16_t)t.size());
+        _buffer.insert(_buffer.end(), t.begin(), t.end());
+    }
+}
+Recorder::TrackedBody* Recorder::m_findBody(RigidbodyHandle handle) {
+    if(handle.slot >= _bodies.size())
+        return nullptr;
+    auto& t = _bodies[handle.slot];
+    if(!t.isAlive || t.generation != handle.generation)
+        return nullptr;
+    return &t;
+}
+Recorder::TrackedRestraint* Recorder::m_findRestraint(RestraintHandle handle) {
+    if(handle.slot >= _restraints.size())
+        return nullptr;
+    auto& t = _restraints[handle.slot];
+    if(!t.isAlive || t.generation != handle.generation)
+        return nullptr;
+    return &t;
+}
+void Recorder::m_recordParams(const PhysicsManager& manager, bool force) {
+    auto steps = (uint32_t)manager.steps;
+    auto bounce = (uint8_t)manager.bounciness_select;
+    auto friction = (uint8_t)manager.friction_select;
+    if(!force && _gravity == manager.gravity && _steps == steps && _bounciness_select == bounce && _friction_select == friction)
+        return;
+    _gravity = manager.gravity;
+    _steps = steps;
+    _bounciness_select = bounce;
+    _friction_select = friction;
+    m_write(eRecordType::Params);
+    m_write(_gravity);
+    m_write(_steps);
+    m_write(_bounciness_select);
+    m_write(_friction_select);
+}
+void Recorder::m_track(TrackedBody& t, const RigidManifold& man) {
+    t.pos = man.transform->getPos();
+    t.rot = man.transform->getRot();
+    t.scale = man.transform->getScale();
+    t.velocity = man.rigidbody->velocity;
+    t.angular_velocity = man.rigidbody->angular_velocity;
+    t.force = man.rigidbody->force;
+    t.angular_force = man.rigidbody->angular_force;
+    t.mass = man.rigidbody->mass;
+    t.flags = bodyFlags(man);
+    t.material = *man.material;
+}
+void Recorder::m_recordAddBody(RigidbodyHandle handle, const RigidManifold& man) {
+    if(handle.slot >= _bodies.size())
+        _bodies.resize(handle.slot + 1);
+    auto& t = _bodies[handle.slot];
+    t.generation = handle.generation;
+    t.id = _next_body_id++;
+    t.isAlive = true;
+    m_track(t, man);
+    t.tag = man.collider->tag;
+    t.mask = man.collider->mask;
+    _body_ids[man.collider] = t.id;
+    _transform_ids[man.transform] = t.id;
+
+    _vertices.clear();
+    auto body = makeSnapshotBody(man, _vertices);
+    body.island = t.id;
+    m_write(eRecordType::AddBody);
+    m_write(t.id);
+    m_write(body);
+    for(auto v : _vertices)
+        m_write(v);
+    m_writeTag(t.tag);
+    m_writeTag(t.mask);
+}
+void Recorder::m_recordRemoveBody(RigidbodyHandle handle) {
+    auto t = m_findBody(handle);
+    if(!t)
+        return;
+    t->isAlive = false;
+    //components might be destroyed already, so the maps are searched by id instead of by pointer
+    std::erase_if(_body_ids, [&](const auto& p) { return p.second == t->id; });
+    std::erase_if(_transform_ids, [&](const auto& p) { return p.second == t->id; });
+    m_write(eRecordType::RemoveBody);
+    m_write(t->id);
+}
+void Recorder::m_recordAddRestraint(RestraintHandle handle, Restraint* res) {
+    SnapshotRestraint rec;
+    std::memset(&rec, 0, sizeof(rec));
+    uint32_t anchor_id = SNAPSHOT_NONE;
+    auto find_body = [&](const Collider* col) {
+        auto itr = _body_ids.find(col);
+        return itr == _body_ids.end() ? SNAPSHOT_NONE : itr->second;
+    };
+    if(auto rr = dynamic_cast<RestraintRigidRigid*>(res)) {
+        rec.type = SnapshotRestraint::eType::RigidRigid;
+        rec.body_a = find_body(rr->a.collider);
+        rec.body_b = find_body(rr->b.collider);
+        rec.damping_coef = rr->damping_coef;
+        rec.model_point_a = rr->model_point_a;
+        rec.model_point_b = rr->model_point_b;
+        rec.dist = rr->dist;
+        if(rec.body_b == SNAPSHOT_NONE)
+            return;
+    } else if(auto rp = dynamic_cast<RestraintPointTrans*>(res)) {
+        rec.type = SnapshotRestraint::eType::PointTrans;
+        rec.body_a = find_body(rp->a.collider);
+        auto anchor_body = _transform_ids.find(rp->trans);
+        rec.body_b = anchor_body == _transform_ids.end() ? SNAPSHOT_NONE : anchor_body->second;
+        rec.damping_coef = rp->damping_coef;
+        rec.model_point_a = rp->model_point_a;
+        rec.model_point_b = rp->model_point_trans;
+        rec.dist = rp->dist;
+        rec.anchor_pos = rp->trans->getPos();
+        rec.anchor_scale = rp->trans->getScale();
+        rec.anchor_rot = rp->trans->getRot();
+        if(rec.body_b == SNAPSHOT_NONE) {
+            auto itr = std::find_if(_anchors.begin(), _anchors.end(), [&](const TrackedAnchor& a) { return a.transform == rp->trans; });
+            if(itr == _anchors.end()) {
+                _anchors.push_back({rp->trans, _next_anchor_id++, 0, rec.anchor_pos, rec.anchor_rot});
+                itr = _anchors.end() - 1;
+            }
+            itr->users++;
+            anchor_id = itr->id;
+        }
+    } else {
+        //other restraint types can not be recreated during replay
+        return;
+    }
+    if(rec.body_a == SNAPSHOT_NONE)
+        return;
+    if(handle.slot >= _restraints.size())
+        _restraints.resize(handle.slot + 1);
+    auto& t = _restraints[handle.slot];
+    t.generation = handle.generation;
+    t.id = _next_restraint_id++;
+    t.isAlive = true;
+    t.anchor = anchor_id;
+    m_write(eRecordType::AddRestraint);
+    m_write(t.id);
+    m_write(rec);
+    m_write(anchor_id);
+}
+void Recorder::m_recordRemoveRestraint(RestraintHandle handle) {
+    auto t = m_findRestraint(handle);
+    if(!t)
+        return;
+    t->isAlive = false;
+    if(t->anchor != SNAPSHOT_NONE) {
+        //anchor transform might be destroyed together with its last restraint
+        auto itr = std::find_if(_anchors.begin(), _anchors.end(), [&](const TrackedAnchor& a) { return a.id == t->anchor; });
+        if(itr != _anchors.end() && --itr->users == 0)
+            _anchors.erase(itr);
+    }
+    m_write(eRecordType::RemoveRestraint);
+    m_write(t->id);
+}
+void Recorder::m_recordChanges(const PhysicsManager& manager, const std::vector<bool>& removed_slots) {
+    auto& rigidbodies = manager._rigidbodies;
+    for(size_t i = 0; i < rigidbodies.size(); i++) {
+        auto handle = rigidbodies.handleAt(i);
+        if(handle.slot < removed_slots.size() && removed_slots[handle.slot])
+            continue;
+        auto t = m_findBody(handle);
+        if(!t)
+            continue;
+        auto& man = rigidbodies[i];
+        auto& rb = *man.rigidbody;
+        uint16_t fields = 0;
+        fields |= t->pos != man.transform->getPos() ? BodyPos : 0;
+        fields |= t->rot != man.transform->getRot() ? BodyRot : 0;
+        fields |= t->scale != man.transform->getScale() ? BodyScale : 0;
+        fields |= t->velocity != rb.velocity ? BodyVelocity : 0;
+        fields |= t->angular_velocity != rb.angular_velocity ? BodyAngularVelocity : 0;
+        fields |= t->force != rb.force ? BodyForce : 0;
+        fields |= t->angular_force != rb.angular_force ? BodyAngularForce : 0;
+        fields |= t->mass != rb.mass ? BodyMass : 0;
+        fields |= t->flags != bodyFlags(man) ? BodyFlags : 0;
+        fields |= !isSameMaterial(t->material, *man.material) ? BodyMaterial : 0;
+        if(fields != 0) {
+            m_track(*t, man);
+            m_write(eRecordType::BodyOverride);
+            m_write(t->id);
+            m_write(fields);
+            if(fields & BodyPos) m_write(t->pos);
+            if(fields & BodyRot) m_write(t->rot);
+            if(fields & BodyScale) m_write(t->scale);
+            if(fields & BodyVelocity) m_write(t->velocity);
+            if(fields & BodyAngularVelocity) m_write(t->angular_velocity);
+            if(fields & BodyForce) m_write(t->force);
+            if(fields & BodyAngularForce) m_write(t->angular_force);
+            if(fields & BodyMass) m_write(t->mass);
+            if(fields & BodyFlags) m_write(t->flags);
+            if(fields & BodyMaterial) m_write(t->material);
+        }
+        if(!t->tag.isSame(man.collider->tag) || !t->mask.isSame(man.collider->mask)) {
+            t->tag = man.collider->tag;
+            t->mask = man.collider->mask;
+            m_write(eRecordType::BodyTags);
+            m_write(t->id);
+            m_writeTag(t->tag);
+            m_writeTag(t->mask);
+        }
+    }
+}
+void Recorder::m_beforeUpdate(const PhysicsManager& manager, float delT) {
+    if(!_file.is_open())
+        return;
+    auto& pending = manager._pending;
+    //hash chain of the replaying manager is started from the same value
+    if(!_isStarted && manager.hash_state) {
+        m_write(eRecordType::StateHash);
+        m_write(manager.getStateHash());
+    }
+    m_write(eRecordType::Step);
+    m_write(_step);
+    m_write(delT);
+    m_recordParams(manager, !_isStarted);
+
+    //bodies added and removed before the same update are never simulated, so neither is recorded
+    std::vector<bool> removed_slots(_bodies.size(), false);
+    std::vector<RigidbodyHandle> removed_handles;
+    for(auto& r : pending.rigidbodies_removed) {
+        if(r.handle.slot < removed_slots.size())
+            removed_slots[r.handle.slot] = true;
+        removed_handles.push_back(r.handle);
+    }
+    //looked up for every body and restraint, so sorted copies are binary searched instead of scanning pending removals
+    auto by_slot = [](const auto& a, const auto& b) {
+        return a.slot != b.slot ? a.slot < b.slot : a.generation < b.generation;
+    };
+    auto sorted_removed = removed_handles;
+    std::sort(sorted_removed.begin(), sorted_removed.end(), by_slot);
+    auto sorted_restraints_removed = pending.restraints_removed;
+    std::sort(sorted_restraints_removed.begin(), sorted_restraints_removed.end(), by_slot);
+    auto is_removed = [&](RigidbodyHandle h) {
+        return std::binary_search(sorted_removed.begin(), sorted_removed.end(), h, by_slot);
+    };
+    auto is_restraint_removed = [&](RestraintHandle h) {
+        return std::binary_search(sorted_restraints_removed.begin(), sorted_restraints_removed.end(), h, by_slot);
+    };
+
+    if(!_isStarted) {
+        //world that existed before recording started is recorded as added in the first step
+        _isStarted = true;
+        for(size_t i = 0; i < manager._rigidbodies.size(); i++) {
+            auto h = manager._rigidbodies.handleAt(i);
+            if(!is_removed(h))
+                m_recordAddBody(h, manager._rigidbodies[i]);
+        }
+        for(size_t i = 0; i < manager._restraints.size(); i++) {
+            auto h = manager._restraints.handleAt(i);
+            if(!is_restraint_removed(h))
+                m_recordAddRestraint(h, manager._restraints[i]);
+        }
+    } else {
+        m_recordChanges(manager, removed_slots);
+        for(auto h : pending.restraints_removed)
+            m_recordRemoveRestraint(h);
+        for(auto h : removed_handles)
+            m_recordRemoveBody(h);
+    }
+    for(auto& p : pending.rigidbodies_added)
+        if(!is_removed(p.first))
+            m_recordAddBody(p.first, p.second);
+    for(auto& p : pending.restraints_added)
+        if(!is_restraint_removed(p.first))
+            m_recordAddRestraint(p.first, p.second);
+    for(auto& a : _anchors) {
+        auto pos = a.transform->getPos();
+        auto rot = a.transform->getRot();
+        if(pos == a.pos && rot == a.rot)
+            continue;
+        a.pos = pos;
+        a.rot = rot;
+        m_write(eRecordType::AnchorMove);
+        m_write(a.id);
+        m_write(pos);
+        m_write(rot);
+    }
+}
+void Recorder::m_afterUpdate(const PhysicsManager& manager) {
+    if(!_file.is_open())
+        return;
+    auto& rigidbodies = manager._rigidbodies;
+    for(size_t i = 0; i < rigidbodies.size(); i++)
+        if(auto t = m_findBody(rigidbodies.handleAt(i)))
+            m_track(*t, rigidbodies[i]);
+    if(manager.hash_state) {
+        m_write(eRecordType::StateHash);
+        m_write(manager.getStateHash());
+    }
+    _step++;
+    _file.write(_buffer.data(), _buffer.size());
+    _file.flush();
+    _buffer.clear();
+}
+
+bool ReplayPlayer::m_fail(const char* msg) {
+    _error = msg;
+    return false;
+}
+bool ReplayPlayer::open(const std::string& filename, std::string* error) {
+    _data.clear();
+    _cursor = 0;
+    _step = 0;
+    _desync_step = SNAPSHOT_NONE;
+    _error.clear();
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    bool isValid = file.is_open();
+    if(isValid) {
+        _data.resize((size_t)file.tellg());
+        file.seekg(0);
+        isValid = (bool)file.read(_data.data(), _data.size());
+    }
+    char magic[4];
+    uint32_t version, byte_order;
+    if(!isValid)
+        m_fail("could not read recording");
+    else if(!m_read(magic) || !m_read(version) || !m_read(byte_order) || std::memcmp(magic, RECORDING_MAGIC, sizeof(magic)) != 0)
+        isValid = m_fail("not a recording");
+    else if(byte_order != SNAPSHOT_BYTE_ORDER || version == 0 || version > RECORDING_VERSION)
+        isValid = m_fail("recording of unsupported version or byte order");
+    if(!isValid && error)
+        *error = _error;
+    return isValid;
+}
+bool ReplayPlayer::m_readTag(Tag& tag) {
+    tag = Tag();
+    uint16_t count;
+    if(!m_read(count))
+        return false;
+    for(uint16_t i = 0; i < count; i++) {
+        uint16_t size;
+        if(!m_read(size) || _data.size() - _cursor < size)
+            return false;
+        tag.add(std::string(_data.data() + _cursor, size));
+        _cursor += size;
+    }
+    return true;
+}
+ReplayPlayer::Body* ReplayPlayer::m_body(uint32_t id) {
+    return id < _bodies.size() ? _bodies[id].get() : nullptr;
+}
+bool ReplayPlayer::m_applyRecord(eRecordType type, PhysicsManager& manager) {
+    uint32_t id;
+    switch(type) {
+        case eRecordType::Params: {
+            vec2f gravity;
+            uint32_t steps;
+            uint8_t bounce, friction;
+            if(!m_read(gravity) || !m_read(steps) || !m_read(bounce) || !m_read(friction))
+                return false;
+            manager.gravity = gravity;
+            manager.steps = steps;
+            manager.bounciness_select = (PhysicsManager::eSelectMode)std::min<uint8_t>(bounce, 2);
+            manager.friction_select = (PhysicsManager::eSelectMode)std::min<uint8_t>(friction, 2);
+        }break;
+        case eRecordType::AddBody: {
+            SnapshotBody rec;
+            if(!m_read(id) || !m_read(rec) || id != _bodies.size())
+                return false;
+            if((_data.size() - _cursor) / sizeof(vec2f) < rec.vertex_count)
+                return false;
+            std::vector<vec2f> vertices(rec.vertex_count);
+            if(rec.vertex_count != 0)
+                std::memcpy(vertices.data(), _data.data() + _cursor, sizeof(vec2f) * rec.vertex_count);
+            _cursor += sizeof(vec2f) * rec.vertex_count;
+            if(!isSnapshotShapeValid(rec, vertices.data()))
+                return false;
+            auto body = std::make_unique<Body>();
+            body->collider = std::unique_ptr<Collider>(createSnapshotCollider(rec, vertices.data()));
+            if(!m_readTag(body->collider->tag) || !m_readTag(body->collider->mask))
+                return false;
+            applySnapshotBody(rec, body->getManifold());
+            body->handle = manager.add(body->getManifold());
+            _bodies.push_back(std::move(body));
+        }break;
+        case eRecordType::RemoveBody: {
+            if(!m_read(id) || !m_body(id))
+                return false;
+            manager.remove(_bodies[id]->handle);
+            _bodies[id].reset();
+        }break;
+        case eRecordType::BodyOverride: {
+            uint16_t fields;
+            if(!m_read(id) || !m_read(fields) || !m_body(id))
+                return false;
+            //everything is read before the body is touched, so a truncated log leaves it as it was
+            SnapshotBody o;
+            Material material;
+            if(((fields & BodyPos) && !m_read(o.pos)) || ((fields & BodyRot) && !m_read(o.rot)) || ((fields & BodyScale) && !m_read(o.scale)) ||
+                ((fields & BodyVelocity) && !m_read(o.velocity)) || ((fields & BodyAngularVelocity) && !m_read(o.angular_velocity)) ||
+                ((fields & BodyForce) && !m_read(o.force)) || ((fields & BodyAngularForce) && !m_read(o.angular_force)) ||
+                ((fields & BodyMass) && !m_read(o.mass)) || ((fields & BodyFlags) && !m_read(o.flags)) ||
+                ((fields & BodyMaterial) && !m_read(material)))
+                return false;
+            auto& b = *_bodies[id];
+            if(fields & BodyPos) b.transform.setPos(o.pos);
+            if(fields & BodyRot) b.transform.setRot(o.rot);
+            if(fields & BodyScale) b.transform.setScale(o.scale);
+            if(fields & BodyVelocity) b.rigidbody.velocity = o.velocity;
+            if(fields & BodyAngularVelocity) b.rigidbody.angular_velocity = o.angular_velocity;
+            if(fields & BodyForce) b.rigidbody.force = o.force;
+            if(fields & BodyAngularForce) b.rigidbody.angular_force = o.angular_force;
+            if(fields & BodyMass) b.rigidbody.mass = o.mass;
+            if(fields & BodyFlags) {
+                b.rigidbody.isStatic = o.flags & SnapshotBody::Static;
+                b.rigidbody.lockRotation = o.flags & SnapshotBody::LockRotation;
+                b.collider->isTrigger = o.flags & SnapshotBody::Trigger;
+                b.collider->isSleeping = o.flags & SnapshotBody::Sleeping;
+            }
+            if(fields & BodyMaterial) b.material = material;
+            //baked static tree is not rebuilt on its own when a static body is moved, recorded caller had to mark it too
+            if((fields & (BodyPos | BodyRot | BodyScale)) && b.rigidbody.isStatic)
+                manager.markStaticChanged();
+        }break;
+        case eRecordType::BodyTags: {
+            if(!m_read(id) || !m_body(id))
+                return false;
+            return m_readTag(_bodies[id]->collider->tag) && m_readTag(_bodies[id]->collider->mask);
+        }break;
+        case eRecordType::AddRestraint: {
+            SnapshotRestraint rec;
+            uint32_t anchor_id;
+            if(!m_read(id) || !m_read(rec) || !m_read(anchor_id) || id != _restraints.size() || !m_body(rec.body_a))
+                return false;
+            std::unique_ptr<Restraint> res;
+            if(rec.type == SnapshotRestraint::eType::RigidRigid) {
+                if(!m_body(rec.body_b))
+                    return false;
+                auto rr = new RestraintRigidRigid(m_body(rec.body_a)->getManifold(), rec.model_point_a, m_body(rec.body_b)->getManifold(), rec.model_point_b);
+                rr->damping_coef = rec.damping_coef;
+                rr->dist = rec.dist;
+                res.reset(rr);
+            } else if(rec.type == SnapshotRestraint::eType::PointTrans) {
+                Transform* anchor = nullptr;
+                if(rec.body_b != SNAPSHOT_NONE) {
+                    if(!m_body(rec.body_b))
+                        return false;
+                    anchor = &m_body(rec.body_b)->transform;
+                } else if(anchor_id == _anchors.size()) {
+                    _anchors.push_back(std::make_unique<Transform>());
+                    anchor = _anchors.back().get();
+                    anchor->setPos(rec.anchor_pos);
+                    anchor->setRot(rec.anchor_rot);
+                    anchor->setScale(rec.anchor_scale);
+                } else if(anchor_id < _anchors.size()) {
+                    anchor = _anchors[anchor_id].get();
+                } else {
+                    return false;
+                }
+                auto rp = new RestraintPointTrans(m_body(rec.body_a)->getManifold(), rec.model_point_a, anchor, rec.model_point_b);
+                rp->damping_coef = rec.damping_coef;
+                rp->dist = rec.dist;
+                res.reset(rp);
+            } else {
+                return false;
+            }
+            auto handle = manager.add(res.get());
+            _restraints.push_back({std::move(res), handle});
+        }break;
+        case eRecordType::RemoveRestraint: {
+            if(!m_read(id) || id >= _restraints.size() || !_restraints[id].restraint)
+                return false;
+            manager.remove(_restraints[id].handle);
+            _restraints[id].restraint.reset();
+        }break;
+        case eRecordType::AnchorMove: {
+            vec2f pos;
+            float rot;
+            if(!m_read(id) || !m_read(pos) || !m_read(rot) || id >= _anchors.size())
+                return false;
+            _anchors[id]->setPos(pos);
+            _anchors[id]->setRot(rot);
+        }break;
+        default:
+            return false;
+    }
+    return true;
+}
+bool ReplayPlayer::m_checkHash(PhysicsManager& manager) {
+    uint64_t hash;
+    if(!m_read(hash))
+        return false;
+    if(_step == 0) {
+        manager._state_hash = hash;
+        manager.hash_state = true;
+    } else if(hash != manager.getStateHash() && _desync_step == SNAPSHOT_NONE) {
+        _desync_step = _step - 1;
+    }
+    return true;
+}
+bool ReplayPlayer::next(PhysicsManager& manager, float& delT) {
+    if(!_error.empty())
+        return false;
+    eRecordType type;
+    //hashes left by the previous update come before the next Step
+    while(_cursor < _data.size() && (eRecordType)_data[_cursor] == eRecordType::StateHash) {
+        m_read(type);
+        if(!m_checkHash(manager))
+            return m_fail("recording is corrupted");
+    }
+    if(_cursor == _data.size())
+        return false;
+    uint32_t step;
+    if(!m_read(type) || type != eRecordType::Step || !m_read(step) || !m_read(delT))
+        return m_fail("recording is corrupted");
+    while(_cursor < _data.size()) {
+        auto next_type = (eRecordType)_data[_cursor];
+        if(next_type == eRecordType::Step || next_type == eRecordType::StateHash)
+            break;
+        m_read(type);
+        if(!m_applyRecord(type, manager))
+            return m_fail("recording is corrupted");
+    }
+    _step = step + 1;
+    return true;
+}
+void ReplayPlayer::removeFrom(PhysicsManager& manager) const {
+    for(auto& r : _restraints)
+        if(r.restraint)
+            manager.remove(r.handle);
+    for(auto& b : _bodies)
+        if(b)
+            manager.remove(b->handle);
+}
+
+}
@@ -0,0 +1,230 @@
+#pragma once
+#include "physics_manager.hpp"
+#include "snapshot.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace epi {
+
+/*
+* binary command log layout: [magic "EPIR"][uint32_t version][uint32_t byte order] followed by records
+* every record is a uint8_t eRecordType and its payload, every update starts with Step record
+* mutations recorded after Step happened before that update and are applied in the order they were written
+*/
+static constexpr char RECORDING_MAGIC[4] = {'E', 'P', 'I', 'R'};
+static constexpr uint32_t RECORDING_VERSION = 2;
+
+enum class eRecordType : uint8_t {
+    //uint32_t step, float delT
+    Step,
+    //vec2f gravity, uint32_t steps, uint8_t bounciness_select, uint8_t friction_select
+    Params,
+    //uint32_t id, SnapshotBody, vec2f * vertex_count, tags, masks
+    AddBody,
+    //uint32_t id
+    RemoveBody,
+    //uint32_t id, uint16_t fields, then every field marked in eBodyField order
+    BodyOverride,
+    //uint32_t id, tags, masks
+    BodyTags,
+    //uint32_t id, SnapshotRestraint (body ids instead of indices), uint32_t anchor id
+    AddRestraint,
+    //uint32_t id
+    RemoveRestraint,
+    //uint32_t anchor id, vec2f pos, float rot
+    AnchorMove,
+    //uint64_t PhysicsManager::getStateHash after update, written when hash_state is enabled (since version 2)
+    //the one written before the first Step is the value the hash chain started from
+    StateHash,
+};
+//fields of BodyOverride record
+enum eBodyField : uint16_t {
+    BodyPos = 1 << 0,
+    BodyRot = 1 << 1,
+    BodyScale = 1 << 2,
+    BodyVelocity = 1 << 3,
+    BodyAngularVelocity = 1 << 4,
+    BodyForce = 1 << 5,
+    BodyAngularForce = 1 << 6,
+    BodyMass = 1 << 7,
+    BodyFlags = 1 << 8,
+    BodyMaterial = 1 << 9,
+};
+
+/*
+* \brief records every change made to world simulated by PhysicsManager into compact binary log
+* bound with PhysicsManager::setRecorder, after that changes are gathered at the beginning of every update:
+* added and removed bodies and restraints, world parameters, and every body property changed from outside of the manager
+* (forces, velocities, dragged positions, materials, tags) by comparing it with the state left by previous update
+* bodies and restraints are stored under ids assigned in order of recording, world existing when recording starts is recorded as added
+* log is flushed after every update, so it stays usable when the application crashes
+*/
+class Recorder {
+    //state of body left by last update, used to find changes made between updates
+    struct TrackedBody {
+        uint32_t generation;
+        uint32_t id;
+        bool isAlive = false;
+        vec2f pos;
+        float rot;
+        vec2f scale;
+        vec2f velocity;
+        float angular_velocity;
+        vec2f force;
+        float angular_force;
+        float mass;
+        uint32_t flags;
+        Material material;
+        Tag tag;
+        Tag mask;
+    };
+    struct TrackedRestraint {
+        uint32_t generation;
+        uint32_t id;
+        bool isAlive = false;
+        uint32_t anchor;
+    };
+    struct TrackedAnchor {
+        const Transform* transform;
+        uint32_t id;
+        size_t users;
+        vec2f pos;
+        float rot;
+    };
+
+    std::ofstream _file;
+    std::vector<char> _buffer;
+    bool _isStarted = false;
+    uint32_t _step = 0;
+    uint32_t _next_body_id = 0;
+    uint32_t _next_restraint_id = 0;
+    uint32_t _next_anchor_id = 0;
+
+    vec2f _gravity;
+    uint32_t _steps;
+    uint8_t _bounciness_select;
+    uint8_t _friction_select;
+    //indexed by handle slot
+    std::vector<TrackedBody> _bodies;
+    std::vector<TrackedRestraint> _restraints;
+    std::vector<TrackedAnchor> _anchors;
+    //used to find ids of bodies referenced by restraints
+    std::unordered_map<const Collider*, uint32_t> _body_ids;
+    std::unordered_map<const Transform*, uint32_t> _transform_ids;
+    std::vector<vec2f> _vertices;
+
+    template<class T>
+    void m_write(const T& value) {
+        auto bytes = reinterpret_cast<const char*>(&value);
+        _buffer.insert(_buffer.end(), bytes, bytes + sizeof(T));
+    }
+    void m_writeTag(const Tag& tag);
+    TrackedBody* m_findBody(RigidbodyHandle handle);
+    TrackedRestraint* m_findRestraint(RestraintHandle handle);
+
+    void m_recordParams(const PhysicsManager& manager, bool force);
+    void m_recordAddBody(RigidbodyHandle handle, const RigidManifold& man);
+    void m_recordRemoveBody(RigidbodyHandle handle);
+    void m_recordAddRestraint(RestraintHandle handle, Restraint* res);
+    void m_recordRemoveRestraint(RestraintHandle handle);
+    void m_recordChanges(const PhysicsManager& manager, const std::vector<bool>& removed_slots);
+    void m_track(TrackedBody& tracked, const RigidManifold& man);
+
+    void m_beforeUpdate(const PhysicsManager& manager, float delT);
+    void m_afterUpdate(const PhysicsManager& manager);
+public:
+    //opens log file, returns false if it could not be created
+    bool open(const std::string& filename);
+    bool isOpen() const {
+        return _file.is_open();
+    }
+    //flushes and closes log, manager should stop using this recorder before
+    void close();
+    //number of updates recorded so far
+    uint32_t getStepCount() const {
+        return _step;
+    }
+
+    Recorder() {}
+    ~Recorder() {
+        close();
+    }
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+    friend PhysicsManager;
+};
+
+/*
+* \brief plays back log written by Recorder on its own PhysicsManager
+* bodies and restraints are recreated from the log and owned by the player
+* replaying log that was recorded since the first body was added reproduces the recorded simulation exactly
+*/
+class ReplayPlayer {
+    struct Body {
+        Transform transform;
+        Rigidbody rigidbody;
+        Material material;
+        std::unique_ptr<Collider> collider;
+        RigidbodyHandle handle;
+        RigidManifold getManifold() {
+            return {&transform, collider.get(), &rigidbody, &material};
+        }
+    };
+    struct OwnedRestraint {
+        std::unique_ptr<Restraint> restraint;
+        RestraintHandle handle;
+    };
+    std::vector<char> _data;
+    size_t _cursor = 0;
+    uint32_t _step = 0;
+    uint32_t _desync_step = SNAPSHOT_NONE;
+    std::vector<std::unique_ptr<Body>> _bodies;
+    std::vector<OwnedRestraint> _restraints;
+    std::vector<std::unique_ptr<Transform>> _anchors;
+    std::string _error;
+
+    template<class T>
+    bool m_read(T& value) {
+        if(_data.size() - _cursor < sizeof(T))
+            return false;
+        std::memcpy(&value, _data.data() + _cursor, sizeof(T));
+        _cursor += sizeof(T);
+        return true;
+    }
+    bool m_readTag(Tag& tag);
+    bool m_fail(const char* msg);
+    Body* m_body(uint32_t id);
+    bool m_applyRecord(eRecordType type, PhysicsManager& manager);
+    bool m_checkHash(PhysicsManager& manager);
+public:
+    //reads whole log into memory, returns false and fills error if it is not a valid log
+    bool open(const std::string& filename, std::string* error = nullptr);
+    /*
+    * applies all mutations recorded before next update to manager and returns delta time of that update
+    * the caller is expected to call manager.update(delT) afterwards
+    * returns false when log ended or is corrupted (see getError)
+    */
+    bool next(PhysicsManager& manager, float& delT);
+    //index of next update
+    uint32_t getStep() const {
+        return _step;
+    }
+    const std::string& getError() const {
+        return _error;
+    }
+    //first update after which state hash differed from the recorded one, SNAPSHOT_NONE while replay matches
+    uint32_t getDesyncStep() const {
+        return _desync_step;
+    }
+    //removes every body still owned by the player and queues removal of its restraints, see PhysicsManager::remove for when the player can be destroyed
+    void removeFrom(PhysicsManager& manager) const;
+};
+
+}
@@ -9,9 +9,9 @@ void RestraintPointTrans::update(float delT) {
     auto& rb = *a.rigidbody;
     float inertia = a.collider->getInertia(rb.mass);
 
-    auto r = rotateVec(model_point_a, a.transform->getRot());
+    auto r = a.transform->getRotation().rotate(model_point_a);
     vec2f ap = a.transform->getPos() + r;
-    vec2f transp = trans->getPos() + rotateVec(model_point_trans, trans->getRot());
+    vec2f transp = trans->getPos() + trans->getRotation().rotate(model_point_trans);
 
     auto c = ap - transp;
 
@@ -41,10 +41,10 @@ void RestraintPointTrans::update(float delT) {
 void RestraintRigidRigid::update(float delT) {
     float inertiaA = a.collider->getInertia(a.rigidbody->mass);
     float inertiaB = b.collider->getInertia(b.rigidbody->mass);
-    auto ra = rotateVec(model_point_a, a.transform->getRot());
+    auto ra = a.transform->getRotation().rotate(model_point_a);
     vec2f ap = a.transform->getPos() + ra;
 
-    auto rb = rotateVec(model_point_b, b.transform->getRot());
+    auto rb = b.transform->getRotation().rotate(model_point_b);
     vec2f bp = b.transform->getPos() + rb;
 
     vec2f radperpA(-ra.y, ra.x);
@@ -33,6 +33,61 @@ float calculateInertia(vec2f pos, const std::vector<vec2f>& model, float mass) {
     }
     return abs(mmoi);
 }
+float calculateChainInertia(const Chain& chain, float mass) {
+    float total_len = 0.f;
+    for(size_t i = 0; i < chain.getSegmentCount(); i++) {
+        auto seg = chain.getSegment(i);
+        total_len += len(seg.b - seg.a);
+    }
+    if(total_len == 0.f)
+        return 0.f;
+    float mmoi = 0.f;
+    for(size_t i = 0; i < chain.getSegmentCount(); i++) {
+        auto seg = chain.getSegment(i);
+        float l = len(seg.b - seg.a);
+        vec2f mid = (seg.a + seg.b) / 2.f;
+        mmoi += mass * l / total_len * (l * l / 12.f + qlen(mid));
+    }
+    return mmoi;
+}
+float calculateCompoundInertia(const Compound& compound, float mass) {
+    //circles use the same formula as circle colliders, so that compound of one circle spins like one
+    static const float CIRCLE_FACTOR = 0.25f;
+    std::vector<float> areas;
+    float total_area = 0.f;
+    for(auto& p : compound.getPolygons())
+        areas.push_back(area(p.getModelVertecies()));
+    for(auto& c : compound.getCircles())
+        areas.push_back(fEPI_PI * c.radius * c.radius);
+    for(auto a : areas)
+        total_area += a;
+    if(total_area == 0.f)
+        return 0.f;
+    float mmoi = 0.f;
+    for(size_t i = 0; i < compound.getPolygonCount(); i++) {
+        auto& p = compound.getPolygons()[i];
+        float m = mass * areas[i] / total_area;
+        auto& model = p.getModelVertecies();
+        //inertia is calculated around origin of polygon's model and then moved through its centroid to origin of compound
+        vec2f centroid(0.f, 0.f);
+        float signed_area = 0.f;
+        for(size_t j = 0; j < model.size(); j++) {
+            float step = cross(model[j], model[(j + 1) % model.size()]) / 2.f;
+            signed_area += step;
+            centroid += (model[j] + model[(j + 1) % model.size()]) * step / 3.f;
+        }
+        if(signed_area != 0.f)
+            centroid /= signed_area;
+        vec2f offset = p.getPos() + p.getRotation().rotate(centroid);
+        mmoi += calculateInertia(vec2f(0, 0), model, m) - m * qlen(centroid) + m * qlen(offset);
+    }
+    for(size_t i = 0; i < compound.getCircleCount(); i++) {
+        auto& c = compound.getCircles()[i];
+        float m = mass * areas[compound.getPolygonCount() + i] / total_area;
+        mmoi += CIRCLE_FACTOR * m * c.radius * c.radius + m * qlen(c.pos);
+    }
+    return mmoi;
+}
 
 //vec2f rad = cp - getCollider().getPos();
 //void Rigidbody::addForce(vec2f f, vec2f rad) {
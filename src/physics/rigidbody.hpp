@@ -1,6 +1,5 @@
 #pragma once
 #include "col_utils.hpp"
-#include "imgui.h"
 #include "transform.hpp"
 #include "collider.hpp"
 #include "material.hpp"
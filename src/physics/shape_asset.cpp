@@ -0,0 +1,114 @@
+#include "shape_asset.hpp"
+#include "col_utils.hpp"
+#include "collider.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+namespace epi {
+
+//assets are looked up by exact bits of the model, equal shapes made the same way always match
+static uint64_t hashModel(const vec2f* model, size_t count) {
+    uint64_t hash = 14695981039346656037ull;
+    for(size_t i = 0; i < count; i++) {
+        vec2f p = model[i];
+        uint32_t bits[2];
+        std::memcpy(&bits[0], &p.x, sizeof(float));
+        std::memcpy(&bits[1], &p.y, sizeof(float));
+        for(auto b : bits) {
+            hash ^= b;
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
+static bool isSameModel(const std::vector<vec2f>& a, const vec2f* b, size_t count) {
+    return a.size() == count && std::memcmp(a.data(), b, count * sizeof(vec2f)) == 0;
+}
+static struct {
+    std::mutex mutex;
+    std::unordered_map<uint64_t, std::vector<std::weak_ptr<const ShapeAsset>>> assets;
+    //expired entries are only removed from buckets that are looked up, so the whole map is swept once in a while
+    size_t sweep_at = 64;
+} s_registry;
+
+static void sweepExpired() {
+    for(auto itr = s_registry.assets.begin(); itr != s_registry.assets.end();) {
+        auto& bucket = itr->second;
+        std::erase_if(bucket, [](const std::weak_ptr<const ShapeAsset>& a) { return a.expired(); });
+        if(bucket.empty())
+            itr = s_registry.assets.erase(itr);
+        else
+            itr++;
+    }
+}
+
+ShapeAsset::ShapeAsset(Key, std::vector<vec2f> model) : _model(std::move(model)) {
+    assert(_model.size() >= 3);
+    vec2f min = _model.front();
+    vec2f max = _model.front();
+    for(size_t i = 0; i < _model.size(); i++) {
+        vec2f a = _model[i];
+        vec2f b = _model[(i + 1) % _model.size()];
+        vec2f n = norm(vec2f(-(b.y - a.y), b.x - a.x));
+        //origin is inside of the centered convex model, so the edge faces away from it
+        if(dot(n, a) < 0.f)
+            n *= -1.f;
+        _normals.push_back(n);
+        min = vec2f(std::min(min.x, a.x), std::min(min.y, a.y));
+        max = vec2f(std::max(max.x, a.x), std::max(max.y, a.y));
+        _radius = std::max(_radius, len(a));
+    }
+    _aabb = AABB::CreateMinMax(min, max);
+    _area = area(_model);
+    _unit_inertia = calculateInertia(vec2f(0, 0), _model, 1.f);
+}
+void ShapeAsset::placeNormals(Rotation rot, vec2f scale, std::vector<vec2f>& result) const {
+    result.resize(_normals.size());
+    rotateN(_normals.data(), _normals.size(), rot, result.data());
+    if(scale.x == scale.y) {
+        if(scale.x < 0.f)
+            for(auto& n : result)
+                n *= -1.f;
+        return;
+    }
+    //normals are scaled by the inverse of scale, which keeps them perpendicular to scaled edges
+    for(auto& n : result)
+        n = norm(vec2f(n.x / scale.x, n.y / scale.y));
+}
+std::shared_ptr<const ShapeAsset> ShapeAsset::Get(const std::vector<vec2f>& model) {
+    return Get(model.data(), model.size());
+}
+std::shared_ptr<const ShapeAsset> ShapeAsset::Get(const vec2f* model, size_t count) {
+    uint64_t hash = hashModel(model, count);
+    std::lock_guard<std::mutex> lock(s_registry.mutex);
+    auto& bucket = s_registry.assets[hash];
+    std::shared_ptr<const ShapeAsset> result;
+    std::erase_if(bucket, [&](const std::weak_ptr<const ShapeAsset>& a) {
+        auto asset = a.lock();
+        if(asset && !result && isSameModel(asset->getModel(), model, count))
+            result = asset;
+        return asset == nullptr;
+    });
+    if(result)
+        return result;
+    result = std::make_shared<const ShapeAsset>(Key{}, std::vector<vec2f>(model, model + count));
+    bucket.push_back(result);
+    if(s_registry.assets.size() >= s_registry.sweep_at) {
+        sweepExpired();
+        s_registry.sweep_at = std::max<size_t>(64, s_registry.assets.size() * 2);
+    }
+    return result;
+}
+size_t ShapeAsset::getRegisteredCount() {
+    std::lock_guard<std::mutex> lock(s_registry.mutex);
+    size_t result = 0;
+    for(auto& [hash, bucket] : s_registry.assets)
+        for(auto& a : bucket)
+            result += !a.expired();
+    return result;
+}
+
+}
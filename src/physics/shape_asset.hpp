@@ -0,0 +1,63 @@
+#pragma once
+#include "types.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace epi {
+
+/*
+* \brief immutable polygon shape shared by every collider that uses the same model
+* everything that depends only on the model is calculated once, when the asset is created
+* assets are only created by Get, which returns the already registered one if identical model was seen before,
+* so that e.g. every hexagon made by Polygon::CreateRegular with the same size shares one record
+* registry does not keep assets alive, they are freed with the last collider referencing them
+*/
+class ShapeAsset {
+    std::vector<vec2f> _model;
+    std::vector<vec2f> _normals;
+    AABB _aabb;
+    float _radius = 0.f;
+    float _area = 0.f;
+    float _unit_inertia = 0.f;
+
+    struct Key {};
+public:
+    //vertices in model space, in the same order as in polygons placed with this asset
+    const std::vector<vec2f>& getModel() const {
+        return _model;
+    }
+    //outward unit normal of edge from vertex i to vertex i + 1
+    const std::vector<vec2f>& getNormals() const {
+        return _normals;
+    }
+    //bounds of model before rotation and scale are applied
+    const AABB& getAABB() const {
+        return _aabb;
+    }
+    //distance of the furthest vertex from origin of model
+    float getBoundingRadius() const {
+        return _radius;
+    }
+    float getArea() const {
+        return _area;
+    }
+    //moment of inertia around origin of model for mass of 1, scales linearly with mass
+    float getUnitInertia() const {
+        return _unit_inertia;
+    }
+    //normals rotated and scaled the same way Polygon places its vertices, result is resized to fit
+    void placeNormals(Rotation rot, vec2f scale, std::vector<vec2f>& result) const;
+
+    //model is used as it is, so it should already be centered and sorted like Polygon does it
+    ShapeAsset(Key, std::vector<vec2f> model);
+    //returns shared asset for model, creating and registering it if there is none yet
+    static std::shared_ptr<const ShapeAsset> Get(const std::vector<vec2f>& model);
+    //same as above for count vertices of model, they are only copied when a new asset has to be created
+    static std::shared_ptr<const ShapeAsset> Get(const vec2f* model, size_t count);
+    //number of assets that are still referenced by something
+    static size_t getRegisteredCount();
+};
+
+}
@@ -0,0 +1,233 @@
+#include "shape_cast.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace epi {
+
+//result of shapes overlapping before they moved at all
+static CastResult startingInside(vec2f start, vec2f dir) {
+    return {true, 0.f, start, qlen(dir) > 0.f ? -norm(dir) : vec2f(0, 0)};
+}
+void calcEdgeNormals(const vec2f* vertices, size_t count, std::vector<vec2f>& result) {
+    result.resize(count);
+    float signed_area = 0.f;
+    for(size_t i = 0; i < count; i++)
+        signed_area += cross(vertices[i], vertices[(i + 1) % count]);
+    for(size_t i = 0; i < count; i++) {
+        vec2f e = vertices[(i + 1) % count] - vertices[i];
+        if(qlen(e) == 0.f) {
+            result[i] = vec2f(0, 0);
+            continue;
+        }
+        //segments have no area and get opposite normals on both of their edges
+        result[i] = norm(signed_area >= 0.f ? vec2f(e.y, -e.x) : vec2f(-e.y, e.x));
+    }
+}
+void calcEdgeOffsets(const vec2f* vertices, const vec2f* normals, size_t count, std::vector<float>& result) {
+    result.resize(count);
+    for(size_t i = 0; i < count; i++)
+        result[i] = dot(normals[i], vertices[i]);
+}
+CastResult castRayCircle(vec2f origin, vec2f dir, vec2f center, float radius) {
+    vec2f m = origin - center;
+    float c = qlen(m) - radius * radius;
+    if(c <= 0.f)
+        return startingInside(origin, dir);
+    float a = qlen(dir);
+    float b = dot(m, dir);
+    //moving away from the circle or not moving at all
+    if(a == 0.f || b >= 0.f)
+        return {false};
+    float disc = b * b - a * c;
+    if(disc < 0.f)
+        return {false};
+    float t = (-b - std::sqrt(disc)) / a;
+    if(t > 1.f)
+        return {false};
+    vec2f p = origin + dir * t;
+    return {true, t, p, (p - center) / radius};
+}
+//clips ray against edge lines, the ones it enters through raise t_enter and the ones it leaves through lower t_exit
+CastResult castRayPlanes(vec2f origin, vec2f dir, const vec2f* normals, const float* offsets, size_t count) {
+    float t_enter = 0.f;
+    float t_exit = 1.f;
+    size_t enter_edge = count;
+    auto clip = [&](size_t i, float denom, float num) {
+        if(denom == 0.f)
+            return num >= 0.f;
+        float t = num / denom;
+        if(denom < 0.f) {
+            if(t > t_enter) {
+                t_enter = t;
+                enter_edge = i;
+            }
+        }else if(t < t_exit) {
+            t_exit = t;
+        }
+        return t_enter <= t_exit;
+    };
+    size_t i = 0;
+    for(; i + 4 <= count; i += 4) {
+        float denoms[4];
+        float dots[4];
+        dot4(normals + i, dir, denoms);
+        dot4(normals + i, origin, dots);
+        for(size_t k = 0; k < 4; k++)
+            if(!clip(i + k, denoms[k], offsets[i + k] - dots[k]))
+                return {false};
+    }
+    for(; i < count; i++)
+        if(!clip(i, dot(normals[i], dir), offsets[i] - dot(normals[i], origin)))
+            return {false};
+    if(enter_edge == count)
+        return startingInside(origin, dir);
+    return {true, t_enter, origin + dir * t_enter, normals[enter_edge]};
+}
+CastResult castRayPolygon(vec2f origin, vec2f dir, const std::vector<vec2f>& vertices) {
+    static thread_local std::vector<vec2f> normals;
+    static thread_local std::vector<float> offsets;
+    calcEdgeNormals(vertices.data(), vertices.size(), normals);
+    calcEdgeOffsets(vertices.data(), normals.data(), vertices.size(), offsets);
+    return castRayPlanes(origin, dir, normals.data(), offsets.data(), vertices.size());
+}
+CastResult castRaySegment(vec2f origin, vec2f dir, vec2f a, vec2f b) {
+    vec2f e = b - a;
+    float denom = cross(dir, e);
+    if(denom == 0.f)
+        return {false};
+    float t = cross(a - origin, e) / denom;
+    float s = cross(a - origin, dir) / denom;
+    if(t < 0.f || t > 1.f || s < 0.f || s > 1.f)
+        return {false};
+    vec2f n = norm(vec2f(-e.y, e.x));
+    if(dot(n, dir) > 0.f)
+        n *= -1.f;
+    return {true, t, origin + dir * t, n};
+}
+//rounded polygon is the polygon together with capsules around its edges, so the first hit is on an edge moved out by radius or on a circle around a vertex
+CastResult castRayRounded(vec2f origin, vec2f dir, const vec2f* vertices, const vec2f* normals, size_t count, float radius) {
+    bool isInside = count >= 3;
+    for(size_t i = 0; i < count; i++) {
+        vec2f a = vertices[i];
+        vec2f e = vertices[(i + 1) % count] - a;
+        float d = dot(normals[i], origin - a);
+        isInside = isInside && d <= 0.f;
+        float along = qlen(e) == 0.f ? 0.f : std::clamp(dot(origin - a, e) / qlen(e), 0.f, 1.f);
+        if(qlen(origin - (a + e * along)) <= radius * radius)
+            return startingInside(origin, dir);
+    }
+    if(isInside)
+        return startingInside(origin, dir);
+    CastResult result = {false, 1.f};
+    for(size_t i = 0; i < count; i++) {
+        vec2f n = normals[i];
+        float denom = dot(n, dir);
+        if(denom >= 0.f)
+            continue;
+        vec2f a = vertices[i];
+        vec2f e = vertices[(i + 1) % count] - a;
+        float t = (dot(n, a) + radius - dot(n, origin)) / denom;
+        if(t < 0.f || t > result.time || qlen(e) == 0.f)
+            continue;
+        vec2f p = origin + dir * t;
+        float along = dot(p - n * radius - a, e) / qlen(e);
+        if(along < 0.f || along > 1.f)
+            continue;
+        result = {true, t, p, n};
+    }
+    for(size_t i = 0; i < count; i++) {
+        auto hit = castRayCircle(origin, dir, vertices[i], radius);
+        if(hit.detected && (!result.detected || hit.time < result.time))
+            result = hit;
+    }
+    return result;
+}
+
+CastResult castCircle(const Circle& moving, vec2f translation, const Circle& target) {
+    auto result = castRayCircle(moving.pos, translation, target.pos, moving.radius + target.radius);
+    if(result.detected && result.time > 0.f)
+        result.point = target.pos + result.normal * target.radius;
+    return result;
+}
+CastResult castCircle(const Circle& moving, vec2f translation, const std::vector<vec2f>& target) {
+    static thread_local std::vector<vec2f> normals;
+    calcEdgeNormals(target.data(), target.size(), normals);
+    auto result = castRayRounded(moving.pos, translation, target.data(), normals.data(), target.size(), moving.radius);
+    if(result.detected && result.time > 0.f)
+        result.point -= result.normal * moving.radius;
+    return result;
+}
+static vec2f average(const std::vector<vec2f>& points) {
+    vec2f sum(0, 0);
+    for(auto p : points)
+        sum += p;
+    return sum / (float)points.size();
+}
+//point of polygon furthest along dir
+static vec2f support(const std::vector<vec2f>& points, vec2f dir) {
+    vec2f best = points.front();
+    for(auto p : points)
+        if(dot(p, dir) > dot(best, dir))
+            best = p;
+    return best;
+}
+CastResult castPolygon(const std::vector<vec2f>& moving, vec2f translation, const Circle& target) {
+    //translations at which polygon touches circle are the polygon mirrored around circle's center and grown by its radius
+    static thread_local std::vector<vec2f> mirrored;
+    static thread_local std::vector<vec2f> normals;
+    mirrored.resize(moving.size());
+    for(size_t i = 0; i < moving.size(); i++)
+        mirrored[i] = target.pos - moving[i];
+    calcEdgeNormals(mirrored.data(), mirrored.size(), normals);
+    auto result = castRayRounded(vec2f(0, 0), translation, mirrored.data(), normals.data(), mirrored.size(), target.radius);
+    if(!result.detected)
+        return result;
+    result.point = result.time > 0.f ? target.pos + result.normal * target.radius : average(moving);
+    return result;
+}
+//convex hull by monotone chain, points are sorted in place
+static void convexHull(std::vector<vec2f>& points, std::vector<vec2f>& result) {
+    std::sort(points.begin(), points.end(), [](vec2f a, vec2f b) {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+    result.clear();
+    if(points.size() < 3) {
+        result = points;
+        return;
+    }
+    auto add = [&](vec2f p, size_t lower_size) {
+        while(result.size() >= lower_size + 2 && cross(result[result.size() - 1] - result[result.size() - 2], p - result[result.size() - 2]) <= 0.f)
+            result.pop_back();
+        result.push_back(p);
+    };
+    for(auto p : points)
+        add(p, 0);
+    size_t lower_size = result.size() - 1;
+    for(size_t i = points.size() - 1; i-- > 0;)
+        add(points[i], lower_size);
+    result.pop_back();
+}
+CastResult castPolygon(const std::vector<vec2f>& moving, vec2f translation, const std::vector<vec2f>& target) {
+    static thread_local std::vector<vec2f> differences;
+    static thread_local std::vector<vec2f> hull;
+    static thread_local std::vector<vec2f> normals;
+    static thread_local std::vector<float> offsets;
+    differences.clear();
+    for(auto t : target)
+        for(auto m : moving)
+            differences.push_back(t - m);
+    convexHull(differences, hull);
+    if(hull.size() < 3)
+        return {false};
+    calcEdgeNormals(hull.data(), hull.size(), normals);
+    calcEdgeOffsets(hull.data(), normals.data(), hull.size(), offsets);
+    auto result = castRayPlanes(vec2f(0, 0), translation, normals.data(), offsets.data(), hull.size());
+    if(!result.detected)
+        return result;
+    //normal of the difference faces the moving polygon, so its point closest to the target lies against the normal
+    result.point = result.time > 0.f ? support(moving, -result.normal) + translation * result.time : average(moving);
+    return result;
+}
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "types.hpp"
+
+#include <cstddef>
+#include <vector>
+
+namespace epi {
+
+/*
+* first contact of a ray or of a moving shape with a target shape
+* time is fraction of ray's dir or of shape's translation travelled before touching, from 0 to 1
+* point lies on the surface of the target and normal is the target's surface normal, pointing against the motion
+* shapes that already overlap at the start are hit at time 0, with point at the start of the ray or center of the moving shape
+* and normal opposite to the motion
+*/
+struct CastResult {
+    bool detected;
+    float time;
+    vec2f point;
+    vec2f normal;
+};
+
+//outward unit normals of edges of convex polygon given in any winding, normal i belongs to edge from vertex i to vertex i + 1
+void calcEdgeNormals(const vec2f* vertices, size_t count, std::vector<vec2f>& result);
+//offsets of edge lines, point p is inside of convex polygon when dot(normals[i], p) <= offsets[i] for every edge i
+void calcEdgeOffsets(const vec2f* vertices, const vec2f* normals, size_t count, std::vector<float>& result);
+
+//ray from origin to origin + dir against circle
+CastResult castRayCircle(vec2f origin, vec2f dir, vec2f center, float radius);
+//ray against convex polygon given by its edge lines, edges are tested 4 at a time with batch math
+CastResult castRayPlanes(vec2f origin, vec2f dir, const vec2f* normals, const float* offsets, size_t count);
+//ray against convex polygon, edge lines are calculated on every call, so prefer castRayPlanes when testing many rays
+CastResult castRayPolygon(vec2f origin, vec2f dir, const std::vector<vec2f>& vertices);
+//ray against segment from a to b, both sides of which are solid
+CastResult castRaySegment(vec2f origin, vec2f dir, vec2f a, vec2f b);
+/*
+* ray against convex polygon grown by radius in every direction, which is what a circle sweeping over the polygon touches
+* 2 vertices make a segment grown into a capsule
+*/
+CastResult castRayRounded(vec2f origin, vec2f dir, const vec2f* vertices, const vec2f* normals, size_t count, float radius);
+
+//circle moved by translation against other circle
+CastResult castCircle(const Circle& moving, vec2f translation, const Circle& target);
+//circle moved by translation against convex polygon, or segment when given 2 vertices
+CastResult castCircle(const Circle& moving, vec2f translation, const std::vector<vec2f>& target);
+//convex polygon moved by translation against circle
+CastResult castPolygon(const std::vector<vec2f>& moving, vec2f translation, const Circle& target);
+/*
+* convex polygon moved by translation against other convex polygon, or segment when given 2 vertices
+* ray is cast against Minkowski difference of both shapes, which is the set of translations at which they overlap
+*/
+CastResult castPolygon(const std::vector<vec2f>& moving, vec2f translation, const std::vector<vec2f>& target);
+
+}
@@ -0,0 +1,525 @@
+#include "snapshot.hpp"
+#include "collider.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <type_traits>
+#include <unordered_map>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define EPI_SNAPSHOT_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#define EPI_SNAPSHOT_MMAP 0
+#endif
+
+namespace epi {
+
+static_assert(std::is_trivially_copyable_v<SnapshotHeader> && std::is_standard_layout_v<SnapshotHeader>);
+static_assert(std::is_trivially_copyable_v<SnapshotBody> && std::is_standard_layout_v<SnapshotBody>);
+static_assert(std::is_trivially_copyable_v<SnapshotRestraint> && std::is_standard_layout_v<SnapshotRestraint>);
+static_assert(alignof(SnapshotHeader) <= 8 && alignof(SnapshotBody) <= 8 && alignof(SnapshotRestraint) <= 8);
+//colliders are placed in plain byte array, which is only aligned for fundamental types
+static_assert(alignof(Collider) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+
+static uint64_t alignTo8(uint64_t offset) {
+    return (offset + 7) & ~uint64_t(7);
+}
+
+//read only view of the whole file, mapped where possible and read into memory otherwise
+class MappedFile {
+    const void* _data = nullptr;
+    size_t _size = 0;
+#if EPI_SNAPSHOT_MMAP
+    void* _mapping = nullptr;
+#else
+    std::vector<char> _buffer;
+#endif
+public:
+    bool open(const std::string& filename) {
+#if EPI_SNAPSHOT_MMAP
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if(fd < 0)
+            return false;
+        struct stat st;
+        if(fstat(fd, &st) != 0 || st.st_size <= 0) {
+            ::close(fd);
+            return false;
+        }
+        void* mapping = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(mapping == MAP_FAILED)
+            return false;
+        _mapping = mapping;
+        _data = mapping;
+        _size = (size_t)st.st_size;
+        return true;
+#else
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        if(!file.is_open())
+            return false;
+        _buffer.resize((size_t)file.tellg());
+        file.seekg(0);
+        if(!file.read(_buffer.data(), _buffer.size()))
+            return false;
+        _data = _buffer.data();
+        _size = _buffer.size();
+        return true;
+#endif
+    }
+    const void* data() const {
+        return _data;
+    }
+    size_t size() const {
+        return _size;
+    }
+    MappedFile() {}
+    ~MappedFile() {
+#if EPI_SNAPSHOT_MMAP
+        if(_mapping)
+            munmap(_mapping, _size);
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+};
+
+//collects tags into deduplicated string table
+class TagWriter {
+    std::unordered_map<std::string, uint32_t> _offsets;
+public:
+    std::vector<uint32_t> refs;
+    std::string strings;
+    void write(const Tag& tag, uint32_t& first, uint32_t& count) {
+        auto list = tag.getList();
+        first = (uint32_t)refs.size();
+        count = (uint32_t)list.size();
+        for(auto& t : list) {
+            auto itr = _offsets.find(t);
+            if(itr == _offsets.end()) {
+                itr = _offsets.insert({t, (uint32_t)strings.size()}).first;
+                strings.append(t);
+                strings.push_back('\0');
+            }
+            refs.push_back(itr->second);
+        }
+    }
+};
+
+SnapshotBody makeSnapshotBody(const RigidManifold& man, std::vector<vec2f>& vertices) {
+    auto& col = *man.collider;
+    auto& rb = *man.rigidbody;
+    SnapshotBody body;
+    std::memset(&body, 0, sizeof(body));
+    body.pos = man.transform->getPos();
+    body.scale = man.transform->getScale();
+    body.rot = man.transform->getRot();
+    body.mass = rb.mass;
+    body.velocity = rb.velocity;
+    body.force = rb.force;
+    body.angular_velocity = rb.angular_velocity;
+    body.angular_force = rb.angular_force;
+    body.restitution = man.material->restitution;
+    body.sfriction = man.material->sfriction;
+    body.dfriction = man.material->dfriction;
+    body.air_drag = man.material->air_drag;
+    body.shape = (uint32_t)col.type;
+    body.flags = (rb.isStatic ? SnapshotBody::Static : 0) | (rb.lockRotation ? SnapshotBody::LockRotation : 0) |
+        (col.isTrigger ? SnapshotBody::Trigger : 0) | (col.isSleeping ? SnapshotBody::Sleeping : 0);
+    body.time_immobile = col.time_immobile;
+    switch(col.type) {
+        case eCollisionShape::Circle:
+            body.radius = col.getCircleModel().radius;
+        break;
+        case eCollisionShape::Polygon: {
+            auto& model = col.getPolygonAsset().getModel();
+            body.vertex_first = (uint32_t)vertices.size();
+            body.vertex_count = (uint32_t)model.size();
+            vertices.insert(vertices.end(), model.begin(), model.end());
+        }break;
+        case eCollisionShape::Ray:
+            body.ray_dir = col.getRayModel().dir;
+        break;
+        case eCollisionShape::Chain: {
+            auto& points = col.getChainModel().getPoints();
+            body.vertex_first = (uint32_t)vertices.size();
+            body.vertex_count = (uint32_t)points.size();
+            vertices.insert(vertices.end(), points.begin(), points.end());
+            if(col.getChainModel().isLoop())
+                body.flags |= SnapshotBody::Loop;
+        }break;
+        case eCollisionShape::Compound: {
+            auto& compound = col.getCompoundModel();
+            body.vertex_first = (uint32_t)vertices.size();
+            for(auto& p : compound.getPolygons()) {
+                auto& model = p.getModelVertecies();
+                vertices.push_back(vec2f((float)model.size(), p.getRot()));
+                vertices.push_back(p.getPos());
+                vertices.insert(vertices.end(), model.begin(), model.end());
+            }
+            for(auto& c : compound.getCircles()) {
+                vertices.push_back(vec2f(0.f, c.radius));
+                vertices.push_back(c.pos);
+            }
+            body.vertex_count = (uint32_t)vertices.size() - body.vertex_first;
+        }break;
+    }
+    return body;
+}
+//walks children of compound stored in vertices, returns false if they run past count, children are added when polygons is given
+static bool readCompound(const vec2f* vertices, uint32_t count, std::vector<Polygon>* polygons, std::vector<Circle>* circles) {
+    uint32_t cursor = 0;
+    size_t children = 0;
+    while(cursor < count) {
+        if(count - cursor < 2)
+            return false;
+        vec2f head = vertices[cursor];
+        vec2f pos = vertices[cursor + 1];
+        cursor += 2;
+        children++;
+        if(head.x == 0.f) {
+            if(circles)
+                circles->push_back(Circle(pos, head.y));
+            continue;
+        }
+        if(!(head.x >= 3.f) || head.x > (float)(count - cursor))
+            return false;
+        uint32_t vertex_count = (uint32_t)head.x;
+        if(polygons)
+            polygons->push_back(Polygon::CreateFromModel(pos, head.y, std::vector<vec2f>(vertices + cursor, vertices + cursor + vertex_count)));
+        cursor += vertex_count;
+    }
+    return children != 0;
+}
+bool isSnapshotShapeValid(const SnapshotBody& body, const vec2f* vertices) {
+    switch((eCollisionShape)body.shape) {
+        case eCollisionShape::Circle:
+        case eCollisionShape::Ray:
+            return true;
+        case eCollisionShape::Polygon:
+            return body.vertex_count >= 3;
+        case eCollisionShape::Chain:
+            return body.vertex_count >= 2;
+        case eCollisionShape::Compound:
+            return readCompound(vertices, body.vertex_count, nullptr, nullptr);
+    }
+    return false;
+}
+Collider* createSnapshotCollider(const SnapshotBody& body, const vec2f* vertices, void* where) {
+    auto create = [&](auto shape) {
+        return where ? new (where) Collider(shape) : new Collider(shape);
+    };
+    switch((eCollisionShape)body.shape) {
+        case eCollisionShape::Circle:
+            return create(Circle(body.pos, body.radius));
+        case eCollisionShape::Polygon:
+            return create(ShapeAsset::Get(vertices, body.vertex_count));
+        case eCollisionShape::Ray:
+            return create(Ray::CreatePositionDirection(body.pos - body.ray_dir / 2.f, body.ray_dir));
+        case eCollisionShape::Chain:
+            return create(Chain(std::vector<vec2f>(vertices, vertices + body.vertex_count), body.flags & SnapshotBody::Loop));
+        case eCollisionShape::Compound: {
+            std::vector<Polygon> polygons;
+            std::vector<Circle> circles;
+            readCompound(vertices, body.vertex_count, &polygons, &circles);
+            return create(Compound(std::move(polygons), std::move(circles)));
+        }
+    }
+    return nullptr;
+}
+void applySnapshotBody(const SnapshotBody& body, const RigidManifold& man) {
+    auto& col = *man.collider;
+    col.isTrigger = body.flags & SnapshotBody::Trigger;
+    col.isSleeping = body.flags & SnapshotBody::Sleeping;
+    col.time_immobile = body.time_immobile;
+
+    auto& trans = *man.transform;
+    trans.setPos(body.pos);
+    trans.setRot(body.rot);
+    trans.setScale(body.scale);
+
+    auto& rb = *man.rigidbody;
+    rb.isStatic = body.flags & SnapshotBody::Static;
+    rb.lockRotation = body.flags & SnapshotBody::LockRotation;
+    rb.mass = body.mass;
+    rb.velocity = body.velocity;
+    rb.force = body.force;
+    rb.angular_velocity = body.angular_velocity;
+    rb.angular_force = body.angular_force;
+
+    auto& mat = *man.material;
+    mat.restitution = body.restitution;
+    mat.sfriction = body.sfriction;
+    mat.dfriction = body.dfriction;
+    mat.air_drag = body.air_drag;
+}
+
+void saveSnapshot(const PhysicsManager& manager, std::vector<char>& data) {
+    auto& rigidbodies = manager.getRigidbodies();
+    std::unordered_map<const Collider*, uint32_t> body_index;
+    std::unordered_map<const Transform*, uint32_t> transform_index;
+    for(size_t i = 0; i < rigidbodies.size(); i++) {
+        body_index[rigidbodies[i].collider] = (uint32_t)i;
+        transform_index[rigidbodies[i].transform] = (uint32_t)i;
+    }
+
+    std::vector<SnapshotBody> bodies(rigidbodies.size());
+    std::vector<vec2f> vertices;
+    TagWriter tags;
+    for(size_t i = 0; i < rigidbodies.size(); i++) {
+        auto& man = rigidbodies[i];
+        auto& col = *man.collider;
+        SnapshotBody body = makeSnapshotBody(man, vertices);
+        auto island = body_index.find(col.parent_collider);
+        body.island = island == body_index.end() ? (uint32_t)i : island->second;
+        tags.write(col.tag, body.tag_first, body.tag_count);
+        tags.write(col.mask, body.mask_first, body.mask_count);
+        bodies[i] = body;
+    }
+
+    std::vector<SnapshotRestraint> restraints;
+    for(auto res : manager.getRestraints()) {
+        SnapshotRestraint rec;
+        std::memset(&rec, 0, sizeof(rec));
+        if(auto rr = dynamic_cast<const RestraintRigidRigid*>(res)) {
+            auto a = body_index.find(rr->a.collider);
+            auto b = body_index.find(rr->b.collider);
+            if(a == body_index.end() || b == body_index.end())
+                continue;
+            rec.type = SnapshotRestraint::eType::RigidRigid;
+            rec.body_a = a->second;
+            rec.body_b = b->second;
+            rec.damping_coef = rr->damping_coef;
+            rec.model_point_a = rr->model_point_a;
+            rec.model_point_b = rr->model_point_b;
+            rec.dist = rr->dist;
+        } else if(auto rp = dynamic_cast<const RestraintPointTrans*>(res)) {
+            auto a = body_index.find(rp->a.collider);
+            if(a == body_index.end())
+                continue;
+            auto anchor = transform_index.find(rp->trans);
+            rec.type = SnapshotRestraint::eType::PointTrans;
+            rec.body_a = a->second;
+            rec.body_b = anchor == transform_index.end() ? SNAPSHOT_NONE : anchor->second;
+            rec.damping_coef = rp->damping_coef;
+            rec.model_point_a = rp->model_point_a;
+            rec.model_point_b = rp->model_point_trans;
+            rec.dist = rp->dist;
+            rec.anchor_pos = rp->trans->getPos();
+            rec.anchor_scale = rp->trans->getScale();
+            rec.anchor_rot = rp->trans->getRot();
+        } else {
+            continue;
+        }
+        restraints.push_back(rec);
+    }
+
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.body_count = (uint32_t)bodies.size();
+    header.restraint_count = (uint32_t)restraints.size();
+    header.vertex_count = (uint32_t)vertices.size();
+    header.tag_count = (uint32_t)tags.refs.size();
+    header.string_bytes = (uint32_t)tags.strings.size();
+    header.bodies_offset = alignTo8(sizeof(SnapshotHeader));
+    header.restraints_offset = alignTo8(header.bodies_offset + sizeof(SnapshotBody) * bodies.size());
+    header.vertices_offset = alignTo8(header.restraints_offset + sizeof(SnapshotRestraint) * restraints.size());
+    header.tags_offset = alignTo8(header.vertices_offset + sizeof(vec2f) * vertices.size());
+    header.strings_offset = alignTo8(header.tags_offset + sizeof(uint32_t) * tags.refs.size());
+    header.file_size = header.strings_offset + tags.strings.size();
+    header.gravity = manager.gravity;
+    header.steps = (uint32_t)manager.steps;
+    header.bounciness_select = (uint32_t)manager.bounciness_select;
+    header.friction_select = (uint32_t)manager.friction_select;
+
+    //gaps between sections stay zeroed
+    data.assign(header.file_size, 0);
+    auto write_at = [&](uint64_t offset, const void* src, size_t size) {
+        if(size != 0)
+            std::memcpy(data.data() + offset, src, size);
+    };
+    write_at(0, &header, sizeof(header));
+    write_at(header.bodies_offset, bodies.data(), sizeof(SnapshotBody) * bodies.size());
+    write_at(header.restraints_offset, restraints.data(), sizeof(SnapshotRestraint) * restraints.size());
+    write_at(header.vertices_offset, vertices.data(), sizeof(vec2f) * vertices.size());
+    write_at(header.tags_offset, tags.refs.data(), sizeof(uint32_t) * tags.refs.size());
+    write_at(header.strings_offset, tags.strings.data(), tags.strings.size());
+}
+bool saveSnapshot(const PhysicsManager& manager, const std::string& filename) {
+    std::vector<char> data;
+    saveSnapshot(manager, data);
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if(!file.is_open())
+        return false;
+    file.write(data.data(), data.size());
+    return file.good();
+}
+
+static bool fail(std::string* error, const char* msg) {
+    if(error)
+        *error = msg;
+    return false;
+}
+static bool isSectionValid(const SnapshotHeader& h, uint64_t offset, uint64_t count, uint64_t elem_size) {
+    return offset % 8 == 0 && offset <= h.file_size && count <= (h.file_size - offset) / elem_size;
+}
+static bool validateSnapshot(const void* data, size_t size, std::string* error) {
+    if(reinterpret_cast<uintptr_t>(data) % 8 != 0)
+        return fail(error, "snapshot data is not aligned to 8 bytes");
+    if(size < sizeof(SnapshotHeader))
+        return fail(error, "snapshot is truncated");
+    auto& h = *reinterpret_cast<const SnapshotHeader*>(data);
+    if(std::memcmp(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic)) != 0)
+        return fail(error, "not a snapshot file");
+    if(h.byte_order != SNAPSHOT_BYTE_ORDER)
+        return fail(error, "snapshot was written with different byte order");
+    if(h.version != SNAPSHOT_VERSION)
+        return fail(error, "unsupported snapshot version");
+    if(h.file_size > size)
+        return fail(error, "snapshot is truncated");
+    if(!isSectionValid(h, h.bodies_offset, h.body_count, sizeof(SnapshotBody)) ||
+        !isSectionValid(h, h.restraints_offset, h.restraint_count, sizeof(SnapshotRestraint)) ||
+        !isSectionValid(h, h.vertices_offset, h.vertex_count, sizeof(vec2f)) ||
+        !isSectionValid(h, h.tags_offset, h.tag_count, sizeof(uint32_t)) ||
+        !isSectionValid(h, h.strings_offset, h.string_bytes, 1))
+        return fail(error, "snapshot section out of bounds");
+    if(h.string_bytes != 0 && static_cast<const char*>(data)[h.strings_offset + h.string_bytes - 1] != '\0')
+        return fail(error, "snapshot string table is not terminated");
+
+    auto bodies = reinterpret_cast<const SnapshotBody*>(static_cast<const char*>(data) + h.bodies_offset);
+    auto vertices = reinterpret_cast<const vec2f*>(static_cast<const char*>(data) + h.vertices_offset);
+    auto tag_refs = reinterpret_cast<const uint32_t*>(static_cast<const char*>(data) + h.tags_offset);
+    for(size_t i = 0; i < h.body_count; i++) {
+        auto& b = bodies[i];
+        if(b.island >= h.body_count)
+            return fail(error, "snapshot body is corrupted");
+        if(b.vertex_count != 0 && (b.vertex_first > h.vertex_count || b.vertex_count > h.vertex_count - b.vertex_first))
+            return fail(error, "snapshot vertices are corrupted");
+        if(!isSnapshotShapeValid(b, vertices + b.vertex_first))
+            return fail(error, "snapshot shape is corrupted");
+        if(b.tag_first > h.tag_count || b.tag_count > h.tag_count - b.tag_first ||
+            b.mask_first > h.tag_count || b.mask_count > h.tag_count - b.mask_first)
+            return fail(error, "snapshot tags are corrupted");
+    }
+    for(size_t i = 0; i < h.tag_count; i++)
+        if(tag_refs[i] >= h.string_bytes)
+            return fail(error, "snapshot tags are corrupted");
+    auto restraints = reinterpret_cast<const SnapshotRestraint*>(static_cast<const char*>(data) + h.restraints_offset);
+    for(size_t i = 0; i < h.restraint_count; i++) {
+        auto& r = restraints[i];
+        bool b_valid = r.type == SnapshotRestraint::eType::PointTrans ? (r.body_b == SNAPSHOT_NONE || r.body_b < h.body_count) :
+            (r.type == SnapshotRestraint::eType::RigidRigid && r.body_b < h.body_count);
+        if(r.body_a >= h.body_count || !b_valid)
+            return fail(error, "snapshot restraint is corrupted");
+    }
+    return true;
+}
+
+std::unique_ptr<SnapshotWorld> loadSnapshot(const void* data, size_t size, PhysicsManager& manager, std::string* error) {
+    if(!validateSnapshot(data, size, error))
+        return nullptr;
+    auto base = static_cast<const char*>(data);
+    auto& h = *reinterpret_cast<const SnapshotHeader*>(base);
+    auto bodies = reinterpret_cast<const SnapshotBody*>(base + h.bodies_offset);
+    auto restraints = reinterpret_cast<const SnapshotRestraint*>(base + h.restraints_offset);
+    auto vertices = reinterpret_cast<const vec2f*>(base + h.vertices_offset);
+    auto tag_refs = reinterpret_cast<const uint32_t*>(base + h.tags_offset);
+    auto strings = base + h.strings_offset;
+
+    manager.gravity = h.gravity;
+    manager.steps = std::max<uint32_t>(1, h.steps);
+    manager.bounciness_select = (PhysicsManager::eSelectMode)std::min<uint32_t>(h.bounciness_select, 2);
+    manager.friction_select = (PhysicsManager::eSelectMode)std::min<uint32_t>(h.friction_select, 2);
+
+    std::unique_ptr<SnapshotWorld> world(new SnapshotWorld());
+    size_t n = h.body_count;
+    world->_transforms = std::unique_ptr<Transform[]>(new Transform[n]);
+    world->_rigidbodies = std::unique_ptr<Rigidbody[]>(new Rigidbody[n]);
+    world->_materials = std::unique_ptr<Material[]>(new Material[n]);
+    world->_collider_storage = std::unique_ptr<std::byte[]>(new std::byte[sizeof(Collider) * n]);
+    world->_handles.reserve(n);
+    for(size_t i = 0; i < n; i++) {
+        auto& b = bodies[i];
+        Collider* col = world->m_collider(i);
+        createSnapshotCollider(b, vertices + b.vertex_first, col);
+        //counted right away so that destructor never runs on unconstructed collider
+        world->_body_count = i + 1;
+        for(uint32_t t = 0; t < b.tag_count; t++)
+            col->tag.add(strings + tag_refs[b.tag_first + t]);
+        for(uint32_t t = 0; t < b.mask_count; t++)
+            col->mask.add(strings + tag_refs[b.mask_first + t]);
+        applySnapshotBody(b, world->getManifold(i));
+    }
+    for(size_t i = 0; i < n; i++)
+        world->m_collider(i)->parent_collider = world->m_collider(bodies[i].island);
+    for(size_t i = 0; i < n; i++)
+        world->_handles.push_back(manager.add(world->getManifold(i)));
+
+    size_t free_anchors = 0;
+    size_t rigid_count = 0;
+    for(size_t i = 0; i < h.restraint_count; i++) {
+        if(restraints[i].type == SnapshotRestraint::eType::RigidRigid)
+            rigid_count++;
+        else if(restraints[i].body_b == SNAPSHOT_NONE)
+            free_anchors++;
+    }
+    //reserved up front so that pointers given to manager stay valid
+    world->_rigid_restraints.reserve(rigid_count);
+    world->_point_restraints.reserve(h.restraint_count - rigid_count);
+    world->_anchors = std::unique_ptr<Transform[]>(new Transform[free_anchors]);
+    world->_restraint_handles.reserve(h.restraint_count);
+    size_t anchor_idx = 0;
+    for(size_t i = 0; i < h.restraint_count; i++) {
+        auto& r = restraints[i];
+        Restraint* res = nullptr;
+        if(r.type == SnapshotRestraint::eType::RigidRigid) {
+            auto& rr = world->_rigid_restraints.emplace_back(world->getManifold(r.body_a), r.model_point_a, world->getManifold(r.body_b), r.model_point_b);
+            rr.damping_coef = r.damping_coef;
+            rr.dist = r.dist;
+            res = &rr;
+        } else {
+            Transform* anchor = nullptr;
+            if(r.body_b == SNAPSHOT_NONE) {
+                anchor = &world->_anchors[anchor_idx++];
+                anchor->setPos(r.anchor_pos);
+                anchor->setRot(r.anchor_rot);
+                anchor->setScale(r.anchor_scale);
+            } else {
+                anchor = &world->_transforms[r.body_b];
+            }
+            auto& rp = world->_point_restraints.emplace_back(world->getManifold(r.body_a), r.model_point_a, anchor, r.model_point_b);
+            rp.damping_coef = r.damping_coef;
+            rp.dist = r.dist;
+            res = &rp;
+        }
+        world->_restraint_handles.push_back(manager.add(res));
+    }
+    return world;
+}
+std::unique_ptr<SnapshotWorld> loadSnapshot(const std::string& filename, PhysicsManager& manager, std::string* error) {
+    MappedFile file;
+    if(!file.open(filename)) {
+        fail(error, "could not open snapshot file");
+        return nullptr;
+    }
+    return loadSnapshot(file.data(), file.size(), manager, error);
+}
+void SnapshotWorld::removeFrom(PhysicsManager& manager) const {
+    for(auto h : _restraint_handles)
+        manager.remove(h);
+    for(auto h : _handles)
+        manager.remove(h);
+}
+SnapshotWorld::~SnapshotWorld() {
+    for(size_t i = 0; i < _body_count; i++)
+        m_collider(i)->~Collider();
+}
+
+}
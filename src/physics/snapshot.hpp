@@ -0,0 +1,185 @@
+#pragma once
+#include "physics_manager.hpp"
+#include "restraint.hpp"
+#include "rigidbody.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace epi {
+
+/*
+* binary world snapshot layout, every section is an array of plain records so that a mapped file can be used in place
+* [SnapshotHeader][SnapshotBody * body_count][SnapshotRestraint * restraint_count][vec2f * vertex_count]
+* [uint32_t * tag_count (offsets into strings)][char * string_bytes (null terminated strings)]
+* sections start at offsets aligned to 8 bytes, all values are stored in native byte order
+* vertices of a body are model vertices of polygon or points of chain, compound stores every child as
+* [(vertex count, rotation)][position][model vertex * vertex count] for polygons and [(0, radius)][position] for circles
+*/
+static constexpr char SNAPSHOT_MAGIC[4] = {'E', 'P', 'I', 'S'};
+static constexpr uint32_t SNAPSHOT_VERSION = 1;
+static constexpr uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+static constexpr uint32_t SNAPSHOT_NONE = UINT32_MAX;
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t body_count;
+    uint32_t restraint_count;
+    uint32_t vertex_count;
+    uint32_t tag_count;
+    uint32_t string_bytes;
+    uint64_t bodies_offset;
+    uint64_t restraints_offset;
+    uint64_t vertices_offset;
+    uint64_t tags_offset;
+    uint64_t strings_offset;
+    uint64_t file_size;
+
+    //world parameters
+    vec2f gravity;
+    uint32_t steps;
+    uint32_t bounciness_select;
+    uint32_t friction_select;
+    uint32_t padding;
+};
+struct SnapshotBody {
+    enum eFlags : uint32_t {
+        Static = 1 << 0,
+        LockRotation = 1 << 1,
+        Trigger = 1 << 2,
+        Sleeping = 1 << 3,
+        //chain whose last point connects back to the first
+        Loop = 1 << 4,
+    };
+    //transform
+    vec2f pos;
+    vec2f scale;
+    float rot;
+    //rigidbody
+    float mass;
+    vec2f velocity;
+    vec2f force;
+    float angular_velocity;
+    float angular_force;
+    //material
+    float restitution;
+    float sfriction;
+    float dfriction;
+    float air_drag;
+    //collider
+    uint32_t shape;
+    uint32_t flags;
+    float time_immobile;
+    //index of body that is the head of this body's island
+    uint32_t island;
+    float radius;
+    vec2f ray_dir;
+    uint32_t vertex_first;
+    uint32_t vertex_count;
+    uint32_t tag_first;
+    uint32_t tag_count;
+    uint32_t mask_first;
+    uint32_t mask_count;
+};
+struct SnapshotRestraint {
+    enum class eType : uint32_t {
+        RigidRigid,
+        PointTrans,
+    };
+    eType type;
+    uint32_t body_a;
+    //second body for RigidRigid, body whose transform is the anchor for PointTrans or SNAPSHOT_NONE if anchor is free
+    uint32_t body_b;
+    float damping_coef;
+    vec2f model_point_a;
+    vec2f model_point_b;
+    float dist;
+    //free anchor transform of PointTrans
+    float anchor_rot;
+    vec2f anchor_pos;
+    vec2f anchor_scale;
+};
+
+//fills body record of man, vertices of its shape are appended to vertices and island is left for the caller to set
+SnapshotBody makeSnapshotBody(const RigidManifold& man, std::vector<vec2f>& vertices);
+//returns false if shape of body is unknown or its body.vertex_count vertices do not describe it
+bool isSnapshotShapeValid(const SnapshotBody& body, const vec2f* vertices);
+/*
+* creates collider of shape described by body, vertices point at body.vertex_count vertices of its shape
+* collider is constructed in place when where is given, otherwise it is allocated with new
+*/
+Collider* createSnapshotCollider(const SnapshotBody& body, const vec2f* vertices, void* where = nullptr);
+//copies everything except shape, tags and island from body into man's components
+void applySnapshotBody(const SnapshotBody& body, const RigidManifold& man);
+
+/*
+* \brief owns components of bodies and restraints loaded from snapshot
+* every component type is kept in a single contiguous allocation, bodies keep the order they had in the snapshot
+* polygons look their model up in place, so only new shape assets, chains, compounds and tags allocate per body
+* has to outlive its bodies' membership in PhysicsManager, so remove them (or destroy the manager) first
+*/
+class SnapshotWorld {
+    size_t _body_count = 0;
+    std::unique_ptr<Transform[]> _transforms;
+    std::unique_ptr<Rigidbody[]> _rigidbodies;
+    std::unique_ptr<Material[]> _materials;
+    //Collider is neither copyable nor default constructible, so they are created in place
+    std::unique_ptr<std::byte[]> _collider_storage;
+    std::vector<RigidbodyHandle> _handles;
+
+    std::vector<RestraintRigidRigid> _rigid_restraints;
+    std::vector<RestraintPointTrans> _point_restraints;
+    std::unique_ptr<Transform[]> _anchors;
+    std::vector<RestraintHandle> _restraint_handles;
+
+    Collider* m_collider(size_t idx) {
+        return reinterpret_cast<Collider*>(_collider_storage.get()) + idx;
+    }
+    SnapshotWorld() {}
+public:
+    size_t size() const {
+        return _body_count;
+    }
+    RigidManifold getManifold(size_t idx) {
+        return {&_transforms[idx], m_collider(idx), &_rigidbodies[idx], &_materials[idx]};
+    }
+    RigidbodyHandle getHandle(size_t idx) const {
+        return _handles[idx];
+    }
+    const std::vector<RestraintHandle>& getRestraintHandles() const {
+        return _restraint_handles;
+    }
+    //removes every loaded body and queues removal of restraints, see PhysicsManager::remove for when the world can be destroyed
+    void removeFrom(PhysicsManager& manager) const;
+
+    ~SnapshotWorld();
+    SnapshotWorld(const SnapshotWorld&) = delete;
+    SnapshotWorld& operator=(const SnapshotWorld&) = delete;
+
+    friend std::unique_ptr<SnapshotWorld> loadSnapshot(const std::string& filename, PhysicsManager& manager, std::string* error);
+    friend std::unique_ptr<SnapshotWorld> loadSnapshot(const void* data, size_t size, PhysicsManager& manager, std::string* error);
+};
+
+/*
+* writes every rigidbody and restraint simulated by manager, together with gravity, steps and select modes
+* restraints of types other than RestraintRigidRigid and RestraintPointTrans are skipped
+* returns false if file could not be written
+*/
+bool saveSnapshot(const PhysicsManager& manager, const std::string& filename);
+//same as above but writes snapshot into data, which can be passed to loadSnapshot right away
+void saveSnapshot(const PhysicsManager& manager, std::vector<char>& data);
+/*
+* maps snapshot file into memory and adds all of its bodies and restraints to manager
+* world parameters of manager are overwritten, bodies are simulated starting from next update
+* returns nullptr and fills error (if given) when file is missing, truncated or of other version
+*/
+std::unique_ptr<SnapshotWorld> loadSnapshot(const std::string& filename, PhysicsManager& manager, std::string* error = nullptr);
+//same as above but reads snapshot already present in memory
+std::unique_ptr<SnapshotWorld> loadSnapshot(const void* data, size_t size, PhysicsManager& manager, std::string* error = nullptr);
+
+}
@@ -10,52 +10,247 @@
 #include <cmath>
 #include <numeric>
 #include <stdexcept>
+#include <type_traits>
 #include <vector>
 
 namespace epi {
 
-CollisionInfo detectOverlap(const Polygon& poly, const Ray& ray) {
+//contact at a single point, allocated from res
+static CollisionInfo createContact(vec2f cn, vec2f cp, float overlap, std::pmr::memory_resource* res) {
+    CollisionInfo result = {true, cn, std::pmr::vector<vec2f>(res), overlap};
+    result.cps.push_back(cp);
+    return result;
+}
+CollisionInfo detectOverlap(const Polygon& poly, const Ray& ray, std::pmr::memory_resource* res) {
     auto intersection = intersectRayPolygon(ray.pos, ray.dir, poly); 
     if(intersection.detected) {
-        return {true, intersection.contact_normal, {intersection.contact_point}, intersection.overlap};
+        return createContact(intersection.contact_normal, intersection.contact_point, intersection.overlap, res);
     }
     return {false};
 }
-CollisionInfo detectOverlap(const Circle& circle, const Ray& ray) {
+CollisionInfo detectOverlap(const Circle& circle, const Ray& ray, std::pmr::memory_resource* res) {
     auto closest = findClosestPointOnRay(ray.pos, ray.dir, circle.pos);
     auto l = len(closest - circle.pos);
     bool detected = (l < circle.radius);
     if(detected) {
-        return {true, norm(circle.pos-closest), {closest}, circle.radius - l};
+        return createContact(norm(circle.pos-closest), closest, circle.radius - l, res);
     }
     return {false};
 }
-CollisionInfo detectOverlap(const Circle& circle, const Polygon& poly) {
+CollisionInfo detectOverlap(const Circle& circle, const Polygon& poly, std::pmr::memory_resource* res) {
 
     auto intersection = intersectCirclePolygon(circle, poly);
     if(intersection.detected) {
-        return {true, intersection.contact_normal, {intersection.contact_point} , intersection.overlap};
+        return createContact(intersection.contact_normal, intersection.contact_point, intersection.overlap, res);
     }
     return {false};
 }
-CollisionInfo detectOverlap(const Polygon& p1, const Polygon& p2) {
+CollisionInfo detectOverlap(const Polygon& p1, const Polygon& p2, std::pmr::memory_resource* res) {
     auto intersection = intersectPolygonPolygon(p1, p2);
     if(intersection.detected) {
-        std::vector<vec2f> cps;
-        cps = findContactPoints(p1, p2);
+        auto cps = findContactPoints(p1, p2, res);
         if(cps.size() ==0)
             return {false};
-        return {true, intersection.contact_normal, cps , intersection.overlap};
+        return {true, intersection.contact_normal, std::move(cps), intersection.overlap};
     }
     return {false};
 }
-CollisionInfo detectOverlap(const Circle& c1, const Circle& c2) {
+CollisionInfo detectOverlap(const Circle& c1, const Circle& c2, std::pmr::memory_resource* res) {
     auto intersection = intersectCircleCircle(c1, c2);
     if(intersection.detected) {
-        return {true, intersection.contact_normal, {intersection.contact_point} , intersection.overlap};
+        return createContact(intersection.contact_normal, intersection.contact_point, intersection.overlap, res);
+    }
+    return {false};
+}
+//normal points from chain towards the other shape
+CollisionInfo detectOverlap(const Circle& circle, const Chain& chain, const Transform& trans, std::pmr::memory_resource* res) {
+    auto intersection = intersectCircleChain(circle, chain, trans);
+    if(intersection.detected) {
+        return createContact(intersection.contact_normal, intersection.contact_point, intersection.overlap, res);
+    }
+    return {false};
+}
+CollisionInfo detectOverlap(const Polygon& poly, const Chain& chain, const Transform& trans, std::pmr::memory_resource* res) {
+    auto intersection = intersectPolygonChain(poly, chain, trans, res);
+    if(intersection.detected && intersection.contact_points.size() != 0) {
+        return {true, intersection.contact_normal, std::move(intersection.contact_points), intersection.overlap};
+    }
+    return {false};
+}
+//polygon colliders are placed in scratch polygons kept between calls, so that narrowphase does not allocate
+//slot 0 is used for the first collider of a pair and slot 1 for the second one
+static const Polygon& placePolygon(Collider* col, Transform* trans, int slot) {
+    static thread_local Polygon scratch[2];
+    col->getPolygonShape(*trans, scratch[slot]);
+    return scratch[slot];
+}
+//edge normals come from shape assets, so only their rotation has to be calculated
+static CollisionInfo detectPolygons(Collider* col1, Transform* trans1, Collider* col2, Transform* trans2, std::pmr::memory_resource* res) {
+    static thread_local std::vector<vec2f> normals[2];
+    auto& p1 = placePolygon(col1, trans1, 0);
+    auto& p2 = placePolygon(col2, trans2, 1);
+    col1->getPolygonAsset().placeNormals(trans1->getRotation(), trans1->getScale(), normals[0]);
+    col2->getPolygonAsset().placeNormals(trans2->getRotation(), trans2->getScale(), normals[1]);
+    auto intersection = intersectPolygonPolygon(p1, normals[0], p2, normals[1]);
+    if(intersection.detected) {
+        auto cps = findContactPoints(p1, p2, res);
+        if(cps.size() ==0)
+            return {false};
+        return {true, intersection.contact_normal, std::move(cps), intersection.overlap};
     }
     return {false};
 }
+//overlaps of two shapes where normal always points towards the first one
+static CollisionInfo detectPair(const Polygon& a, const Polygon& b, std::pmr::memory_resource* res) {
+    return detectOverlap(a, b, res);
+}
+static CollisionInfo detectPair(const Polygon& a, const Circle& b, std::pmr::memory_resource* res) {
+    auto man = detectOverlap(b, a, res);
+    man.cn *= -1.f;
+    return man;
+}
+static CollisionInfo detectPair(const Circle& a, const Polygon& b, std::pmr::memory_resource* res) {
+    return detectOverlap(a, b, res);
+}
+static CollisionInfo detectPair(const Circle& a, const Circle& b, std::pmr::memory_resource* res) {
+    return detectOverlap(a, b, res);
+}
+//deepest of contacts found between children, merged with the ones pushing the same way,
+//so that a compound resting on several children is supported at all of them
+//found is cleared, its contact points come from res, which may be gone before the next call on this thread
+static CollisionInfo mergeContacts(std::vector<CollisionInfo>& found, std::pmr::memory_resource* res) {
+    static const float SAME_DIRECTION_COS = 0.9f;
+    const CollisionInfo* deepest = nullptr;
+    for(auto& f : found)
+        if(f.detected && (!deepest || f.overlap > deepest->overlap))
+            deepest = &f;
+    CollisionInfo result = {false, {}, std::pmr::vector<vec2f>(res), 0.f};
+    if(deepest) {
+        result.detected = true;
+        result.cn = deepest->cn;
+        result.overlap = deepest->overlap;
+        result.cps.assign(deepest->cps.begin(), deepest->cps.end());
+        for(auto& f : found)
+            if(&f != deepest && f.detected && dot(f.cn, deepest->cn) > SAME_DIRECTION_COS)
+                result.cps.insert(result.cps.end(), f.cps.begin(), f.cps.end());
+    }
+    found.clear();
+    return result;
+}
+template<class Shape>
+static CollisionInfo detectShapeCompound(const Shape& shape, const Compound& compound, const Transform& trans, std::pmr::memory_resource* res) {
+    static thread_local std::vector<uint32_t> hits;
+    static thread_local std::vector<CollisionInfo> found;
+    static thread_local Polygon placed;
+    hits.clear();
+    found.clear();
+    AABB area;
+    if constexpr(std::is_same_v<Shape, Circle>)
+        area = AABB::CreateFromCircle(shape);
+    else
+        area = AABB::CreateFromPolygon(shape);
+    compound.queryChildren(area, trans, hits);
+    for(auto h : hits) {
+        if(compound.isPolygon(h)) {
+            compound.getPolygon(h, trans, placed);
+            found.push_back(detectPair(shape, placed, res));
+        }else {
+            found.push_back(detectPair(shape, compound.getCircle(h - compound.getPolygonCount(), trans), res));
+        }
+    }
+    return mergeContacts(found, res);
+}
+//single shape against collider of any type, normal points towards the shape
+template<class Shape>
+static CollisionInfo detectShape(const Shape& shape, Transform* trans, Collider* col, std::pmr::memory_resource* res) {
+    switch(col->type) {
+        case eCollisionShape::Polygon:
+            return detectPair(shape, placePolygon(col, trans, 1), res);
+        case eCollisionShape::Circle:
+            return detectPair(shape, col->getCircleShape(*trans), res);
+        case eCollisionShape::Ray:
+            return detectOverlap(shape, col->getRayShape(*trans), res);
+        case eCollisionShape::Chain:
+            return detectOverlap(shape, col->getChainModel(), *trans, res);
+        case eCollisionShape::Compound:
+            return detectShapeCompound(shape, col->getCompoundModel(), *trans, res);
+    }
+    return {false};
+}
+//children of both compounds near the other one are placed in the world once and then tested pair by pair
+static CollisionInfo detectCompoundCompound(const Compound& compound1, Transform* trans1, Collider* col1, const Compound& compound2, Transform* trans2, Collider* col2,
+        std::pmr::memory_resource* res) {
+    struct Child {
+        AABB aabb;
+        uint32_t idx;
+        Polygon polygon;
+        Circle circle;
+    };
+    static thread_local std::vector<uint32_t> hits;
+    static thread_local std::vector<Child> children[2];
+    static thread_local std::vector<CollisionInfo> found;
+    found.clear();
+    //children vectors never shrink, so that their polygons keep memory between calls, returns number of children placed
+    auto place = [](const Compound& compound, Transform* trans, const AABB& area, std::vector<Child>& result) {
+        hits.clear();
+        compound.queryChildren(area, *trans, hits);
+        if(result.size() < hits.size())
+            result.resize(hits.size());
+        for(size_t i = 0; i < hits.size(); i++) {
+            auto& child = result[i];
+            child.idx = hits[i];
+            if(compound.isPolygon(child.idx)) {
+                compound.getPolygon(child.idx, *trans, child.polygon);
+                child.aabb = AABB::CreateFromPolygon(child.polygon);
+            }else {
+                child.circle = compound.getCircle(child.idx - compound.getPolygonCount(), *trans);
+                child.aabb = AABB::CreateFromCircle(child.circle);
+            }
+        }
+        return hits.size();
+    };
+    size_t count1 = place(compound1, trans1, col2->getAABB(*trans2), children[0]);
+    size_t count2 = place(compound2, trans2, col1->getAABB(*trans1), children[1]);
+    for(size_t i = 0; i < count1; i++) {
+        auto& a = children[0][i];
+        for(size_t j = 0; j < count2; j++) {
+            auto& b = children[1][j];
+            if(!isOverlappingAABBAABB(a.aabb, b.aabb))
+                continue;
+            bool isPolygonA = compound1.isPolygon(a.idx);
+            bool isPolygonB = compound2.isPolygon(b.idx);
+            if(isPolygonA && isPolygonB)
+                found.push_back(detectPair(a.polygon, b.polygon, res));
+            else if(isPolygonA)
+                found.push_back(detectPair(a.polygon, b.circle, res));
+            else if(isPolygonB)
+                found.push_back(detectPair(a.circle, b.polygon, res));
+            else
+                found.push_back(detectPair(a.circle, b.circle, res));
+        }
+    }
+    return mergeContacts(found, res);
+}
+//every child near the other collider is tested on its own, normal points towards the compound
+static CollisionInfo detectCompound(const Compound& compound, Transform* trans1, Collider* col1, Transform* trans2, Collider* col2, std::pmr::memory_resource* res) {
+    if(col2->type == eCollisionShape::Compound)
+        return detectCompoundCompound(compound, trans1, col1, col2->getCompoundModel(), trans2, col2, res);
+    static thread_local std::vector<uint32_t> hits;
+    static thread_local std::vector<CollisionInfo> found;
+    static thread_local Polygon placed;
+    hits.clear();
+    found.clear();
+    compound.queryChildren(col2->getAABB(*trans2), *trans1, hits);
+    for(auto h : hits) {
+        if(compound.isPolygon(h)) {
+            compound.getPolygon(h, *trans1, placed);
+            found.push_back(detectShape(placed, trans2, col2, res));
+        }else {
+            found.push_back(detectShape(compound.getCircle(h - compound.getPolygonCount(), *trans1), trans2, col2, res));
+        }
+    }
+    return mergeContacts(found, res);
+}
 void handleOverlap(RigidManifold& m1, RigidManifold& m2, const CollisionInfo& man) {
     if(!man.detected)
         return;
@@ -162,56 +357,124 @@ vec2f DefaultSolver::getFricImpulse(float p1inv_inertia, float mass1, vec2f rad1
     }
     return friction_impulse;
 }
-CollisionInfo DefaultSolver::detect(Transform* trans1, Collider* col1, Transform* trans2, Collider* col2) {
-    CollisionInfo man;
+CollisionInfo DefaultSolver::detect(Transform* trans1, Collider* col1, Transform* trans2, Collider* col2, std::pmr::memory_resource* res) {
+    CollisionInfo man = {false, {}, std::pmr::vector<vec2f>(res), 0.f};
     //ik its ugly but switch case will catch new variants if eCollisionShape will be getting more shapes
     switch(col1->type) {
         case eCollisionShape::Polygon:
             switch(col2->type) {
                 case eCollisionShape::Polygon:
-                    man = detectOverlap(col1->getPolygonShape(*trans1), col2->getPolygonShape(*trans2));
+                    man = detectPolygons(col1, trans1, col2, trans2, res);
                 break;
                 case eCollisionShape::Circle:
-                    man = detectOverlap(col2->getCircleShape(*trans2), col1->getPolygonShape(*trans1));
+                    man = detectOverlap(col2->getCircleShape(*trans2), placePolygon(col1, trans1, 0), res);
                     man.cn *= -1.f;
                 break;
                 case eCollisionShape::Ray:
-                    man = detectOverlap(col1->getPolygonShape(*trans1), col2->getRayShape(*trans2));
+                    man = detectOverlap(placePolygon(col1, trans1, 0), col2->getRayShape(*trans2), res);
+                break;
+                case eCollisionShape::Chain:
+                    man = detectOverlap(placePolygon(col1, trans1, 0), col2->getChainModel(), *trans2, res);
+                break;
+                case eCollisionShape::Compound:
+                    man = detectCompound(col2->getCompoundModel(), trans2, col2, trans1, col1, res);
+                    man.cn *= -1.f;
                 break;
             }
         break;
         case eCollisionShape::Circle:
             switch(col2->type) {
                 case eCollisionShape::Polygon:
-                    man = detectOverlap(col1->getCircleShape(*trans1), col2->getPolygonShape(*trans2));
+                    man = detectOverlap(col1->getCircleShape(*trans1), placePolygon(col2, trans2, 1), res);
                 break;
                 case eCollisionShape::Circle:
-                    man = detectOverlap(col1->getCircleShape(*trans1), col2->getCircleShape(*trans2));
+                    man = detectOverlap(col1->getCircleShape(*trans1), col2->getCircleShape(*trans2), res);
                 break;
                 case eCollisionShape::Ray:
-                    man = detectOverlap(col1->getCircleShape(*trans1), col2->getRayShape(*trans2));
+                    man = detectOverlap(col1->getCircleShape(*trans1), col2->getRayShape(*trans2), res);
+                break;
+                case eCollisionShape::Chain:
+                    man = detectOverlap(col1->getCircleShape(*trans1), col2->getChainModel(), *trans2, res);
+                break;
+                case eCollisionShape::Compound:
+                    man = detectCompound(col2->getCompoundModel(), trans2, col2, trans1, col1, res);
+                    man.cn *= -1.f;
                 break;
             }
         break;
         case eCollisionShape::Ray: {
             switch (col2->type) {
                 case eCollisionShape::Polygon:
-                    man = detectOverlap(col2->getPolygonShape(*trans2), col1->getRayShape(*trans1));
+                    man = detectOverlap(placePolygon(col2, trans2, 1), col1->getRayShape(*trans1), res);
                     man.cn *= -1.f;
                 break;
                 case eCollisionShape::Circle:
-                    man = detectOverlap(col2->getCircleShape(*trans2), col1->getRayShape(*trans1));
+                    man = detectOverlap(col2->getCircleShape(*trans2), col1->getRayShape(*trans1), res);
                     man.cn *= -1.f;
                 break;
                 case eCollisionShape::Ray:
                 std::cerr << "ray and ray should not be colliding";
                 break;
+                case eCollisionShape::Chain:
+                    man = {false};
+                break;
+                case eCollisionShape::Compound:
+                    man = detectCompound(col2->getCompoundModel(), trans2, col2, trans1, col1, res);
+                    man.cn *= -1.f;
+                break;
+            }
+        }break;
+        //chains are terrain, they only collide with polygons and circles
+        case eCollisionShape::Chain: {
+            switch (col2->type) {
+                case eCollisionShape::Polygon:
+                    man = detectOverlap(placePolygon(col2, trans2, 1), col1->getChainModel(), *trans1, res);
+                    man.cn *= -1.f;
+                break;
+                case eCollisionShape::Circle:
+                    man = detectOverlap(col2->getCircleShape(*trans2), col1->getChainModel(), *trans1, res);
+                    man.cn *= -1.f;
+                break;
+                case eCollisionShape::Compound:
+                    man = detectCompound(col2->getCompoundModel(), trans2, col2, trans1, col1, res);
+                    man.cn *= -1.f;
+                break;
+                case eCollisionShape::Ray:
+                case eCollisionShape::Chain:
+                    man = {false};
+                break;
             }
         }break;
+        case eCollisionShape::Compound:
+            man = detectCompound(col1->getCompoundModel(), trans1, col1, trans2, col2, res);
+        break;
     }
     return man;
 }
-void DefaultSolver::solve(CollisionInfo man, RigidManifold rb1, RigidManifold rb2, float restitution, float sfriction, float dfriction)  {
+bool DefaultSolver::overlaps(Transform* trans1, Collider* col1, Transform* trans2, Collider* col2, std::pmr::memory_resource* res) {
+    bool isPolygon1 = col1->type == eCollisionShape::Polygon;
+    bool isPolygon2 = col2->type == eCollisionShape::Polygon;
+    bool isCircle1 = col1->type == eCollisionShape::Circle;
+    bool isCircle2 = col2->type == eCollisionShape::Circle;
+    if(isPolygon1 && isPolygon2) {
+        static thread_local std::vector<vec2f> normals[2];
+        col1->getPolygonAsset().placeNormals(trans1->getRotation(), trans1->getScale(), normals[0]);
+        col2->getPolygonAsset().placeNormals(trans2->getRotation(), trans2->getScale(), normals[1]);
+        return intersectPolygonPolygon(placePolygon(col1, trans1, 0), normals[0], placePolygon(col2, trans2, 1), normals[1]).detected;
+    }
+    if(isCircle1 && isCircle2) {
+        auto c1 = col1->getCircleShape(*trans1);
+        auto c2 = col2->getCircleShape(*trans2);
+        float r = c1.radius + c2.radius;
+        return qlen(c1.pos - c2.pos) <= r * r;
+    }
+    if(isCircle1 && isPolygon2)
+        return intersectCirclePolygon(col1->getCircleShape(*trans1), placePolygon(col2, trans2, 1)).detected;
+    if(isPolygon1 && isCircle2)
+        return intersectCirclePolygon(col2->getCircleShape(*trans2), placePolygon(col1, trans1, 0)).detected;
+    return detect(trans1, col1, trans2, col2, res).detected;
+}
+void DefaultSolver::solve(const CollisionInfo& man, RigidManifold rb1, RigidManifold rb2, float restitution, float sfriction, float dfriction)  {
     if(!man.detected) {
         return;
     }
@@ -9,13 +9,21 @@
 #include <cmath>
 #include <cstddef>
 #include <iterator>
+#include <memory_resource>
 #include <vector>
 namespace epi {
 
 class SolverInterface {
 public:
-    virtual CollisionInfo detect(Transform* trans1, Collider* col1, Transform* trans2, Collider* col2) = 0;
-    virtual void solve(CollisionInfo info, RigidManifold rb1, RigidManifold rb2, float restitution, float sfriction, float dfriction) = 0;
+    //contact points of returned info are allocated from resource, which PhysicsManager resets every update
+    virtual CollisionInfo detect(Transform* trans1, Collider* col1, Transform* trans2, Collider* col2,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) = 0;
+    //only tells whether colliders overlap, used for triggers which need no normal nor contact points, by default calls detect
+    virtual bool overlaps(Transform* trans1, Collider* col1, Transform* trans2, Collider* col2,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+        return detect(trans1, col1, trans2, col2, resource).detected;
+    }
+    virtual void solve(const CollisionInfo& info, RigidManifold rb1, RigidManifold rb2, float restitution, float sfriction, float dfriction) = 0;
 };
 class DefaultSolver : public SolverInterface {
 private:
@@ -28,8 +36,12 @@ private:
            const RigidManifold& rb2,float bounce, float sfric, float dfric);
 public:
 
-    CollisionInfo detect(Transform* trans1, Collider* col1, Transform* trans2, Collider* col2) override;
-    void solve(CollisionInfo info, RigidManifold rb1, RigidManifold rb2, float restitution, float sfriction, float dfriction) override;
+    CollisionInfo detect(Transform* trans1, Collider* col1, Transform* trans2, Collider* col2,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) override;
+    //polygons and circles are tested without finding contact points, other shapes fall back to detect
+    bool overlaps(Transform* trans1, Collider* col1, Transform* trans2, Collider* col2,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()) override;
+    void solve(const CollisionInfo& info, RigidManifold rb1, RigidManifold rb2, float restitution, float sfriction, float dfriction) override;
 };
 
 }
@@ -0,0 +1,173 @@
+#include "static_bvh.hpp"
+#include "col_utils.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+
+namespace epi {
+
+//boxes kept in one leaf, testing a few boxes is cheaper than descending further
+static const uint32_t MAX_LEAF_SIZE = 4;
+//deep enough for any tree built by median splits of 32 bit indices
+static const size_t MAX_DEPTH = 64;
+
+void StaticBVH::clear() {
+    _boxes.clear();
+    _nodes.clear();
+    _items.clear();
+}
+void StaticBVH::m_build(uint32_t begin, uint32_t end) {
+    uint32_t node_idx = (uint32_t)_nodes.size();
+    _nodes.push_back({});
+    AABB box = _boxes[_items[begin]];
+    vec2f center_min = box.center();
+    vec2f center_max = box.center();
+    for(uint32_t i = begin; i < end; i++) {
+        auto& other = _boxes[_items[i]];
+        box = AABB::CreateMinMax(vec2f(std::min(box.min.x, other.min.x), std::min(box.min.y, other.min.y)),
+                                 vec2f(std::max(box.max.x, other.max.x), std::max(box.max.y, other.max.y)));
+        vec2f c = other.center();
+        center_min = vec2f(std::min(center_min.x, c.x), std::min(center_min.y, c.y));
+        center_max = vec2f(std::max(center_max.x, c.x), std::max(center_max.y, c.y));
+    }
+    _nodes[node_idx].box = box;
+    if(end - begin <= MAX_LEAF_SIZE) {
+        std::sort(_items.begin() + begin, _items.begin() + end);
+        _nodes[node_idx].first = begin;
+        _nodes[node_idx].count = end - begin;
+        return;
+    }
+    bool isSplitOnX = center_max.x - center_min.x >= center_max.y - center_min.y;
+    //strict total order, so that boxes landing in each half do not depend on nth_element implementation
+    auto less = [&](uint32_t a, uint32_t b) {
+        float ca = isSplitOnX ? _boxes[a].center().x : _boxes[a].center().y;
+        float cb = isSplitOnX ? _boxes[b].center().x : _boxes[b].center().y;
+        if(ca != cb)
+            return ca < cb;
+        return a < b;
+    };
+    uint32_t mid = begin + (end - begin) / 2;
+    std::nth_element(_items.begin() + begin, _items.begin() + mid, _items.begin() + end, less);
+    m_build(begin, mid);
+    _nodes[node_idx].first = (uint32_t)_nodes.size();
+    _nodes[node_idx].count = 0;
+    m_build(mid, end);
+}
+void StaticBVH::build() {
+    EPI_PROFILE_FUNCTION();
+    _nodes.clear();
+    _items.resize(_boxes.size());
+    for(uint32_t i = 0; i < _items.size(); i++)
+        _items[i] = i;
+    if(_boxes.size() == 0)
+        return;
+    _nodes.reserve(_boxes.size() / MAX_LEAF_SIZE * 2 + 1);
+    m_build(0, (uint32_t)_boxes.size());
+}
+void StaticBVH::query(const AABB& area, std::vector<uint32_t>& result) const {
+    if(_nodes.size() == 0)
+        return;
+    uint32_t stack[MAX_DEPTH];
+    size_t stack_size = 0;
+    stack[stack_size++] = 0;
+    while(stack_size != 0) {
+        auto& node = _nodes[stack[--stack_size]];
+        if(!isOverlappingAABBAABB(node.box, area))
+            continue;
+        if(node.count != 0) {
+            for(uint32_t i = node.first; i < node.first + node.count; i++) {
+                if(isOverlappingAABBAABB(_boxes[_items[i]], area))
+                    result.push_back(_items[i]);
+            }
+            continue;
+        }
+        //right child is pushed first, so that left subtree is visited first
+        uint32_t node_idx = (uint32_t)(&node - _nodes.data());
+        stack[stack_size++] = node.first;
+        stack[stack_size++] = node_idx + 1;
+    }
+}
+//ray with reciprocal of its direction, zero components are replaced with tiny ones so that slabs never produce NaN
+struct PacketRay {
+    vec2f origin;
+    vec2f inv_dir;
+};
+static PacketRay makePacketRay(const Ray& ray) {
+    static const float TINY = 1e-20f;
+    vec2f d(ray.dir.x == 0.f ? TINY : ray.dir.x, ray.dir.y == 0.f ? TINY : ray.dir.y);
+    return {ray.pos, vec2f(1.f / d.x, 1.f / d.y)};
+}
+//bit i is set when ray i of packet crosses box between its start and end
+static uint32_t hitMask(const PacketRay* packet, uint32_t active, const AABB& box) {
+#if EPI_SSE2
+    __m128 ox = _mm_setr_ps(packet[0].origin.x, packet[1].origin.x, packet[2].origin.x, packet[3].origin.x);
+    __m128 oy = _mm_setr_ps(packet[0].origin.y, packet[1].origin.y, packet[2].origin.y, packet[3].origin.y);
+    __m128 ix = _mm_setr_ps(packet[0].inv_dir.x, packet[1].inv_dir.x, packet[2].inv_dir.x, packet[3].inv_dir.x);
+    __m128 iy = _mm_setr_ps(packet[0].inv_dir.y, packet[1].inv_dir.y, packet[2].inv_dir.y, packet[3].inv_dir.y);
+    __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.min.x), ox), ix);
+    __m128 tx2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.max.x), ox), ix);
+    __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.min.y), oy), iy);
+    __m128 ty2 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(box.max.y), oy), iy);
+    __m128 t_near = _mm_max_ps(_mm_max_ps(_mm_min_ps(tx1, tx2), _mm_min_ps(ty1, ty2)), _mm_setzero_ps());
+    __m128 t_far = _mm_min_ps(_mm_min_ps(_mm_max_ps(tx1, tx2), _mm_max_ps(ty1, ty2)), _mm_set1_ps(1.f));
+    return (uint32_t)_mm_movemask_ps(_mm_cmple_ps(t_near, t_far)) & active;
+#else
+    uint32_t result = 0;
+    for(uint32_t i = 0; i < 4; i++) {
+        if(!(active & (1u << i)))
+            continue;
+        auto& r = packet[i];
+        float tx1 = (box.min.x - r.origin.x) * r.inv_dir.x;
+        float tx2 = (box.max.x - r.origin.x) * r.inv_dir.x;
+        float ty1 = (box.min.y - r.origin.y) * r.inv_dir.y;
+        float ty2 = (box.max.y - r.origin.y) * r.inv_dir.y;
+        float t_near = std::max(std::max(std::min(tx1, tx2), std::min(ty1, ty2)), 0.f);
+        float t_far = std::min(std::min(std::max(tx1, tx2), std::max(ty1, ty2)), 1.f);
+        if(t_near <= t_far)
+            result |= 1u << i;
+    }
+    return result;
+#endif
+}
+void StaticBVH::queryRays(const Ray* rays, size_t count, std::vector<std::pair<uint32_t, uint32_t>>& result) const {
+    if(_nodes.size() == 0)
+        return;
+    struct Entry {
+        uint32_t node;
+        //rays of packet that reached this node
+        uint32_t mask;
+    };
+    for(size_t first = 0; first < count; first += 4) {
+        PacketRay packet[4];
+        uint32_t active = 0;
+        for(uint32_t i = 0; i < 4; i++) {
+            //missing rays of the last packet repeat the first one and are masked out
+            packet[i] = makePacketRay(rays[first + i < count ? first + i : first]);
+            if(first + i < count)
+                active |= 1u << i;
+        }
+        Entry stack[MAX_DEPTH];
+        size_t stack_size = 0;
+        stack[stack_size++] = {0, active};
+        while(stack_size != 0) {
+            auto entry = stack[--stack_size];
+            auto& node = _nodes[entry.node];
+            uint32_t mask = hitMask(packet, entry.mask, node.box);
+            if(mask == 0)
+                continue;
+            if(node.count != 0) {
+                for(uint32_t i = node.first; i < node.first + node.count; i++) {
+                    uint32_t item_mask = hitMask(packet, mask, _boxes[_items[i]]);
+                    for(uint32_t r = 0; r < 4; r++)
+                        if(item_mask & (1u << r))
+                            result.push_back({(uint32_t)(first + r), _items[i]});
+                }
+                continue;
+            }
+            stack[stack_size++] = {node.first, mask};
+            stack[stack_size++] = {entry.node + 1, mask};
+        }
+    }
+}
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace epi {
+
+/*
+* \brief bounding volume hierarchy over boxes that do not move, built once and then queried many times
+* nodes are stored flat in depth first order, so that left child of a branch always directly follows it
+* build splits boxes by centers along the longest axis and breaks ties by index,
+* so that the tree and the order of query results never depend on the standard library
+*/
+class StaticBVH {
+    struct Node {
+        AABB box;
+        //for leaves first box in _items, for branches index of right child
+        uint32_t first;
+        //number of boxes in a leaf, 0 for branches
+        uint32_t count;
+    };
+    std::vector<AABB> _boxes;
+    std::vector<Node> _nodes;
+    std::vector<uint32_t> _items;
+
+    void m_build(uint32_t begin, uint32_t end);
+public:
+    //drops all boxes, keeping memory
+    void clear();
+    //adds box with index equal to number of boxes added before it, tree has to be rebuilt afterwards
+    void push(const AABB& box) {
+        _boxes.push_back(box);
+    }
+    //builds tree over all pushed boxes
+    void build();
+    //appends indices of all boxes overlapping area to result, every index is reported once
+    void query(const AABB& area, std::vector<uint32_t>& result) const;
+    /*
+    * appends pairs of ray index and box index for every box crossed by ray segment from pos to pos + dir
+    * consecutive rays are traversed together in packets of 4, so rays starting near each other and pointing similar ways
+    * should be next to each other, every node is then loaded once per packet
+    */
+    void queryRays(const Ray* rays, size_t count, std::vector<std::pair<uint32_t, uint32_t>>& result) const;
+
+    size_t size() const {
+        return _boxes.size();
+    }
+    const AABB& getBox(size_t idx) const {
+        return _boxes[idx];
+    }
+};
+
+}
@@ -0,0 +1,78 @@
+#include "thread_pool.hpp"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <string>
+
+namespace epi {
+
+//number of parallelFor jobs calling thread is running right now, nested loops can only come from callbacks
+static thread_local size_t t_loop_depth = 0;
+
+bool ThreadPool::isInsideLoop() {
+    return t_loop_depth != 0;
+}
+ThreadPool::ThreadPool(size_t thread_count) {
+    if(thread_count == 0)
+        thread_count = std::max<size_t>(1, std::thread::hardware_concurrency());
+    for(size_t i = 1; i < thread_count; i++)
+        _workers.emplace_back(&ThreadPool::m_work, this, i);
+}
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _isStopping = true;
+    }
+    _wake.notify_all();
+    for(auto& w : _workers)
+        w.join();
+}
+void ThreadPool::m_runJob(const std::function<void(size_t)>& job, size_t size) {
+    t_loop_depth++;
+    //indices are handed out one by one, so that uneven items balance themselves
+    for(size_t i = _next_index.fetch_add(1, std::memory_order_relaxed); i < size; i = _next_index.fetch_add(1, std::memory_order_relaxed))
+        job(i);
+    t_loop_depth--;
+}
+void ThreadPool::m_work(size_t worker_idx) {
+    EPI_PROFILE_THREAD("worker " + std::to_string(worker_idx));
+    uint64_t seen_generation = 0;
+    std::unique_lock<std::mutex> lock(_mutex);
+    while(true) {
+        _wake.wait(lock, [&]() { return _isStopping || _generation != seen_generation; });
+        if(_isStopping)
+            return;
+        seen_generation = _generation;
+        auto job = _job;
+        auto size = _job_size;
+        lock.unlock();
+        m_runJob(*job, size);
+        lock.lock();
+        if(--_busy == 0)
+            _done.notify_one();
+    }
+}
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& func) {
+    if(_workers.size() == 0 || count <= 1) {
+        t_loop_depth++;
+        for(size_t i = 0; i < count; i++)
+            func(i);
+        t_loop_depth--;
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _job = &func;
+        _job_size = count;
+        _next_index.store(0, std::memory_order_relaxed);
+        _busy = _workers.size();
+        _generation++;
+    }
+    _wake.notify_all();
+    m_runJob(func, count);
+    std::unique_lock<std::mutex> lock(_mutex);
+    _done.wait(lock, [&]() { return _busy == 0; });
+    _job = nullptr;
+}
+
+}
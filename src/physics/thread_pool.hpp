@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace epi {
+
+/*
+* \brief fixed set of worker threads used to split independent work into parallel loops
+* calling thread takes part in every loop, so pool of size 1 has no workers and runs everything inline
+* parallelFor can be called from one thread at a time
+*/
+class ThreadPool {
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _done;
+    const std::function<void(size_t)>* _job = nullptr;
+    size_t _job_size = 0;
+    std::atomic<size_t> _next_index{0};
+    //workers that did not finish current job yet
+    size_t _busy = 0;
+    uint64_t _generation = 0;
+    bool _isStopping = false;
+
+    void m_work(size_t worker_idx);
+    void m_runJob(const std::function<void(size_t)>& job, size_t size);
+public:
+    //number of threads taking part in a loop, including the calling one
+    size_t size() const {
+        return _workers.size() + 1;
+    }
+    //calls func(i) for every i lower than count, spread between all threads, returns after every call finished
+    void parallelFor(size_t count, const std::function<void(size_t)>& func);
+    //true when called from inside of func of any pool's parallelFor, where splitting work further would oversubscribe the machine
+    static bool isInsideLoop();
+
+    //thread_count includes calling thread, 0 uses one thread per hardware thread
+    explicit ThreadPool(size_t thread_count = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+};
+
+}
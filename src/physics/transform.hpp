@@ -1,12 +1,8 @@
 #pragma once
-#include "SFML/Graphics/PrimitiveType.hpp"
-#include "SFML/System/Vector2.hpp"
 #include "types.hpp"
 
 namespace epi {
 
-typedef sf::Vector2f vec2f;
-
 struct TransformEvent {
     bool isPosChanged;
     bool isRotChanged;
@@ -16,6 +12,8 @@ class Transform : public Signal::Subject<TransformEvent> {
     vec2f _pos;
     vec2f _scale;
     float _rot;
+    //cosine and sine of _rot, recalculated only when rotation changes
+    Rotation _rotation;
 public:
     vec2f getPos() const  {
         return this->_pos;
@@ -36,8 +34,12 @@ public:
     float getRot() const {
         return _rot;
     }
+    Rotation getRotation() const {
+        return _rotation;
+    }
     void setRot(float r) {
         _rot = r;
+        _rotation = Rotation(r);
         notify({false, true, false});
     }
     Transform() : _pos(0, 0), _scale(1.f, 1.f), _rot(0.f) {
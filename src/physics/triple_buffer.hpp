@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace epi {
+
+/*
+* \brief lock-free exchange of whole values between one writer and one reader thread
+* writer fills its own buffer and publishes it, reader takes the newest published one,
+* neither of them ever waits and values published in between are skipped
+*/
+template<class T>
+class TripleBuffer {
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    //set while the middle buffer holds a value the reader did not take yet
+    static constexpr uint8_t FRESH_BIT = 0x4;
+
+    T _buffers[3];
+    uint8_t _write = 0;
+    std::atomic<uint8_t> _middle{1};
+    uint8_t _read = 2;
+public:
+    //buffer owned by the writer, can be filled in place (and keeps allocations of values it had before)
+    T& getWriteBuffer() {
+        return _buffers[_write];
+    }
+    //makes write buffer the newest value, writer gets back the one reader is not using
+    void publish() {
+        _write = _middle.exchange(_write | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+    //takes newest published value if there is one, returns false if read buffer is already the newest
+    bool acquire() {
+        if(!(_middle.load(std::memory_order_relaxed) & FRESH_BIT))
+            return false;
+        _read = _middle.exchange(_read, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    const T& getReadBuffer() const {
+        return _buffers[_read];
+    }
+};
+
+}
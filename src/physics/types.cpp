@@ -0,0 +1,152 @@
+#include "types.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <math.h>
+#include <numeric>
+#include <vector>
+namespace epi {
+#if EPI_DETERMINISTIC
+//angle is reduced to [-pi/4, pi/4] in double precision and both series are summed in fixed order
+static void detSinCos(float angle, double& s, double& c) {
+    static const double half_pi = 1.57079632679489661923;
+    double x = angle;
+    if(!std::isfinite(x)) {
+        s = c = NAN;
+        return;
+    }
+    double quadrant = std::floor(x / half_pi + 0.5);
+    x -= quadrant * half_pi;
+    double x2 = x * x;
+    double sx = x * (1.0 + x2 * (-1.0 / 6.0 + x2 * (1.0 / 120.0 + x2 * (-1.0 / 5040.0 + x2 * (1.0 / 362880.0
+        + x2 * (-1.0 / 39916800.0 + x2 * (1.0 / 6227020800.0)))))));
+    double cx = 1.0 + x2 * (-1.0 / 2.0 + x2 * (1.0 / 24.0 + x2 * (-1.0 / 720.0 + x2 * (1.0 / 40320.0
+        + x2 * (-1.0 / 3628800.0 + x2 * (1.0 / 479001600.0 + x2 * (-1.0 / 87178291200.0)))))));
+    switch((int64_t)(quadrant - 4.0 * std::floor(quadrant / 4.0))) {
+        case 0: s = sx; c = cx; break;
+        case 1: s = cx; c = -sx; break;
+        case 2: s = -sx; c = -cx; break;
+        default: s = -cx; c = sx; break;
+    }
+}
+float fsin(float angle) {
+    double s, c;
+    detSinCos(angle, s, c);
+    return (float)s;
+}
+float fcos(float angle) {
+    double s, c;
+    detSinCos(angle, s, c);
+    return (float)c;
+}
+float fatan2(float y, float x) {
+    static const double pi = 3.14159265358979323846;
+    static const double tan_pi_12 = 0.26794919243112270647;
+    static const double inv_sqrt3 = 0.57735026918962576451;
+    if(x == 0.f && y == 0.f)
+        return std::signbit(x) ? (float)std::copysign(pi, (double)y) : y;
+    double ax = std::fabs((double)x);
+    double ay = std::fabs((double)y);
+    bool isSwapped = ay > ax;
+    double t = isSwapped ? ax / ay : ay / ax;
+    //t in [0, 1] is brought to [-tan(pi/12), tan(pi/12)] with atan(t) = pi/6 + atan((t - 1/sqrt3) / (1 + t/sqrt3))
+    double offset = 0.0;
+    if(t > tan_pi_12) {
+        t = (t - inv_sqrt3) / (1.0 + t * inv_sqrt3);
+        offset = pi / 6.0;
+    }
+    double t2 = t * t;
+    double sum = 0.0;
+    for(int k = 21; k >= 1; k -= 2)
+        sum = sum * t2 + ((k / 2) % 2 == 0 ? 1.0 : -1.0) / (double)k;
+    double result = offset + t * sum;
+    if(isSwapped)
+        result = pi / 2.0 - result;
+    if(x < 0.f)
+        result = pi - result;
+    return (float)std::copysign(result, (double)y);
+}
+#else
+float fsin(float angle) {
+    return std::sin(angle);
+}
+float fcos(float angle) {
+    return std::cos(angle);
+}
+float fatan2(float y, float x) {
+    return std::atan2(y, x);
+}
+#endif
+AABB AABB::CreateFromCircle(const Circle& c) {
+    return AABB::CreateMinMax(c.pos - vec2f(c.radius, c.radius), c.pos + vec2f(c.radius, c.radius));
+}
+AABB AABB::CreateFromPolygon(const Polygon& p) {
+    vec2f min = {INFINITY, INFINITY};
+    vec2f max = {-INFINITY, -INFINITY};
+    for(auto& v : p.getVertecies()) {
+        min.x = std::min(min.x, v.x);
+        min.y = std::min(min.y, v.y);
+        max.x = std::max(max.x, v.x);
+        max.y = std::max(max.y, v.y);
+    }
+    return AABB::CreateMinMax(min, max);
+}
+AABB AABB::CreateMinMax(vec2f min, vec2f max) {
+    AABB a;
+    a.min = min;
+    a.max = max;
+    return a;
+}
+AABB AABB::CreateCenterSize(vec2f center, vec2f size) {
+    AABB a;
+    a.setCenter(center);
+    a.setSize(size);
+    return a;
+}
+AABB AABB::CreateMinSize(vec2f min, vec2f size) {
+    AABB a;
+    a.min = min;
+    a.max = a.min + size;
+    return a;
+}
+Ray Ray::CreatePoints(vec2f a, vec2f b) {
+    Ray r;
+    r.pos = a;
+    r.dir = b - a;
+    return r;
+}
+Ray Ray::CreatePositionDirection(vec2f p, vec2f d) {
+    Ray r;
+    r.pos = p;
+    r.dir = d;
+    return r;
+}
+Polygon Polygon::CreateRegular(vec2f pos, float rot, size_t count, float dist) {
+    std::vector<vec2f> model;
+    for(size_t i = 0; i < count; i++) {
+        model.push_back(vec2f(fsin(3.141f * 2.f * ((float)i / (float)count)), fcos(3.141f * 2.f * ((float)i / (float)count))) * dist );
+    }
+    return Polygon(pos, rot, model);
+}
+Polygon Polygon::CreateFromPoints(std::vector<vec2f> verticies) {
+    vec2f avg = std::reduce(verticies.begin(), verticies.end()) / (float)verticies.size();
+    for(auto& v : verticies)
+        v -= avg;
+    return Polygon(avg, 0.f, verticies);
+}
+Polygon Polygon::CreateFromModel(vec2f pos, float rot, const std::vector<vec2f>& model) {
+    Polygon result;
+    result.points.resize(model.size());
+    result.model = model;
+    result.rotation = rot;
+    result.rotation_cs = Rotation(rot);
+    result.pos = pos;
+    result.m_updatePoints();
+    return result;
+}
+Polygon Polygon::CreateFromAABB(const AABB& aabb) {
+    std::vector<vec2f> points = {aabb.min, vec2f(aabb.min.x, aabb.max.y), aabb.max, vec2f(aabb.max.x, aabb.min.y)};
+    return Polygon::CreateFromPoints(points);
+}
+
+}
@@ -1,51 +1,22 @@
 #pragma once
+#include <algorithm>
+#include <cassert>
 #include <cmath>
 #include <iostream>
+#include <iterator>
 #include <math.h>
+#include <string>
 #include <vector>
 #include <set>
 
-#include "SFML/Graphics/RenderTarget.hpp"
-#include "SFML/Graphics/RenderWindow.hpp"
-#include "imgui.h"
-#include "imgui-SFML.h"
-
-#include "SFML/Graphics.hpp"
+#include "vec2.hpp"
+#include "vec_math.hpp"
 
 namespace epi {
 
 #define EPI_PI 3.14159265358979323846264338327950288   /* pi */
 #define fEPI_PI 3.141592653f   /* pi */
 
-typedef sf::Vector2f vec2f;
-typedef sf::Vector2i vec2i;
-typedef sf::Color Color;
-typedef sf::RenderWindow Window;
-
-namespace PastelColor {
-    const Color bg =     Color(0xa89984ff);
-    const Color bg1 =    Color(0xa89984ff);
-    const Color bg2 =    Color(0xbdae93ff);
-    const Color bg3 =    Color(0xebdbb2ff);
-    const Color bg4 =    Color(0x1e3a4cff);
-    const Color Red =    Color(0x9d0006ff);
-    const Color Green =  Color(0x79740eff);
-    const Color Yellow = Color(0xb57614ff);
-    const Color Blue =   Color(0x076678ff);
-    const Color Purple = Color(0x8f3f71ff);
-    const Color Aqua =   Color(0x427b58ff);
-    const Color Orange = Color(0xaf3a03ff);
-    const Color Gray =   Color(0x928374ff);
-};
-
-float len(vec2f);
-vec2f norm(vec2f);
-float qlen(vec2f);
-float dot(vec2f, vec2f);
-vec2f proj(vec2f, vec2f);
-float cross(vec2f, vec2f);
-vec2f sign(vec2f);
-
 struct Circle;
 class Polygon;
 
@@ -94,10 +65,6 @@ struct AABB {
         min = t - s / 2.f;
         max = t + s / 2.f;
     }
-    friend void draw(sf::RenderWindow& rw, const AABB& aabb, Color clr);
-    friend void drawFill(sf::RenderTarget& rw, const AABB& aabb, Color clr);
-    friend void drawOutline(sf::RenderTarget& rw, const AABB& aabb, Color clr);
-
     static AABB CreateMinMax(vec2f min, vec2f max);
     static AABB CreateCenterSize(vec2f center, vec2f size);
     static AABB CreateMinSize(vec2f min, vec2f size);
@@ -125,15 +92,12 @@ class Polygon {
     std::vector<vec2f> points;
     std::vector<vec2f> model;
     float rotation;
+    //cosine and sine of rotation, so that moving or scaling polygon does not need trigonometry
+    Rotation rotation_cs;
     vec2f pos;
     vec2f scale = {1, 1};
     void m_updatePoints() {
-        for(size_t i = 0; i < model.size(); i++) {
-            const auto& t = model[i];
-            points[i].x = (t.x * cosf(rotation) - t.y * sinf(rotation)) * scale.x;
-            points[i].y = (t.x * sinf(rotation) + t.y * cosf(rotation)) * scale.y;
-            points[i] += pos;
-        }
+        transformPoints(model.data(), model.size(), rotation_cs, scale, pos, points.data());
     }
     void m_avgPoints() {
         vec2f avg = vec2f(0, 0);
@@ -149,8 +113,12 @@ public:
     float getRot() const {
         return rotation;
     }
+    Rotation getRotation() const {
+        return rotation_cs;
+    }
     void setRot(float r) {
         rotation = r;
+        rotation_cs = Rotation(r);
         m_updatePoints();
     }
     vec2f getPos() const {
@@ -173,13 +141,27 @@ public:
     const std::vector<vec2f>& getModelVertecies() const {
         return model;
     }
+    //replaces model and placement at once, reusing memory so that polygons kept as scratch space do not allocate
+    void setModel(const std::vector<vec2f>& model_, vec2f pos_, float rot_, vec2f scale_) {
+        setModel(model_, pos_, rot_, Rotation(rot_), scale_);
+    }
+    //same as above, with cosine and sine of rot_ already known e.g. from Transform::getRotation
+    void setModel(const std::vector<vec2f>& model_, vec2f pos_, float rot_, Rotation rotation_, vec2f scale_) {
+        model.assign(model_.begin(), model_.end());
+        points.resize(model.size());
+        pos = pos_;
+        rotation = rot_;
+        rotation_cs = rotation_;
+        scale = scale_;
+        m_updatePoints();
+    }
     Polygon() {}
-    Polygon(vec2f pos_, float rot_, const std::vector<vec2f>& model_) : points(model_.size(), vec2f(0, 0)), model(model_), rotation(rot_), pos(pos_) {
+    Polygon(vec2f pos_, float rot_, const std::vector<vec2f>& model_) : points(model_.size(), vec2f(0, 0)), model(model_), rotation(rot_), rotation_cs(rot_), pos(pos_) {
         std::sort(model.begin(), model.end(), [](vec2f a, vec2f b) {
-                      auto anga = std::atan2(a.x, a.y);
+                      auto anga = fatan2(a.x, a.y);
                       if (anga > fEPI_PI)        { anga -= 2.f * fEPI_PI; }
                       else if (anga <= -fEPI_PI) { anga += 2.f * fEPI_PI; }
-                      auto angb = std::atan2(b.x, b.y);
+                      auto angb = fatan2(b.x, b.y);
                       if (angb > fEPI_PI)        { angb -= 2.f * fEPI_PI ; }
                       else if (angb <= -fEPI_PI) { angb += 2.f * fEPI_PI; }
 
@@ -191,15 +173,16 @@ public:
 
     static Polygon CreateRegular(vec2f pos, float rot, size_t count, float dist);
     static Polygon CreateFromAABB(const AABB& aabb);
+    //points are sorted around their average, so they have to outline a convex polygon, concave ones can be split by Compound::CreateFromOutline
     static Polygon CreateFromPoints(std::vector<vec2f> verticies);
-
-    friend void draw(sf::RenderWindow& rw, const Polygon& poly, Color clr);
-    friend void drawFill(sf::RenderTarget& rw, const Polygon& poly, Color clr);
-    friend void drawOutline(sf::RenderTarget& rw, const Polygon& poly, Color clr);
+    //uses model vertices of other polygon as they are, without sorting and centering them again
+    static Polygon CreateFromModel(vec2f pos, float rot, const std::vector<vec2f>& model);
 };
 
 
-vec2f operator* (vec2f a, vec2f b);
+inline vec2f operator* (vec2f a, vec2f b) {
+    return vec2f(a.x * b.x, a.y * b.y);
+}
 class Tag {
     std::set<std::string> _tags;
 public:
@@ -223,6 +206,10 @@ public:
         set_intersection(_tags.begin(), _tags.end(), t._tags.begin(), t._tags.end(), std::back_inserter(common_data));
         return common_data.size() != 0;
     }
+    //true if both hold exactly the same tags, unlike == which only needs one in common
+    inline bool isSame(const Tag& t) const {
+        return _tags == t._tags;
+    }
     inline bool operator!=(const char* t) const {
         return !(*this == t);
     }
@@ -0,0 +1,103 @@
+#pragma once
+#include <cmath>
+
+namespace epi {
+
+/*
+* \brief plain 2d vector used by the physics core, it does not depend on any graphics library
+* conversions to and from other vector types (like sf::Vector2f) should be done by the user
+*/
+template<class T>
+struct vec2 {
+    T x;
+    T y;
+
+    constexpr vec2() : x(0), y(0) {}
+    constexpr vec2(T x_, T y_) : x(x_), y(y_) {}
+    template<class U>
+    constexpr explicit vec2(const vec2<U>& other) : x(static_cast<T>(other.x)), y(static_cast<T>(other.y)) {}
+
+    constexpr vec2& operator+=(const vec2& other) {
+        x += other.x;
+        y += other.y;
+        return *this;
+    }
+    constexpr vec2& operator-=(const vec2& other) {
+        x -= other.x;
+        y -= other.y;
+        return *this;
+    }
+    constexpr vec2& operator*=(T s) {
+        x *= s;
+        y *= s;
+        return *this;
+    }
+    constexpr vec2& operator/=(T s) {
+        x /= s;
+        y /= s;
+        return *this;
+    }
+    constexpr vec2 operator-() const {
+        return vec2(-x, -y);
+    }
+    constexpr bool operator==(const vec2& other) const {
+        return x == other.x && y == other.y;
+    }
+    constexpr bool operator!=(const vec2& other) const {
+        return !(*this == other);
+    }
+};
+template<class T>
+constexpr vec2<T> operator+(vec2<T> a, const vec2<T>& b) {
+    return a += b;
+}
+template<class T>
+constexpr vec2<T> operator-(vec2<T> a, const vec2<T>& b) {
+    return a -= b;
+}
+template<class T>
+constexpr vec2<T> operator*(vec2<T> a, T s) {
+    return a *= s;
+}
+template<class T>
+constexpr vec2<T> operator*(T s, vec2<T> a) {
+    return a *= s;
+}
+template<class T>
+constexpr vec2<T> operator/(vec2<T> a, T s) {
+    return a /= s;
+}
+
+typedef vec2<float> vec2f;
+typedef vec2<int> vec2i;
+
+//defined here, so that every call in hot loops can be inlined
+constexpr float dot(vec2f a, vec2f b) {
+    return a.x * b.x + a.y * b.y;
+}
+constexpr float cross(vec2f a, vec2f b) {
+    return a.x * b.y - b.x * a.y;
+}
+constexpr float qlen(vec2f v) {
+    return v.x * v.x + v.y * v.y;
+}
+inline float len(vec2f v) {
+    return std::sqrt(v.x * v.x + v.y * v.y);
+}
+//unit vector in direction of v, zero vector is returned as it is
+inline vec2f norm(vec2f v) {
+    float l = len(v);
+    if(l == 0.f) {
+        return v;
+    }
+    return v / l;
+}
+//projection of a onto plane_norm
+constexpr vec2f proj(vec2f a, vec2f plane_norm) {
+    return (dot(a, plane_norm) / dot(plane_norm, plane_norm)) * plane_norm;
+}
+inline vec2f sign(vec2f x) {
+    return { std::copysign(1.f, x.x), std::copysign(1.f, x.y) };
+}
+
+}
@@ -0,0 +1,180 @@
+#pragma once
+#include "vec2.hpp"
+
+#include <algorithm>
+#include <cstddef>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EPI_SSE2 1
+#else
+#define EPI_SSE2 0
+#endif
+
+//set by the build, when enabled simulation gives bit exact results on every machine at some cost in speed
+#ifndef EPI_DETERMINISTIC
+#define EPI_DETERMINISTIC 0
+#endif
+
+namespace epi {
+
+/*
+* trigonometry used by the simulation, calls the standard library unless built with EPI_DETERMINISTIC
+* in that case results are computed with basic arithmetic only, so they are the same with every libm
+*/
+float fsin(float angle);
+float fcos(float angle);
+float fatan2(float y, float x);
+
+/*
+* \brief rotation kept as cosine and sine of its angle, so that rotating a vector is only multiplication and addition
+* products are summed in the same order as in scalar and batch functions below, so all of them give equal results
+*/
+struct Rotation {
+    float c = 1.f;
+    float s = 0.f;
+
+    constexpr vec2f rotate(vec2f v) const {
+        return vec2f(c * v.x - s * v.y, s * v.x + c * v.y);
+    }
+    //rotates by the opposite angle
+    constexpr vec2f inverseRotate(vec2f v) const {
+        return vec2f(c * v.x + s * v.y, c * v.y - s * v.x);
+    }
+    constexpr Rotation inverse() const {
+        return Rotation(c, -s);
+    }
+    constexpr Rotation() {}
+    constexpr Rotation(float cos_, float sin_) : c(cos_), s(sin_) {}
+    explicit Rotation(float angle) : c(fcos(angle)), s(fsin(angle)) {}
+};
+//rotation by sum of both angles, equal to b when a is the identity
+constexpr Rotation operator*(Rotation a, Rotation b) {
+    return Rotation(a.c * b.c - a.s * b.s, a.s * b.c + a.c * b.s);
+}
+
+/*
+* batch operations on arrays of points, vectorised with SSE2 or AVX when the build enables them
+* every lane does exactly the same operations in the same order as scalar code, so results do not depend on the path taken
+* as long as the compiler does not fuse scalar multiply-add, which EPI_DETERMINISTIC builds disable
+*/
+static_assert(sizeof(vec2f) == 2 * sizeof(float), "batch math reads vec2f arrays as arrays of floats");
+
+#if EPI_SSE2
+//dot products of 4 consecutive points with axis given as (x, y, x, y)
+inline __m128 dot4SSE(const vec2f* points, __m128 axis) {
+    __m128 p01 = _mm_mul_ps(_mm_loadu_ps(&points[0].x), axis);
+    __m128 p23 = _mm_mul_ps(_mm_loadu_ps(&points[2].x), axis);
+    __m128 xs = _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 ys = _mm_shuffle_ps(p01, p23, _MM_SHUFFLE(3, 1, 3, 1));
+    return _mm_add_ps(xs, ys);
+}
+#endif
+//dot products of 4 consecutive points with axis
+inline void dot4(const vec2f* points, vec2f axis, float* result) {
+#if EPI_SSE2
+    _mm_storeu_ps(result, dot4SSE(points, _mm_setr_ps(axis.x, axis.y, axis.x, axis.y)));
+#else
+    for(size_t i = 0; i < 4; i++)
+        result[i] = points[i].x * axis.x + points[i].y * axis.y;
+#endif
+}
+//smallest and largest dot product of points with axis, count has to be at least 1
+inline void projectPoints(const vec2f* points, size_t count, vec2f axis, float& min, float& max) {
+    size_t i = 0;
+#if EPI_SSE2
+    if(count >= 4) {
+        __m128 a = _mm_setr_ps(axis.x, axis.y, axis.x, axis.y);
+        __m128 mn = dot4SSE(points, a);
+        __m128 mx = mn;
+        for(i = 4; i + 4 <= count; i += 4) {
+            __m128 d = dot4SSE(points + i, a);
+            mn = _mm_min_ps(mn, d);
+            mx = _mm_max_ps(mx, d);
+        }
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, mn);
+        min = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+        _mm_store_ps(lanes, mx);
+        max = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+    }else
+#endif
+    {
+        min = max = points[0].x * axis.x + points[0].y * axis.y;
+        i = 1;
+    }
+    for(; i < count; i++) {
+        float q = points[i].x * axis.x + points[i].y * axis.y;
+        min = std::min(min, q);
+        max = std::max(max, q);
+    }
+}
+//rotates count points, in and out can be the same array
+inline void rotateN(const vec2f* in, size_t count, Rotation rot, vec2f* out) {
+    size_t i = 0;
+#if defined(__AVX__)
+    {
+        __m256 c = _mm256_set1_ps(rot.c);
+        __m256 s = _mm256_setr_ps(-rot.s, rot.s, -rot.s, rot.s, -rot.s, rot.s, -rot.s, rot.s);
+        for(; i + 4 <= count; i += 4) {
+            __m256 v = _mm256_loadu_ps(&in[i].x);
+            __m256 swapped = _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1));
+            _mm256_storeu_ps(&out[i].x, _mm256_add_ps(_mm256_mul_ps(v, c), _mm256_mul_ps(swapped, s)));
+        }
+    }
+#endif
+#if EPI_SSE2
+    {
+        __m128 c = _mm_set1_ps(rot.c);
+        __m128 s = _mm_setr_ps(-rot.s, rot.s, -rot.s, rot.s);
+        for(; i + 2 <= count; i += 2) {
+            __m128 v = _mm_loadu_ps(&in[i].x);
+            __m128 swapped = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+            _mm_storeu_ps(&out[i].x, _mm_add_ps(_mm_mul_ps(v, c), _mm_mul_ps(swapped, s)));
+        }
+    }
+#endif
+    for(; i < count; i++)
+        out[i] = rot.rotate(in[i]);
+}
+//rotates count points, then scales them and moves them by pos, the same way Polygon places its model
+inline void transformPoints(const vec2f* in, size_t count, Rotation rot, vec2f scale, vec2f pos, vec2f* out) {
+    size_t i = 0;
+#if defined(__AVX__)
+    {
+        __m256 c = _mm256_set1_ps(rot.c);
+        __m256 s = _mm256_setr_ps(-rot.s, rot.s, -rot.s, rot.s, -rot.s, rot.s, -rot.s, rot.s);
+        __m256 sc = _mm256_setr_ps(scale.x, scale.y, scale.x, scale.y, scale.x, scale.y, scale.x, scale.y);
+        __m256 p = _mm256_setr_ps(pos.x, pos.y, pos.x, pos.y, pos.x, pos.y, pos.x, pos.y);
+        for(; i + 4 <= count; i += 4) {
+            __m256 v = _mm256_loadu_ps(&in[i].x);
+            __m256 swapped = _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1));
+            __m256 r = _mm256_add_ps(_mm256_mul_ps(v, c), _mm256_mul_ps(swapped, s));
+            _mm256_storeu_ps(&out[i].x, _mm256_add_ps(_mm256_mul_ps(r, sc), p));
+        }
+    }
+#endif
+#if EPI_SSE2
+    {
+        __m128 c = _mm_set1_ps(rot.c);
+        __m128 s = _mm_setr_ps(-rot.s, rot.s, -rot.s, rot.s);
+        __m128 sc = _mm_setr_ps(scale.x, scale.y, scale.x, scale.y);
+        __m128 p = _mm_setr_ps(pos.x, pos.y, pos.x, pos.y);
+        for(; i + 2 <= count; i += 2) {
+            __m128 v = _mm_loadu_ps(&in[i].x);
+            __m128 swapped = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+            __m128 r = _mm_add_ps(_mm_mul_ps(v, c), _mm_mul_ps(swapped, s));
+            _mm_storeu_ps(&out[i].x, _mm_add_ps(_mm_mul_ps(r, sc), p));
+        }
+    }
+#endif
+    for(; i < count; i++) {
+        vec2f r = rot.rotate(in[i]);
+        out[i] = vec2f(r.x * scale.x + pos.x, r.y * scale.y + pos.y);
+    }
+}
+
+}
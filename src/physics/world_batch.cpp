@@ -0,0 +1,44 @@
+#include "world_batch.hpp"
+#include "profiler.hpp"
+
+namespace epi {
+
+bool WorldBatch::create(std::vector<char> scene, size_t count, std::string* error) {
+    _worlds.clear();
+    _scene = std::move(scene);
+    //validated once up front, so that creating worlds can not fail half way through
+    World probe;
+    probe.scene = loadSnapshot(_scene.data(), _scene.size(), probe.manager, error);
+    if(!probe.scene) {
+        _scene.clear();
+        return false;
+    }
+    _worlds.resize(count);
+    reset();
+    return true;
+}
+bool WorldBatch::create(const PhysicsManager& manager, size_t count, std::string* error) {
+    std::vector<char> scene;
+    saveSnapshot(manager, scene);
+    return create(std::move(scene), count, error);
+}
+void WorldBatch::reset() {
+    EPI_PROFILE_FUNCTION();
+    _pool.parallelFor(_worlds.size(), [&](size_t i) {
+        auto world = std::make_unique<World>();
+        world->scene = loadSnapshot(_scene.data(), _scene.size(), world->manager);
+        _worlds[i] = std::move(world);
+    });
+}
+void WorldBatch::step(float delT, size_t updates) {
+    EPI_PROFILE_FUNCTION();
+    _pool.parallelFor(_worlds.size(), [&](size_t i) {
+        for(size_t u = 0; u < updates; u++)
+            _worlds[i]->manager.update(delT);
+    });
+}
+void WorldBatch::forEach(const std::function<void(size_t, World&)>& func) {
+    _pool.parallelFor(_worlds.size(), [&](size_t i) { func(i, *_worlds[i]); });
+}
+
+}
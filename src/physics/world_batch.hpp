@@ -0,0 +1,73 @@
+#pragma once
+#include "physics_manager.hpp"
+#include "snapshot.hpp"
+#include "thread_pool.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace epi {
+
+/*
+* \brief owns many independent worlds created from one scene and steps them concurrently on a thread pool
+* scene is a snapshot image (see saveSnapshot) kept once by the batch and only read when worlds are created,
+* so variations of the scene can be set up per world with forEach and read back with collect
+* worlds never share mutable state, so one world is always updated by a single thread at a time
+*/
+class WorldBatch {
+public:
+    struct World {
+        //bodies and restraints created from the scene, owned by the world
+        //declared before manager, so that they outlive their membership in it
+        std::unique_ptr<SnapshotWorld> scene;
+        PhysicsManager manager;
+
+        World() : manager(AABB::CreateMinMax({0, 0}, {1, 1})) {}
+    };
+private:
+    std::vector<char> _scene;
+    std::vector<std::unique_ptr<World>> _worlds;
+    ThreadPool _pool;
+public:
+    /*
+    * replaces all worlds with count fresh copies of scene, worlds are created in parallel
+    * returns false and fills error (if given) when scene is not a valid snapshot, leaving the batch empty
+    */
+    bool create(std::vector<char> scene, size_t count, std::string* error = nullptr);
+    //same as above but scene is taken from current state of manager
+    bool create(const PhysicsManager& manager, size_t count, std::string* error = nullptr);
+    //recreates every world from the scene, dropping all changes made to them
+    void reset();
+
+    size_t size() const {
+        return _worlds.size();
+    }
+    World& get(size_t idx) {
+        return *_worlds[idx];
+    }
+    size_t getThreadCount() const {
+        return _pool.size();
+    }
+
+    //advances every world by updates updates of delT, each world is stepped from start to end by one thread
+    void step(float delT, size_t updates = 1);
+    //calls func for every world in parallel, used to set up variations before stepping
+    void forEach(const std::function<void(size_t, World&)>& func);
+    //calls func for every world in parallel and returns its results in order of worlds
+    template<class Func, class T = std::invoke_result_t<Func, size_t, World&>>
+    std::vector<T> collect(Func func) {
+        static_assert(!std::is_same_v<T, bool>, "std::vector<bool> can not be written from many threads");
+        std::vector<T> result(_worlds.size());
+        _pool.parallelFor(_worlds.size(), [&](size_t i) { result[i] = func(i, *_worlds[i]); });
+        return result;
+    }
+
+    //thread_count includes calling thread, 0 uses one thread per hardware thread
+    explicit WorldBatch(size_t thread_count = 0) : _pool(thread_count) {}
+};
+
+}
@@ -6,6 +6,8 @@
 #include "types.hpp"
 #include "io_manager.hpp"
 #include "physics_manager.hpp"
+#include "physics_thread.hpp"
+#include "profiler.hpp"
 
 #include <cstddef>
 #include <exception>
@@ -50,6 +52,8 @@ class DefaultScene : public Scene {
 protected:
     AABB sim_window;
     PhysicsManager physics_manager;
+    //steps physics_manager in the background, started and stopped by the scene deriving from this one
+    PhysicsThread physics_thread{physics_manager};
 
     virtual void onUpdate(float delT) = 0;
     virtual void onRender(sf::RenderTarget &target) = 0;
@@ -57,14 +61,28 @@ protected:
     }
 public:
     void update(sf::Time delT) override {
-        io_manager.pollEvents();
-        ImGui::SFML::Update(io_manager.getWindow(), io_manager.getRenderObject(), delT);
+        EPI_PROFILE_FRAME();
+        {
+            EPI_PROFILE_SCOPE("events");
+            io_manager.pollEvents();
+            ImGui::SFML::Update(io_manager.getWindow(), io_manager.getRenderObject(), delT);
+        }
         auto delTsec = std::clamp(delT.asSeconds(), 0.f, 1.f);
-        onUpdate(delTsec);
-        onRender(io_manager.getRenderObject());
-        io_manager.display();
+        {
+            EPI_PROFILE_SCOPE("update");
+            onUpdate(delTsec);
+        }
+        {
+            EPI_PROFILE_SCOPE("rendering");
+            onRender(io_manager.getRenderObject());
+        }
+        {
+            EPI_PROFILE_SCOPE("display");
+            io_manager.display();
+        }
     }
     int setup() override { 
+        EPI_PROFILE_THREAD("main");
         onSetup();
         return 0; 
     }